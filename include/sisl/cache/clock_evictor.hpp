@@ -0,0 +1,111 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <boost/intrusive/list.hpp>
+#include <sisl/fds/utils.hpp>
+#include <sisl/cache/evictor.hpp>
+
+using namespace boost::intrusive;
+
+namespace sisl {
+
+/* CLOCK (second chance) evictor, a drop-in alternative to LRUEvictor for read heavy loads. A cache hit only sets the
+ * reference bit of the record, without taking any lock or touching the eviction list. Eviction sweeps the list from
+ * its head, which acts as the clock hand: a referenced record gets its bit cleared and is moved behind the hand, the
+ * first unreferenced record which can be evicted is evicted. */
+class ClockEvictor : public Evictor {
+public:
+    ClockEvictor(const int64_t max_size, const uint32_t num_partitions);
+    ClockEvictor(const ClockEvictor&) = delete;
+    ClockEvictor(ClockEvictor&&) noexcept = delete;
+    ClockEvictor& operator=(const ClockEvictor&) = delete;
+    ClockEvictor& operator=(ClockEvictor&&) noexcept = delete;
+    virtual ~ClockEvictor() = default;
+
+    bool add_record(uint64_t hash_code, CacheRecord& record) override;
+    void remove_record(uint64_t hash_code, CacheRecord& record) override;
+
+    /* Sets the reference bit of the record, so that the next sweep of the hand gives it a second chance. Lock free */
+    void record_accessed(uint64_t hash_code, CacheRecord& record) override;
+
+    void record_resized(uint64_t hash_code, const CacheRecord& record, uint32_t old_size) override;
+    bool record_replaced(uint64_t hash_code, CacheRecord& record, CacheRecord& new_record) override;
+    bool counts_accesses() const override { return true; }
+
+    // for testing purpose
+    int64_t filled_size() {
+        int64_t filled_size{0};
+        for (uint32_t i{0}; i < num_partitions(); ++i) {
+            filled_size += m_partitions[i].filled_size();
+        }
+        return filled_size;
+    }
+
+private:
+    typedef list<
+        ValueEntryBase,
+        member_hook< ValueEntryBase, list_member_hook< link_mode< auto_unlink > >, &ValueEntryBase::m_member_hook >,
+        constant_time_size< false > >
+        EvictRecordList;
+
+    class ClockPartition {
+    private:
+        EvictRecordList m_list; // Head of the list is where the hand points to
+        ClockEvictor* m_evictor;
+        std::mutex m_list_guard;
+        uint32_t m_partition_num;
+        int64_t m_filled_size{0};
+        int64_t m_max_size;
+        uint64_t m_count{0};
+
+    public:
+        ClockPartition() = default;
+        ClockPartition(const ClockPartition&) = delete;
+        ClockPartition& operator=(const ClockPartition&) = delete;
+        ClockPartition(ClockPartition&&) = default;
+        ClockPartition& operator=(ClockPartition&&) = default;
+
+        void init(ClockEvictor* evictor, const uint32_t partition_num, const uint64_t max_size) {
+            m_evictor = evictor;
+            m_partition_num = partition_num;
+            m_max_size = int64_cast(max_size);
+        }
+        bool add_record(CacheRecord& record);
+        void remove_record(CacheRecord& record);
+        void record_resized(const CacheRecord& record, uint32_t old_size);
+        void record_replaced(CacheRecord& record, CacheRecord& new_record);
+
+        // for testing purpose
+        int64_t filled_size() {
+            std::unique_lock guard{m_list_guard};
+            return m_filled_size;
+        }
+
+    private:
+        bool do_evict(const uint32_t record_fid, const uint32_t needed_size);
+        bool will_fill(const uint32_t new_size) const { return ((m_filled_size + new_size) > m_max_size); }
+        bool is_full() const { return (m_filled_size >= m_max_size); }
+    };
+
+private:
+    ClockPartition& get_partition(uint64_t hash_code) { return m_partitions[hash_code % num_partitions()]; }
+    std::unique_ptr< ClockPartition[] > m_partitions;
+};
+} // namespace sisl
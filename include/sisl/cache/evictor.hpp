@@ -63,8 +63,11 @@ public:
     }
 
     void unregister_record_family(const uint32_t record_type_id) {
-        std::unique_lock lk(m_reg_mtx);
-        m_eviction_cbs[record_type_id] = std::make_pair(false, RecordFamily{});
+        {
+            std::unique_lock lk(m_reg_mtx);
+            m_eviction_cbs[record_type_id] = std::make_pair(false, RecordFamily{});
+        }
+        record_family_unregistered(record_type_id);
     }
 
     void add_metrics(CacheMetrics* metrics) {
@@ -79,6 +82,31 @@ public:
     virtual void record_accessed(uint64_t hash_code, CacheRecord& record) = 0;
     virtual void record_resized(uint64_t hash_code, const CacheRecord& record, uint32_t old_size) = 0;
 
+    // new_record is a copy of record at another address, which takes over its place in the evictor, along with its
+    // size and access state. record is no longer tracked after this. Returns false if new_record could not be added,
+    // in which case it is treated like a record whose add_record() has failed. By default record is removed and
+    // new_record added afresh, which loses the position of record and could evict others, hence the evictors which can
+    // move record in place override it.
+    virtual bool record_replaced(uint64_t hash_code, CacheRecord& record, CacheRecord& new_record) {
+        remove_record(hash_code, record);
+        new_record.set_size(record.size());
+        new_record.set_record_family(record.record_family_id());
+        if (record.is_pinned()) { new_record.set_pinned(); }
+        return add_record(hash_code, new_record);
+    }
+
+    // Whether the evictor learns of the accesses only through the access count of the record (ValueEntryBase::
+    // record_access()), so that it sees the hits which are counted without calling record_accessed(), like the RCU
+    // reads of SimpleHashMap
+    virtual bool counts_accesses() const { return false; }
+
+    // Called once a cache has unregistered its record family and is about to free its records without removing them
+    virtual void record_family_unregistered(const uint32_t) {}
+
+    // Called before a record, for which add_record() has failed, is freed. The record could have been accessed while
+    // it was in the cache, so evictors which hold on to accessed records outside of the ones they track drop it here
+    virtual void record_add_failed(uint64_t, const CacheRecord&) {}
+
     int64_t max_size() const { return m_max_size; }
     uint32_t num_partitions() const { return m_num_partitions; }
     const eviction_cb_t& can_evict_cb(const uint32_t record_id) const { return m_eviction_cbs[record_id].second.can_evict_cb; }
@@ -16,6 +16,7 @@
  *********************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <boost/intrusive/list.hpp>
 #include <sisl/metrics/metrics.hpp> 
 
@@ -43,16 +44,29 @@ public:
     mutable list_member_hook< link_mode< auto_unlink > > m_member_hook;
     mutable cache_info m_u;
 
+    // Accesses since the evictor last looked at the record, for the evictors which don't reorder on access. It is kept
+    // outside cache_info, since the hits count it without any lock, concurrently with the evictor resetting it.
+    // LRUEvictor, which reorders on access, uses it with buffered access to mark the record as sitting in a read buffer.
+    mutable std::atomic< uint8_t > m_access_count{0};
+
+    // Opaque to everyone but the evictor, which accesses it under its partition lock, or when buffering a hit, only
+    // after it has marked the record as buffered through the access count
+    mutable uint32_t m_evictor_data{0};
+
 public:
     ValueEntryBase() = default;
     ValueEntryBase(const ValueEntryBase&) = delete;
     ValueEntryBase& operator=(const ValueEntryBase&) = delete;
     ValueEntryBase(ValueEntryBase&& other) {
         m_u = std::move(other.m_u);
+        m_access_count.store(other.m_access_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_evictor_data = other.m_evictor_data;
         m_member_hook.swap_nodes(other.m_member_hook);
     }
     ValueEntryBase& operator=(ValueEntryBase&& other) {
         m_u = std::move(other.m_u);
+        m_access_count.store(other.m_access_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_evictor_data = other.m_evictor_data;
         m_member_hook.swap_nodes(other.m_member_hook);
         return *this;
     }
@@ -61,12 +75,28 @@ public:
     void set_pinned() { m_u.set_pinned(true); }
     void set_unpinned() { m_u.set_pinned(false); }
     void set_record_family(const uint32_t record_fid) { m_u.record_family_id = record_fid; }
+    void record_access() const {
+        // Saturates at max_access_count(), which also avoids dirtying the cache line on every hit of a hot record
+        uint8_t count{m_access_count.load(std::memory_order_relaxed)};
+        while ((count < max_access_count()) &&
+               !m_access_count.compare_exchange_weak(count, count + 1, std::memory_order_relaxed)) {}
+    }
+    uint8_t access_count() const { return m_access_count.load(std::memory_order_relaxed); }
+    // Resets the access count and returns what it was
+    uint8_t reset_access_count() const { return m_access_count.exchange(0, std::memory_order_relaxed); }
+    // Only by the evictor, hits never decrement the count, so it can't go below 0
+    void decrement_access_count() const {
+        if (access_count() > 0) { m_access_count.fetch_sub(1, std::memory_order_relaxed); }
+    }
+    void set_evictor_data(const uint32_t data) const { m_evictor_data = data; }
+    uint32_t evictor_data() const { return m_evictor_data; }
 
     uint32_t size() const { return m_u.size; }
     bool is_pinned() const { return (m_u.pinned == 1); }
     uint32_t record_family_id() const { return m_u.record_family_id; }
 
     static constexpr size_t max_record_families() { return (1 << RECORD_FAMILY_ID_BITS); }
+    static constexpr uint8_t max_access_count() { return 3; }
 };
 #pragma pack()
 
@@ -0,0 +1,251 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <utility>
+#include <vector>
+#if defined __clang__ or defined __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Wattributes"
+#endif
+#include <folly/SharedMutex.h>
+#if defined __clang__ or defined __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+namespace sisl {
+
+/* Bucket array of SimpleHashMap and RangeHashMap, which grows with linear hashing instead of being sized once upfront.
+ *
+ * The table starts with n0 buckets. Whenever there are more than max_load() entries per bucket on average, the bucket
+ * at the split pointer is split: its entries which map to bucket (split + n0 * 2^level) with the doubled modulo are
+ * moved there and the split pointer advances. Once all the n0 * 2^level buckets of this level are split, the level
+ * goes up and the split pointer starts from 0 again. A split looks at one chain and holds only the locks of the two
+ * buckets involved, and the inserting thread does at most s_max_splits_per_op of them per entry it added, so the table
+ * grows in small steps along with the inserts and never stops the world.
+ *
+ * Buckets live in segments which double in size, so a bucket is never moved or freed until the table is destroyed.
+ * A split can move a key out of its bucket between computing the bucket address and locking it, so with_bucket()
+ * computes the address again after taking the lock and retries on a mismatch. Readers without the bucket lock (see
+ * read_unlocked()) instead check a sequence count which is odd while a split moves entries, like a seqlock.
+ *
+ * BucketT needs lock() returning its folly::SharedMutex, size() returning the chain length and split_to(to, moves_out)
+ * which moves the entries with moves_out(hash_code) == true to the empty bucket to. */
+template < typename BucketT >
+class LinearHashBuckets {
+private:
+    static constexpr uint32_t s_max_segments{33};
+    static constexpr uint32_t s_max_splits_per_op{2};
+    static constexpr uint64_t s_split_mask{0xFFFFFFFF};
+
+    const uint64_t m_initial_buckets;
+    std::array< std::atomic< BucketT* >, s_max_segments > m_segments; // Segment 0 has n0 buckets, segment k n0 << (k-1)
+    std::atomic< uint64_t > m_state{0};                               // level << 32 | split pointer
+    std::atomic< int64_t > m_nentries{0};
+    std::atomic< uint64_t > m_split_seq{0}; // Odd while a split is moving entries
+    std::mutex m_split_mtx;
+
+public:
+    explicit LinearHashBuckets(const uint32_t nbuckets) : m_initial_buckets{std::max(nbuckets, 1u)} {
+        for (auto& seg : m_segments) {
+            seg.store(nullptr, std::memory_order_relaxed);
+        }
+        m_segments[0].store(new BucketT[m_initial_buckets], std::memory_order_release);
+    }
+    LinearHashBuckets(const LinearHashBuckets&) = delete;
+    LinearHashBuckets& operator=(const LinearHashBuckets&) = delete;
+
+    ~LinearHashBuckets() {
+        for (auto& seg : m_segments) {
+            delete[] seg.load(std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr uint64_t max_load() { return 2; }
+
+    /// Locks the bucket of the given hash code with LockT (std::unique_lock or std::shared_lock) and calls fn(bucket)
+    template < template < typename > class LockT, typename Fn >
+    auto with_bucket(const uint64_t hash_code, Fn&& fn) const {
+        while (true) {
+            const uint64_t idx{address(hash_code, m_state.load(std::memory_order_acquire))};
+            BucketT& b{bucket(idx)};
+            LockT< folly::SharedMutex > holder{b.lock()};
+            if (address(hash_code, m_state.load(std::memory_order_acquire)) == idx) { return fn(b); }
+        }
+    }
+
+    /// Same as with_bucket() with an exclusive lock, but returns false without calling fn if the lock is busy
+    template < typename Fn >
+    bool try_with_bucket(const uint64_t hash_code, Fn&& fn) const {
+        while (true) {
+            const uint64_t idx{address(hash_code, m_state.load(std::memory_order_acquire))};
+            BucketT& b{bucket(idx)};
+            std::unique_lock< folly::SharedMutex > holder{b.lock(), std::try_to_lock};
+            if (!holder.owns_lock()) { return false; }
+            if (address(hash_code, m_state.load(std::memory_order_acquire)) == idx) { return fn(b); }
+        }
+    }
+
+    /// Batched with_bucket(), calling fn(bucket, i) for every hash_codes[i]. The hash codes are grouped by bucket, so
+    /// that each bucket is locked once for all of its hash codes, and the buckets are prefetched before the first lock.
+    /// Only one bucket is locked at a time.
+    template < template < typename > class LockT, typename Fn >
+    void with_buckets(const std::span< const uint64_t > hash_codes, Fn&& fn) const {
+        std::vector< std::pair< uint64_t, uint32_t > > order; // Bucket index, position in hash_codes
+        order.reserve(hash_codes.size());
+        const uint64_t state{m_state.load(std::memory_order_acquire)};
+        for (uint32_t i{0}; i < hash_codes.size(); ++i) {
+            const uint64_t idx{address(hash_codes[i], state)};
+            __builtin_prefetch(&bucket(idx));
+            order.emplace_back(idx, i);
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector< uint32_t > moved;
+        for (size_t start{0}, end{0}; start < order.size(); start = end) {
+            const uint64_t idx{order[start].first};
+            while ((end < order.size()) && (order[end].first == idx)) {
+                ++end;
+            }
+
+            BucketT& b{bucket(idx)};
+            LockT< folly::SharedMutex > holder{b.lock()};
+            // A split since the grouping could have moved some of the hash codes to another bucket
+            const uint64_t cur_state{m_state.load(std::memory_order_acquire)};
+            for (size_t j{start}; j < end; ++j) {
+                const uint32_t i{order[j].second};
+                if (address(hash_codes[i], cur_state) == idx) {
+                    fn(b, i);
+                } else {
+                    moved.push_back(i);
+                }
+            }
+        }
+
+        for (const uint32_t i : moved) {
+            with_bucket< LockT >(hash_codes[i], [&fn, i](BucketT& b) { return fn(b, i); });
+        }
+    }
+
+    /// Prefetches the bucket of the hash code, for the batched readers which don't go through with_buckets()
+    void prefetch(const uint64_t hash_code) const {
+        __builtin_prefetch(&bucket(address(hash_code, m_state.load(std::memory_order_acquire))));
+    }
+
+    /// Calls fn(bucket) without any lock, for the readers which keep the entries alive by other means (RCU). A split
+    /// could move the entries past the reader, so fn returning false (not found) is retried if a split ran meanwhile.
+    template < typename Fn >
+    bool read_unlocked(const uint64_t hash_code, Fn&& fn) const {
+        while (true) {
+            const uint64_t seq{m_split_seq.load(std::memory_order_acquire)};
+            if (fn(bucket(address(hash_code, m_state.load(std::memory_order_acquire))))) { return true; }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (((seq & 1) == 0) && (m_split_seq.load(std::memory_order_relaxed) == seq)) { return false; }
+        }
+    }
+
+    void entries_removed(const int64_t count) { m_nentries.fetch_sub(count, std::memory_order_relaxed); }
+
+    /// Must be called without holding any bucket lock, since it could split that very bucket
+    void entries_added(const int64_t count) {
+        m_nentries.fetch_add(count, std::memory_order_relaxed);
+        if (!is_overloaded()) { return; }
+
+        // Only one thread splits at a time, the others carry on with their inserts
+        std::unique_lock split_guard{m_split_mtx, std::try_to_lock};
+        if (!split_guard.owns_lock()) { return; }
+        for (int64_t i{0}; (i < (s_max_splits_per_op * count)) && is_overloaded(); ++i) {
+            if (!split_one()) { break; }
+        }
+    }
+
+    uint64_t num_buckets() const {
+        const uint64_t state{m_state.load(std::memory_order_acquire)};
+        return (m_initial_buckets << (state >> 32)) + (state & s_split_mask);
+    }
+
+    int64_t num_entries() const { return m_nentries.load(std::memory_order_relaxed); }
+
+    // for testing purpose
+    uint64_t max_chain_length() const {
+        uint64_t max_len{0};
+        const uint64_t nbuckets{num_buckets()};
+        for (uint64_t idx{0}; idx < nbuckets; ++idx) {
+            BucketT& b{bucket(idx)};
+            std::shared_lock< folly::SharedMutex > holder{b.lock()};
+            max_len = std::max< uint64_t >(max_len, b.size());
+        }
+        return max_len;
+    }
+
+private:
+    bool is_overloaded() const {
+        return (m_nentries.load(std::memory_order_relaxed) > int64_t(max_load() * num_buckets()));
+    }
+
+    uint64_t address(const uint64_t hash_code, const uint64_t state) const {
+        const uint64_t modulo{m_initial_buckets << (state >> 32)};
+        const uint64_t idx{hash_code % modulo};
+        return (idx < (state & s_split_mask)) ? (hash_code % (modulo << 1)) : idx;
+    }
+
+    BucketT& bucket(const uint64_t idx) const {
+        if (idx < m_initial_buckets) { return m_segments[0].load(std::memory_order_acquire)[idx]; }
+        const uint32_t seg{uint32_t(std::bit_width(idx / m_initial_buckets))};
+        return m_segments[seg].load(std::memory_order_acquire)[idx - (m_initial_buckets << (seg - 1))];
+    }
+
+    // Called with m_split_mtx held, which is the only place where m_state and m_segments change
+    bool split_one() {
+        const uint64_t state{m_state.load(std::memory_order_relaxed)};
+        const uint64_t level{state >> 32};
+        const uint64_t split{state & s_split_mask};
+        const uint64_t modulo{m_initial_buckets << level};
+        if (((level + 1) >= s_max_segments) || ((modulo << 1) > s_split_mask)) { return false; }
+
+        // First split of a level needs the next segment, which holds all the buckets this level adds
+        if (split == 0) { m_segments[level + 1].store(new BucketT[modulo], std::memory_order_release); }
+
+        const uint64_t to_idx{split + modulo};
+        BucketT& from{bucket(split)};
+        BucketT& to{bucket(to_idx)};
+        std::unique_lock< folly::SharedMutex > from_holder{from.lock()};
+        std::unique_lock< folly::SharedMutex > to_holder{to.lock()};
+        const uint64_t seq{m_split_seq.load(std::memory_order_relaxed)};
+        m_split_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        from.split_to(to, [to_idx, modulo](const uint64_t hash_code) { return ((hash_code % (modulo << 1)) == to_idx); });
+
+        // Publish the new address map before releasing the bucket locks, so that anyone waiting on them sees it
+        const uint64_t next_split{split + 1};
+        m_state.store((next_split == modulo) ? ((level + 1) << 32) : ((level << 32) | next_split),
+                      std::memory_order_release);
+        m_split_seq.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+};
+
+} // namespace sisl
@@ -16,6 +16,8 @@
  *********************************************************************************/
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <vector>
 #include <functional>
@@ -32,7 +34,12 @@ class LRUEvictor : public Evictor {
 public:
     typedef std::function< bool(const ValueEntryBase&) > can_evict_cb_t;
 
-    LRUEvictor(const int64_t max_size, const uint32_t num_partitions);
+    /* With buffered_access, a hit doesn't take the partition lock but is put in a lossy read buffer of the partition,
+     * which is drained in a batch by whoever takes the lock next, or by the hit which finds the buffer full. Recency
+     * becomes approximate, as the accesses are applied late and some of them are dropped when the buffer is full.
+     * Buffered records must stay at the same address while they are in the cache, which holds for SimpleCache, but
+     * not for RangeCache, which moves its records around when splitting or merging ranges. */
+    LRUEvictor(const int64_t max_size, const uint32_t num_partitions, const bool buffered_access = false);
     LRUEvictor(const LRUEvictor&) = delete;
     LRUEvictor(LRUEvictor&&) noexcept = delete;
     LRUEvictor& operator=(const LRUEvictor&) = delete;
@@ -48,6 +55,12 @@ public:
     void record_accessed(uint64_t hash_code, CacheRecord& record) override;
 
     void record_resized(uint64_t hash_code, const CacheRecord& record, uint32_t old_size) override;
+    bool record_replaced(uint64_t hash_code, CacheRecord& record, CacheRecord& new_record) override;
+    void record_family_unregistered(const uint32_t record_type_id) override;
+    void record_add_failed(uint64_t hash_code, const CacheRecord& record) override;
+
+    static constexpr uint32_t s_read_buffer_stripes{4};
+    static constexpr uint32_t s_read_buffer_size{32};
 
     // for testing purpose
     int64_t filled_size() {
@@ -65,6 +78,14 @@ private:
         constant_time_size< false > >
         EvictRecordList;
 
+    // Lossy buffer of the accessed records. A hit puts the record in the next slot if it is empty, draining takes out
+    // the records from all the slots, irrespective of where the hits have got upto. Removing a record only clears the
+    // slot it is in.
+    struct ReadBuffer {
+        std::array< std::atomic< CacheRecord* >, s_read_buffer_size > m_slots{};
+        std::atomic< uint32_t > m_write_idx{0};
+    };
+
     class LRUPartition {
     private:
         EvictRecordList m_list;
@@ -73,6 +94,7 @@ private:
         uint32_t m_partition_num;
         int64_t m_filled_size{0};
         int64_t m_max_size;
+        std::unique_ptr< ReadBuffer[] > m_read_buffers; // Only with buffered access
 
     public:
         LRUPartition() = default;
@@ -81,15 +103,20 @@ private:
         LRUPartition(LRUPartition&&) = default;
         LRUPartition& operator=(LRUPartition&&) = default;
 
-        void init(LRUEvictor* evictor, const uint32_t partition_num, const uint64_t max_size) {
+        void init(LRUEvictor* evictor, const uint32_t partition_num, const uint64_t max_size,
+                  const bool buffered_access) {
             m_evictor = evictor;
             m_partition_num = partition_num;
             m_max_size = int64_cast(max_size);
+            if (buffered_access) { m_read_buffers = std::make_unique< ReadBuffer[] >(s_read_buffer_stripes); }
         }
         bool add_record(CacheRecord& record);
         void remove_record(CacheRecord& record);
         void record_accessed(CacheRecord& record);
         void record_resized(const CacheRecord& record, uint32_t old_size);
+        void record_replaced(CacheRecord& record, CacheRecord& new_record);
+        void discard_read_buffers();
+        void discard_read_buffers(const CacheRecord& record);
 
         // for testing purpose
         int64_t filled_size() {
@@ -99,6 +126,11 @@ private:
 
     private:
         bool do_evict(const uint32_t record_fid, const uint32_t needed_size);
+        void buffer_access(CacheRecord& record);
+        void drain_read_buffers();
+        void scrub_read_buffers(const CacheRecord* record);
+        void unbuffer(const CacheRecord& record);
+        void promote(CacheRecord& record);
         bool will_fill(const uint32_t new_size) const { return ((m_filled_size + new_size) > m_max_size); }
         bool is_full() const { return (m_filled_size >= m_max_size); }
     };
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <set>
+#include <span>
 #include <sisl/cache/evictor.hpp>
 #include <sisl/cache/range_hashmap.hpp>
 
@@ -39,7 +40,7 @@ public:
             m_map{RangeHashMap< K >(num_buckets, bind_this(RangeCache< K >::extract_value, 3),
                                     bind_this(RangeCache< K >::on_hash_operation, 4))},
             m_per_value_size{per_val_size} {
-        m_evictor->register_record_family(Evictor::RecordFamily{.can_evict_cb = evict_cb});
+        m_record_family_id = m_evictor->register_record_family(Evictor::RecordFamily{.can_evict_cb = evict_cb});
     }
 
     ~RangeCache() { m_evictor->unregister_record_family(m_record_family_id); }
@@ -64,6 +65,11 @@ public:
         return m_map.get(RangeKey{base_key, offset, count});
     }
 
+    /// Batched get() of several ranges, the entries found for all of them are returned together in no particular order
+    std::vector< std::pair< RangeKey< K >, sisl::byte_view > > multi_get(std::span< const RangeKey< K > > keys) {
+        return m_map.multi_get(keys);
+    }
+
 private:
     void on_hash_operation(const CacheRecord& r, const RangeKey< K >& sub_key, const hash_op_t op, int64_t new_size) {
         CacheRecord& record = const_cast< CacheRecord& >(r);
@@ -80,7 +86,10 @@ private:
         case hash_op_t::DELETE:
             if (t_failed_keys.size()) {
                 // Check if this is a delete of failed keys, if so lets not add it to record
-                if (t_failed_keys.find(sub_key) != t_failed_keys.end()) { return; }
+                if (t_failed_keys.find(sub_key) != t_failed_keys.end()) {
+                    m_evictor->record_add_failed(sub_key.compute_hash(), record);
+                    return;
+                }
             }
             m_evictor->remove_record(sub_key.compute_hash(), record);
             break;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <boost/intrusive/slist.hpp>
+#include <span>
 #include <vector>
 #include <string>
 #include <folly/Traits.h>
@@ -35,6 +36,7 @@
 #include <sisl/fds/utils.hpp>
 #include <sisl/utility/enum.hpp>
 #include <sisl/cache/hash_entry_base.hpp>
+#include <sisl/cache/linear_hash_buckets.hpp>
 
 namespace sisl {
 
@@ -108,8 +110,7 @@ class RangeHashMap {
 private:
     static thread_local std::vector< RangeKey< K > > s_kviews;
 
-    uint32_t m_nbuckets;
-    HashBucket< K >* m_buckets;
+    LinearHashBuckets< HashBucket< K > > m_buckets;
     value_extractor_cb_t m_value_extractor;
     key_access_cb_t< K > m_key_access_cb;
 
@@ -120,13 +121,21 @@ private:
 #endif
 
 public:
+    /// nBuckets is only the initial number of buckets, the map grows as nodes are added (see LinearHashBuckets)
     RangeHashMap(uint32_t nBuckets, value_extractor_cb_t value_extractor, key_access_cb_t< K > access_cb = nullptr);
-    ~RangeHashMap();
+    ~RangeHashMap() = default;
 
     void insert(const RangeKey< K >& key, const sisl::io_blob& value);
     std::vector< std::pair< RangeKey< K >, sisl::byte_view > > get(const RangeKey< K >& input_key);
+    /// Batched get() of several ranges, locking each bucket once for all the nodes of all the ranges which fall in it.
+    /// The entries found for all the ranges are returned together, in no particular order.
+    std::vector< std::pair< RangeKey< K >, sisl::byte_view > > multi_get(std::span< const RangeKey< K > > input_keys);
     void erase(const RangeKey< K >& key);
 
+    uint64_t num_buckets() const { return m_buckets.num_buckets(); }
+    // for testing purpose
+    uint64_t max_chain_length() const { return m_buckets.max_chain_length(); }
+
     static void set_current_instance(RangeHashMap< K >* hmap) { s_cur_hash_map = hmap; }
     static RangeHashMap< K >* get_current_instance() { return s_cur_hash_map; }
     static value_extractor_cb_t& get_value_extractor() { return get_current_instance()->m_value_extractor; }
@@ -145,10 +154,9 @@ public:
     }
 
 private:
-    HashBucket< K >& get_bucket(const RangeKey< K >& key) const;
-    HashBucket< K >& get_bucket(const K& base_key, const big_offset_t nth) const;
-    HashBucket< K >& get_bucket(size_t hash_code) const;
+    friend class HashBucket< K >;
 
+    static size_t compute_hash(const RangeKey< K >& key) { return compute_hash(key.m_base_key, key.rounded_nth()); }
     static size_t compute_hash(const K& base_key, const big_offset_t nth) {
         size_t seed = s_start_seed;
         boost::hash_combine(seed, base_key);
@@ -315,7 +323,8 @@ public:
             m_values[r_idx].move_right_to(this, input_range.second + 1);
             LOGDEBUG("Node({}) To insert: shrinking entry by moving right at idx={}, new value=[{}]", to_string(),
                      r_idx, m_values[r_idx].to_string());
-        } else {
+        } else if (r_found) {
+            // Otherwise r_idx is already past the entries to erase, it is the first entry after the input range
             r_idx = std::min(r_idx + 1, int_cast(m_values.size()));
         }
 
@@ -373,7 +382,8 @@ public:
             m_values[r_idx].move_right_to(this, input_range.second + 1);
             LOGDEBUG("Node({}) To erase: shrinking entry by moving right at idx={}, new value=[{}]", to_string(), r_idx,
                      m_values[r_idx].to_string());
-        } else {
+        } else if (r_found) {
+            // Otherwise r_idx is already past the entries to erase, it is the first entry after the input range
             r_idx = std::min(r_idx + 1, int_cast(m_values.size()));
         }
 
@@ -460,12 +470,11 @@ template < typename K >
 thread_local sisl::RangeHashMap< K >* sisl::RangeHashMap< K >::s_cur_hash_map{nullptr};
 
 ///////////////////////////////////////////// HashBucket Definitions ///////////////////////////////////
+// Bucket methods expect the caller to hold lock(), which LinearHashBuckets::with_bucket() takes
 template < typename K >
 class HashBucket {
 private:
-#ifndef GLOBAL_HASHSET_LOCK
     mutable folly::SharedMutex m_lock;
-#endif
     typedef boost::intrusive::slist< MultiEntryHashNode< K > > hash_node_list_t;
     hash_node_list_t m_list;
 
@@ -481,10 +490,26 @@ public:
         }
     }
 
-    void insert(const RangeKey< K >& input_key, sisl::byte_view&& value) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::unique_lock< folly::SharedMutex >(m_lock);
-#endif
+    folly::SharedMutex& lock() const { return m_lock; }
+    size_t size() const { return m_list.size(); }
+
+    // Moves the nodes whose hash code moves_out() accepts to the empty bucket to, both lists stay sorted
+    void split_to(HashBucket& to, const auto& moves_out) {
+        auto prev = m_list.before_begin();
+        auto to_last = to.m_list.before_begin();
+        for (auto it = std::next(prev); it != m_list.end(); it = std::next(prev)) {
+            if (moves_out(RangeHashMap< K >::compute_hash(it->m_base_key, it->m_base_nth))) {
+                auto& n = *it;
+                m_list.erase_after(prev);
+                to_last = to.m_list.insert_after(to_last, n);
+            } else {
+                prev = it;
+            }
+        }
+    }
+
+    // Returns true if a new node is added to the bucket
+    bool insert(const RangeKey< K >& input_key, sisl::byte_view&& value) {
         const auto input_nth_rounded = input_key.rounded_nth();
         MultiEntryHashNode< K >* n = nullptr;
         auto it = m_list.begin();
@@ -501,18 +526,17 @@ public:
             }
         }
 
-        if (n == nullptr) {
+        const bool new_node{n == nullptr};
+        if (new_node) {
             n = new MultiEntryHashNode< K >(input_key.m_base_key, input_nth_rounded);
             m_list.insert(it, *n);
         }
         n->insert(input_key, std::move(value));
+        return new_node;
     }
 
     big_count_t get(const RangeKey< K >& input_key,
                     std::vector< std::pair< RangeKey< K >, sisl::byte_view > >& out_values) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::shared_lock< folly::SharedMutex >(m_lock);
-#endif
         big_count_t ret{0};
         const auto input_nth_rounded = input_key.rounded_nth();
 
@@ -531,10 +555,8 @@ public:
         return ret;
     }
 
-    void erase(const RangeKey< K >& input_key) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::unique_lock< folly::SharedMutex >(m_lock);
-#endif
+    // Returns true if the node is freed up, since all its ranges are erased
+    bool erase(const RangeKey< K >& input_key) {
         const auto input_nth_rounded = input_key.rounded_nth();
         MultiEntryHashNode< K >* n = nullptr;
         auto it = m_list.begin();
@@ -558,10 +580,12 @@ public:
             if (node_size == 0) {
                 m_list.erase(it);
                 delete n;
+                return true;
             }
         } else {
             LOGDEBUG("Node(BaseKey={} Nth_Offset={}) NOT found", input_key.m_base_key, input_nth_rounded);
         }
+        return false;
     }
 
     static int compare(const RangeKey< K >& a, const RangeKey< K >& b) {
@@ -582,14 +606,7 @@ public:
 template < typename K >
 RangeHashMap< K >::RangeHashMap(uint32_t nBuckets, value_extractor_cb_t value_extractor,
                                 key_access_cb_t< K > access_cb) :
-        m_nbuckets{nBuckets}, m_value_extractor{std::move(value_extractor)}, m_key_access_cb{std::move(access_cb)} {
-    m_buckets = new HashBucket< K >[nBuckets];
-}
-
-template < typename K >
-RangeHashMap< K >::~RangeHashMap() {
-    delete[] m_buckets;
-}
+        m_buckets{nBuckets}, m_value_extractor{std::move(value_extractor)}, m_key_access_cb{std::move(access_cb)} {}
 
 template < typename K >
 void RangeHashMap< K >::insert(const RangeKey< K >& input_key, const sisl::io_blob& value) {
@@ -602,20 +619,24 @@ void RangeHashMap< K >::insert(const RangeKey< K >& input_key, const sisl::io_bl
     auto max_this_node = max_n_per_node - (input_key.m_nth - input_key.rounded_nth());
     RangeKey< K > node_key = input_key; // TODO: Can optimize this by avoiding base_key copy by doing some sort of view
     const sisl::byte_view base_val{value};
+    int64_t new_nodes{0};
 
     while (cur_key_nth <= input_key.end_nth()) {
         const auto count = std::min(max_this_node, input_key.end_nth() - cur_key_nth + 1);
         node_key.m_nth = cur_key_nth;
         node_key.m_count = count;
-        auto& hb = get_bucket(node_key);
 
         sisl::byte_view node_val = m_value_extractor(base_val, cur_val_nth, count);
-        hb.insert(node_key, std::move(node_val));
+        if (m_buckets.template with_bucket< std::unique_lock >(
+                compute_hash(node_key), [&](auto& hb) { return hb.insert(node_key, std::move(node_val)); })) {
+            ++new_nodes;
+        }
 
         cur_key_nth += count;
         cur_val_nth += count;
         max_this_node = max_n_per_node;
     }
+    if (new_nodes) { m_buckets.entries_added(new_nodes); }
 }
 
 template < typename K >
@@ -636,8 +657,8 @@ std::vector< std::pair< RangeKey< K >, sisl::byte_view > > RangeHashMap< K >::ge
         node_key.m_nth = cur_key_nth;
         node_key.m_count = count;
 
-        auto& hb = get_bucket(node_key);
-        hb.get(node_key, out_vals);
+        m_buckets.template with_bucket< std::shared_lock >(compute_hash(node_key),
+                                                           [&](auto& hb) { return hb.get(node_key, out_vals); });
 
         cur_key_nth += count;
         cur_val_nth += count;
@@ -646,6 +667,40 @@ std::vector< std::pair< RangeKey< K >, sisl::byte_view > > RangeHashMap< K >::ge
     return out_vals;
 }
 
+template < typename K >
+std::vector< std::pair< RangeKey< K >, sisl::byte_view > >
+RangeHashMap< K >::multi_get(std::span< const RangeKey< K > > input_keys) {
+#ifdef GLOBAL_HASHSET_LOCK
+    std::lock_guard< std::mutex > lk(m);
+#endif
+    set_current_instance(this);
+
+    // Split all the ranges into their node keys upfront, so that the nodes can be grouped by bucket
+    std::vector< RangeKey< K > > node_keys;
+    std::vector< uint64_t > hash_codes;
+    for (const auto& input_key : input_keys) {
+        auto cur_key_nth = input_key.m_nth;
+        auto max_this_node = max_n_per_node - (input_key.m_nth - input_key.rounded_nth());
+        RangeKey< K > node_key = input_key;
+
+        while (cur_key_nth <= input_key.end_nth()) {
+            const auto count = std::min(max_this_node, input_key.end_nth() - cur_key_nth + 1);
+            node_key.m_nth = cur_key_nth;
+            node_key.m_count = count;
+            hash_codes.push_back(compute_hash(node_key));
+            node_keys.push_back(node_key);
+
+            cur_key_nth += count;
+            max_this_node = max_n_per_node;
+        }
+    }
+
+    std::vector< std::pair< RangeKey< K >, sisl::byte_view > > out_vals;
+    m_buckets.template with_buckets< std::shared_lock >(
+        hash_codes, [&](auto& hb, const uint32_t i) { hb.get(node_keys[i], out_vals); });
+    return out_vals;
+}
+
 template < typename K >
 void RangeHashMap< K >::erase(const RangeKey< K >& input_key) {
 #ifdef GLOBAL_HASHSET_LOCK
@@ -655,31 +710,20 @@ void RangeHashMap< K >::erase(const RangeKey< K >& input_key) {
     auto cur_key_nth = input_key.m_nth;
     auto max_this_node = max_n_per_node - (input_key.m_nth - input_key.rounded_nth());
     RangeKey< K > node_key = input_key; // TODO: Can optimize this by avoiding base_key copy by doing some sort of view
+    int64_t freed_nodes{0};
 
     while (cur_key_nth <= input_key.end_nth()) {
         const auto count = std::min(max_this_node, input_key.end_nth() - cur_key_nth + 1);
         node_key.m_nth = cur_key_nth;
         node_key.m_count = count;
-        auto& hb = get_bucket(node_key);
-        hb.erase(node_key);
+        if (m_buckets.template with_bucket< std::unique_lock >(compute_hash(node_key),
+                                                               [&](auto& hb) { return hb.erase(node_key); })) {
+            ++freed_nodes;
+        }
         cur_key_nth += count;
         max_this_node = max_n_per_node;
     }
-}
-
-template < typename K >
-HashBucket< K >& RangeHashMap< K >::get_bucket(const RangeKey< K >& key) const {
-    return (m_buckets[compute_hash(key.m_base_key, key.rounded_nth()) % m_nbuckets]);
-}
-
-template < typename K >
-HashBucket< K >& RangeHashMap< K >::get_bucket(const K& base_key, const big_offset_t nth) const {
-    return (m_buckets[compute_hash(base_key, nth) % m_nbuckets]);
-}
-
-template < typename K >
-HashBucket< K >& RangeHashMap< K >::get_bucket(size_t hash_code) const {
-    return (m_buckets[hash_code % m_nbuckets]);
+    if (freed_nodes) { m_buckets.entries_removed(freed_nodes); }
 }
 
 } // namespace sisl
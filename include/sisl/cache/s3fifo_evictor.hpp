@@ -0,0 +1,138 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <boost/intrusive/list.hpp>
+#include <sisl/fds/utils.hpp>
+#include <sisl/cache/evictor.hpp>
+
+using namespace boost::intrusive;
+
+namespace sisl {
+
+/* S3-FIFO evictor, which keeps a scan (a burst of records accessed only once) from flushing out the hot records.
+ *
+ * New records are admitted to a small FIFO queue, which holds about small_queue_pct() of the partition. A record
+ * accessed again by the time it reaches the head of the small queue moves to the main queue, otherwise it is evicted
+ * and a tag of its hash is remembered in a ghost queue. A record added again while its tag is still in the ghost
+ * queue goes directly to the main queue. The main queue is a CLOCK with a small access count instead of a reference
+ * bit. Like ClockEvictor, a hit only counts the access on the record without any lock. */
+class S3FIFOEvictor : public Evictor {
+public:
+    S3FIFOEvictor(const int64_t max_size, const uint32_t num_partitions);
+    S3FIFOEvictor(const S3FIFOEvictor&) = delete;
+    S3FIFOEvictor(S3FIFOEvictor&&) noexcept = delete;
+    S3FIFOEvictor& operator=(const S3FIFOEvictor&) = delete;
+    S3FIFOEvictor& operator=(S3FIFOEvictor&&) noexcept = delete;
+    virtual ~S3FIFOEvictor() = default;
+
+    bool add_record(uint64_t hash_code, CacheRecord& record) override;
+    void remove_record(uint64_t hash_code, CacheRecord& record) override;
+
+    /* Counts the access on the record, which decides if it moves to the main queue or how many sweeps of the main
+     * queue it survives. Lock free */
+    void record_accessed(uint64_t hash_code, CacheRecord& record) override;
+
+    void record_resized(uint64_t hash_code, const CacheRecord& record, uint32_t old_size) override;
+    bool record_replaced(uint64_t hash_code, CacheRecord& record, CacheRecord& new_record) override;
+    bool counts_accesses() const override { return true; }
+
+    // for testing purpose
+    int64_t filled_size() {
+        int64_t filled_size{0};
+        for (uint32_t i{0}; i < num_partitions(); ++i) {
+            filled_size += m_partitions[i].filled_size();
+        }
+        return filled_size;
+    }
+
+    static constexpr int64_t small_queue_pct() { return 10; }
+
+private:
+    typedef list<
+        ValueEntryBase,
+        member_hook< ValueEntryBase, list_member_hook< link_mode< auto_unlink > >, &ValueEntryBase::m_member_hook >,
+        constant_time_size< false > >
+        EvictRecordList;
+
+    // Evictor data of a record is the ghost tag of its hash, with the lowest bit telling if it is in the main queue
+    static constexpr uint32_t main_queue_bit() { return 1; }
+    static uint32_t ghost_tag(const uint64_t hash_code) {
+        // Hash codes of small keys often have their upper bits all zero, so mix them before taking the tag
+        return static_cast< uint32_t >((hash_code * 0x9E3779B97F4A7C15ULL) >> 32) & ~main_queue_bit();
+    }
+
+    class S3FIFOPartition {
+    private:
+        EvictRecordList m_small;
+        EvictRecordList m_main;
+        std::deque< uint32_t > m_ghost;                        // Tags of the records evicted from the small queue
+        std::unordered_map< uint32_t, uint32_t > m_ghost_tags; // Number of times each tag is in m_ghost
+        S3FIFOEvictor* m_evictor;
+        std::mutex m_list_guard;
+        uint32_t m_partition_num;
+        int64_t m_filled_size{0};
+        int64_t m_small_size{0};
+        int64_t m_max_size;
+        uint64_t m_count{0};
+
+    public:
+        S3FIFOPartition() = default;
+        S3FIFOPartition(const S3FIFOPartition&) = delete;
+        S3FIFOPartition& operator=(const S3FIFOPartition&) = delete;
+        S3FIFOPartition(S3FIFOPartition&&) = default;
+        S3FIFOPartition& operator=(S3FIFOPartition&&) = default;
+
+        void init(S3FIFOEvictor* evictor, const uint32_t partition_num, const uint64_t max_size) {
+            m_evictor = evictor;
+            m_partition_num = partition_num;
+            m_max_size = int64_cast(max_size);
+        }
+        bool add_record(CacheRecord& record, uint32_t tag);
+        void remove_record(CacheRecord& record);
+        void record_resized(const CacheRecord& record, uint32_t old_size);
+        void record_replaced(CacheRecord& record, CacheRecord& new_record);
+
+        // for testing purpose
+        int64_t filled_size() {
+            std::unique_lock guard{m_list_guard};
+            return m_filled_size;
+        }
+
+    private:
+        bool do_evict(const uint32_t record_fid, const uint32_t needed_size);
+        void evict_small(const uint32_t record_fid, size_t& evictions_count, size_t& evicted_size,
+                         size_t& eviction_punt_count);
+        void evict_main(const uint32_t record_fid, size_t& evictions_count, size_t& evicted_size,
+                        size_t& eviction_punt_count);
+        bool try_evict(const uint32_t record_fid, CacheRecord& rec);
+        void add_ghost(const uint32_t tag);
+        bool remove_ghost(const uint32_t tag);
+        bool will_fill(const uint32_t new_size) const { return ((m_filled_size + new_size) > m_max_size); }
+        bool is_full() const { return (m_filled_size >= m_max_size); }
+        bool in_main(const CacheRecord& record) const { return (record.evictor_data() & main_queue_bit()); }
+    };
+
+private:
+    S3FIFOPartition& get_partition(uint64_t hash_code) { return m_partitions[hash_code % num_partitions()]; }
+    std::unique_ptr< S3FIFOPartition[] > m_partitions;
+};
+} // namespace sisl
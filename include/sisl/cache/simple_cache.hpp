@@ -17,6 +17,8 @@
 #pragma once
 
 #include <set>
+#include <span>
+#include <vector>
 #include <sisl/cache/evictor.hpp>
 #include <sisl/cache/simple_hashmap.hpp>
 
@@ -24,13 +26,15 @@ using namespace std::placeholders;
 
 namespace sisl {
 
-template < typename K, typename V >
+// MapT is SimpleHashMap or any map with the same interface and callback contract, like SwissHashMap. A map which
+// replaces entries with a REPLACE callback also has a static replaced_entry(), returning the entry being replaced.
+template < typename K, typename V, typename MapT = SimpleHashMap< K, V > >
 class SimpleCache {
 private:
     std::unique_ptr< CacheMetrics > m_metrics;
     std::shared_ptr< Evictor > m_evictor;
     key_extractor_cb_t< K, V > m_key_extract_cb;
-    SimpleHashMap< K, V > m_map;
+    MapT m_map;
     uint32_t m_record_family_id;
     uint32_t m_per_value_size;
 
@@ -42,8 +46,14 @@ public:
             m_metrics{std::make_unique< CacheMetrics >()},
             m_evictor{evictor},
             m_key_extract_cb{std::move(extract_cb)},
-            m_map{num_buckets, m_key_extract_cb, std::bind(&SimpleCache< K, V >::on_hash_operation, this, _1, _2, _3)},
+            m_map{num_buckets, m_key_extract_cb,
+                  std::bind(&SimpleCache< K, V, MapT >::on_hash_operation, this, _1, _2, _3)},
             m_per_value_size{per_val_size} {
+        // Hits of a map with RCU reads only count the access on the record, which an evictor reordering on
+        // record_accessed() (like LRUEvictor) never sees, degrading it to FIFO
+        if constexpr (requires { requires MapT::rcu_reads(); }) {
+            RELEASE_ASSERT(m_evictor->counts_accesses(), "Map with RCU reads needs an evictor which counts accesses");
+        }
                 // Register the record family callbacks with the evictor:
                 // - `can_evict_cb`: Provided by the user of the `SimpleCache`. This callback determines whether a record can be evicted.
                 // - `post_eviction_cb`: Owned by the `SimpleCache`. This callback is used to remove the evicted record from the hashmap.
@@ -64,31 +74,77 @@ public:
     bool insert(const V& value) {
         K k = m_key_extract_cb(value);
         bool ret = m_map.insert(k, value);
-        if (t_failed_keys.size()) {
-            // There are some failures to add for some keys
-            for (auto& key : t_failed_keys) {
-                V dummy_v;
-                m_map.erase(key, dummy_v);
-                ret = false;
-            }
-            t_failed_keys.clear();
-        }
+        if (erase_failed_keys() > 0) { ret = false; }
         return ret;
     }
 
     bool upsert(const V& value) {
         K k = m_key_extract_cb(value);
-        return m_map.upsert(k, value);
+        bool ret = m_map.upsert(k, value);
+        if (erase_failed_keys() > 0) { ret = false; }
+        return ret;
     }
 
     bool remove(const K& key, V& out_val) { return m_map.erase(key, out_val); }
 
     bool get(const K& key, V& out_val) { return m_map.get(key, out_val); }
 
+    /// Batched get(), which appends the found key value pairs to out_vals in no particular order and returns their
+    /// count. Maps without batched lookups (like SwissHashMap) get the keys one by one.
+    uint32_t multi_get(std::span< const K > keys, std::vector< std::pair< K, V > >& out_vals) {
+        if constexpr (requires { m_map.multi_get(keys, out_vals); }) {
+            return m_map.multi_get(keys, out_vals);
+        } else {
+            uint32_t nfound{0};
+            V val;
+            for (const auto& key : keys) {
+                if (m_map.get(key, val)) {
+                    out_vals.emplace_back(key, std::move(val));
+                    ++nfound;
+                }
+            }
+            return nfound;
+        }
+    }
+
+    /// Batched insert(), returns the number of values inserted
+    uint32_t multi_insert(std::span< const V > values) {
+        std::vector< K > keys;
+        keys.reserve(values.size());
+        for (const auto& value : values) {
+            keys.push_back(m_key_extract_cb(value));
+        }
+
+        uint32_t ninserted{0};
+        if constexpr (requires { m_map.multi_insert(std::span< const K >{keys}, values); }) {
+            ninserted = m_map.multi_insert(std::span< const K >{keys}, values);
+        } else {
+            for (size_t i{0}; i < values.size(); ++i) {
+                if (m_map.insert(keys[i], values[i])) { ++ninserted; }
+            }
+        }
+
+        return ninserted - erase_failed_keys();
+    }
+
 private:
+    // Erase the keys which were added to the map, but failed to be added to the evictor, returns their count
+    uint32_t erase_failed_keys() {
+        uint32_t nerased{0};
+        if (t_failed_keys.size()) {
+            // There are some failures to add for some keys
+            for (auto& key : t_failed_keys) {
+                V dummy_v;
+                if (m_map.erase(key, dummy_v)) { ++nerased; }
+            }
+            t_failed_keys.clear();
+        }
+        return nerased;
+    }
+
     void on_hash_operation(const CacheRecord& r, const K& key, const hash_op_t op) {
         CacheRecord& record = const_cast< CacheRecord& >(r);
-        const auto hash_code = SimpleHashMap< K, V >::compute_hash(key);
+        const auto hash_code = MapT::compute_hash(key);
 
         switch (op) {
         case hash_op_t::CREATE:
@@ -103,7 +159,10 @@ private:
         case hash_op_t::DELETE:
             if (t_failed_keys.size()) {
                 // Check if this is a delete of failed keys, if so lets not add it to record
-                if (t_failed_keys.find(key) != t_failed_keys.end()) { return; }
+                if (t_failed_keys.find(key) != t_failed_keys.end()) {
+                    m_evictor->record_add_failed(hash_code, record);
+                    return;
+                }
             }
             m_evictor->remove_record(hash_code, record);
             break;
@@ -112,6 +171,18 @@ private:
             m_evictor->record_accessed(hash_code, record);
             break;
 
+        case hash_op_t::REPLACE:
+            // Maps which replace entries (like SimpleHashMap with RCUReads) provide the entry being replaced
+            if constexpr (requires { MapT::replaced_entry(); }) {
+                if (!m_evictor->record_replaced(hash_code, const_cast< CacheRecord& >(MapT::replaced_entry()),
+                                                record)) {
+                    t_failed_keys.insert(key);
+                }
+            } else {
+                DEBUG_ASSERT(false, "REPLACE from a map which doesn't provide replaced_entry()");
+            }
+            break;
+
         case hash_op_t::RESIZE: {
             DEBUG_ASSERT(false, "Don't expect RESIZE operation for simple cache entries");
             break;
@@ -123,7 +194,7 @@ private:
     }
 };
 
-template < typename K, typename V >
-thread_local std::set< K > SimpleCache< K, V >::t_failed_keys;
+template < typename K, typename V, typename MapT >
+thread_local std::set< K > SimpleCache< K, V, MapT >::t_failed_keys;
 
 } // namespace sisl
@@ -16,7 +16,10 @@
  *********************************************************************************/
 #pragma once
 
-#include <boost/intrusive/slist.hpp>
+#include <atomic>
+#include <span>
+#include <utility>
+#include <vector>
 #include <boost/functional/hash.hpp>
 #include <folly/Traits.h>
 #include <folly/small_vector.h>
@@ -32,14 +35,16 @@
 
 #include <sisl/fds/utils.hpp>
 #include <sisl/utility/enum.hpp>
+#include <sisl/utility/urcu_helper.hpp>
 #include <sisl/cache/hash_entry_base.hpp>
+#include <sisl/cache/linear_hash_buckets.hpp>
 
 namespace sisl {
 
-template < typename K, typename V >
+template < typename K, typename V, bool RCUReads = false >
 class SimpleHashBucket;
 
-ENUM(hash_op_t, uint8_t, CREATE, ACCESS, DELETE, RESIZE)
+ENUM(hash_op_t, uint8_t, CREATE, ACCESS, DELETE, RESIZE, REPLACE)
 
 template < typename K >
 using key_access_cb_t = std::function< void(const ValueEntryBase&, const K&, const hash_op_t) >;
@@ -50,24 +55,37 @@ using key_extractor_cb_t = std::function< K(const V&) >;
 static constexpr size_t s_start_seed = 0; // TODO: Pickup a better seed
 
 ///////////////////////////////////////////// RangeHashMap Declaration ///////////////////////////////////
-template < typename K, typename V >
+template < typename K, typename V, bool RCUReads = false >
 class SimpleHashMap {
 private:
-    uint32_t m_nbuckets;
-    SimpleHashBucket< K, V >* m_buckets;
+    LinearHashBuckets< SimpleHashBucket< K, V, RCUReads > > m_buckets;
     key_extractor_cb_t< K, V > m_key_extract_cb;
     key_access_cb_t< K > m_key_access_cb;
 
-    static thread_local SimpleHashMap< K, V >* s_cur_hash_map;
+    static thread_local SimpleHashMap* s_cur_hash_map;
+    static thread_local const ValueEntryBase* s_replaced_entry;
 
 #ifdef GLOBAL_HASHSET_LOCK
     mutable std::mutex m;
 #endif
 
 public:
+    /// nBuckets is only the initial number of buckets, the map grows as entries are added (see LinearHashBuckets)
+    ///
+    /// With RCUReads, get() doesn't take the bucket lock but runs in a RCU read side section, while the writers
+    /// still lock the bucket exclusively. Every thread accessing the map then needs to be registered with RCU. In
+    /// this mode:
+    /// * Writers never change the value of a linked entry, they link a copy with the new value in its place. Instead
+    ///   of an ACCESS, the access callback sees a REPLACE of the new entry, with the old one as replaced_entry(), so
+    ///   that the new entry can take over the place of the old one in the evictor.
+    /// * Erased entries are freed through call_rcu, once the readers which could still see them are done.
+    /// * get() counts the hit on the entry (ValueEntryBase::record_access()) instead of calling the access callback,
+    ///   since the entry could be deleted concurrently. Only the evictors which track accesses with that count
+    ///   (Evictor::counts_accesses(), like ClockEvictor and S3FIFOEvictor) see the hits, hence SimpleCache refuses any
+    ///   other evictor, like LRUEvictor, with this mode.
     SimpleHashMap(uint32_t nBuckets, const key_extractor_cb_t< K, V >& key_extractor,
                   key_access_cb_t< K > access_cb = nullptr);
-    ~SimpleHashMap();
+    ~SimpleHashMap() = default;
 
     bool insert(const K& key, const V& value);
     bool upsert(const K& key, const V& value);
@@ -77,10 +95,24 @@ public:
     bool update(const K& key, auto&& update_cb);
     bool upsert_or_delete(const K& key, auto&& update_or_delete_cb);
 
-    static void set_current_instance(SimpleHashMap< K, V >* hmap) { s_cur_hash_map = hmap; }
-    static SimpleHashMap< K, V >* get_current_instance() { return s_cur_hash_map; }
+    /// Batched get() and insert(), which lock each bucket once for all of its keys (see LinearHashBuckets).
+    /// multi_get() appends the found key value pairs to out_vals in no particular order and returns their count.
+    /// multi_insert() inserts values[i] for keys[i] and returns the number of keys which were newly inserted.
+    uint32_t multi_get(std::span< const K > keys, std::vector< std::pair< K, V > >& out_vals);
+    uint32_t multi_insert(std::span< const K > keys, std::span< const V > values);
+
+    uint64_t num_buckets() const { return m_buckets.num_buckets(); }
+    // for testing purpose
+    uint64_t max_chain_length() const { return m_buckets.max_chain_length(); }
+
+    static void set_current_instance(SimpleHashMap* hmap) { s_cur_hash_map = hmap; }
+    static SimpleHashMap* get_current_instance() { return s_cur_hash_map; }
     static key_access_cb_t< K >& get_access_cb() { return get_current_instance()->m_key_access_cb; }
     static key_extractor_cb_t< K, V >& extractor_cb() { return get_current_instance()->m_key_extract_cb; }
+    static constexpr bool rcu_reads() { return RCUReads; }
+    // Entry being replaced, only valid within the REPLACE access callback
+    static const ValueEntryBase& replaced_entry() { return *s_replaced_entry; }
+    static void set_replaced_entry(const ValueEntryBase* entry) { s_replaced_entry = entry; }
 
     template < typename... Args >
     static void call_access_cb(Args&&... args) {
@@ -93,144 +125,198 @@ public:
         boost::hash_combine(seed, key);
         return seed;
     }
-
-private:
-    SimpleHashBucket< K, V >& get_bucket(const K& key) const;
-    SimpleHashBucket< K, V >& get_bucket(size_t hash_code) const;
 };
 
+template < typename K, typename V >
+using RCUSimpleHashMap = SimpleHashMap< K, V, true /* RCUReads */ >;
+
 ///////////////////////////////////////////// MultiEntryHashNode Definitions ///////////////////////////////////
 template < typename V >
-struct SingleEntryHashNode : public ValueEntryBase, public boost::intrusive::slist_base_hook<> {
+struct SingleEntryHashNode : public ValueEntryBase {
     V m_value;
+
     SingleEntryHashNode(const V& value) : m_value{value} {}
 };
 
+// Plain pointer with the load() and store() of std::atomic, so that the chain code is the same for both read modes
+template < typename T >
+struct plain_link {
+    T* m_ptr{nullptr};
+
+    T* load(std::memory_order) const { return m_ptr; }
+    void store(T* const ptr, std::memory_order) { m_ptr = ptr; }
+};
+
+// Node of the SimpleHashBucket chain. Only with RCUReads, the readers walk the chain concurrently with the writers,
+// so the link is atomic and the node is freed through call_rcu.
+template < typename V, bool RCUReads >
+struct SimpleHashNode : public SingleEntryHashNode< V > {
+    plain_link< SimpleHashNode > m_next;
+
+    SimpleHashNode(const V& value) : SingleEntryHashNode< V >{value} {}
+};
+
+template < typename V >
+struct SimpleHashNode< V, true > : public SingleEntryHashNode< V > {
+    std::atomic< SimpleHashNode* > m_next{nullptr};
+    rcu_head m_rcu_head;
+
+    SimpleHashNode(const V& value) : SingleEntryHashNode< V >{value} {}
+
+    static void rcu_free(rcu_head* head) {
+#if defined __clang__ or defined __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#endif
+        delete caa_container_of(head, SimpleHashNode, m_rcu_head);
+#if defined __clang__ or defined __GNUC__
+#pragma GCC diagnostic pop
+#endif
+    }
+};
+
 ///////////////////////////////////////////// ValueEntryRange Definitions ///////////////////////////////////
 
-template < typename K, typename V >
-thread_local sisl::SimpleHashMap< K, V >* sisl::SimpleHashMap< K, V >::s_cur_hash_map{nullptr};
+template < typename K, typename V, bool RCUReads >
+thread_local sisl::SimpleHashMap< K, V, RCUReads >* sisl::SimpleHashMap< K, V, RCUReads >::s_cur_hash_map{nullptr};
+
+template < typename K, typename V, bool RCUReads >
+thread_local const sisl::ValueEntryBase* sisl::SimpleHashMap< K, V, RCUReads >::s_replaced_entry{nullptr};
 
 ///////////////////////////////////////////// SimpleHashBucket Definitions ///////////////////////////////////
-template < typename K, typename V >
+// Bucket methods expect the caller to hold lock(), which LinearHashBuckets::with_bucket() takes, except get_unlocked().
+// The chain is sorted by descending key. Nodes are linked with release stores after they are fully built, so that
+// RCU readers can walk the chain while a writer changes it.
+template < typename K, typename V, bool RCUReads >
 class SimpleHashBucket {
 private:
-#ifndef GLOBAL_HASHSET_LOCK
+    typedef SimpleHashMap< K, V, RCUReads > map_t;
+    typedef SimpleHashNode< V, RCUReads > node_t;
+    typedef decltype(node_t::m_next) link_t;
+
     mutable folly::SharedMutex m_lock;
-#endif
-    typedef boost::intrusive::slist< SingleEntryHashNode< V > > hash_node_list_t;
-    hash_node_list_t m_list;
+    link_t m_head{nullptr};
 
 public:
     SimpleHashBucket() = default;
 
     ~SimpleHashBucket() {
-        auto it{m_list.begin()};
-        while (it != m_list.end()) {
-            SingleEntryHashNode< V >* n = &*it;
-            it = m_list.erase(it);
+        node_t* n = m_head.load(std::memory_order_relaxed);
+        while (n != nullptr) {
+            node_t* next = n->m_next.load(std::memory_order_relaxed);
             delete n;
+            n = next;
         }
     }
 
-    bool insert(const K& input_key, const V& input_value, bool overwrite_ok) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::unique_lock< folly::SharedMutex >(m_lock);
-#endif
-        SingleEntryHashNode< V >* n = nullptr;
-        auto it = m_list.begin();
-        for (auto itend{m_list.end()}; it != itend; ++it) {
-            const K k = SimpleHashMap< K, V >::extractor_cb()(it->m_value);
-            if (input_key > k) {
-                break;
-            } else if (input_key == k) {
-                n = &*it;
+    folly::SharedMutex& lock() const { return m_lock; }
+    size_t size() const {
+        size_t count{0};
+        for (node_t* n = m_head.load(std::memory_order_relaxed); n != nullptr;
+             n = n->m_next.load(std::memory_order_relaxed)) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Moves the entries whose hash code moves_out() accepts to the empty bucket to, both chains stay sorted
+    void split_to(SimpleHashBucket& to, const auto& moves_out) {
+        link_t* prev = &m_head;
+        link_t* to_last = &to.m_head;
+        for (node_t* n = prev->load(std::memory_order_relaxed); n != nullptr;
+             n = prev->load(std::memory_order_relaxed)) {
+            if (moves_out(map_t::compute_hash(key_of(*n)))) {
+                prev->store(n->m_next.load(std::memory_order_relaxed), std::memory_order_release);
+                n->m_next.store(nullptr, std::memory_order_relaxed);
+                to_last->store(n, std::memory_order_release);
+                to_last = &n->m_next;
+            } else {
+                prev = &n->m_next;
             }
         }
+    }
 
+    bool insert(const K& input_key, const V& input_value, bool overwrite_ok) {
+        auto [at, n] = find(input_key);
         if (n == nullptr) {
-            n = new SingleEntryHashNode< V >(input_value);
-            m_list.insert(it, *n);
+            n = new node_t(input_value);
+            link(at, n);
             access_cb(*n, input_key, hash_op_t::CREATE);
             return true;
         } else {
             if (overwrite_ok) {
-                n->m_value = input_value;
-                access_cb(*n, input_key, hash_op_t::ACCESS);
+                if constexpr (RCUReads) {
+                    replace(at, n, new node_t(input_value), input_key);
+                } else {
+                    n->m_value = input_value;
+                    access_cb(*n, input_key, hash_op_t::ACCESS);
+                }
             }
             return false;
         }
     }
 
     bool get(const K& input_key, V& out_val) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::shared_lock< folly::SharedMutex >(m_lock);
-#endif
-        bool found{false};
-        for (const auto& n : m_list) {
-            const K k = SimpleHashMap< K, V >::extractor_cb()(n.m_value);
+        const auto [at, n] = find(input_key);
+        if (n == nullptr) { return false; }
+        access_cb(*n, input_key, hash_op_t::ACCESS);
+        out_val = n->m_value;
+        return true;
+    }
+
+    // Same as get() without the bucket lock, the caller is in a RCU read side section of a map with RCUReads
+    bool get_unlocked(const K& input_key, V& out_val) const {
+        for (const node_t* n = m_head.load(std::memory_order_acquire); n != nullptr;
+             n = n->m_next.load(std::memory_order_acquire)) {
+            const K k = key_of(*n);
             if (input_key > k) {
                 break;
             } else if (input_key == k) {
-                out_val = n.m_value;
-                found = true;
-                access_cb(n, input_key, hash_op_t::ACCESS);
-                break;
+                n->record_access();
+                out_val = n->m_value;
+                return true;
             }
         }
-        return found;
+        return false;
     }
 
     bool erase(const K& input_key, V& out_val) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::unique_lock< folly::SharedMutex >(m_lock);
-#endif
         return erase_unsafe(input_key, out_val, true /* call_access_cb */);
     }
 
     bool try_erase(const K& input_key) {
         V dummy_val;
-#ifndef GLOBAL_HASHSET_LOCK
-        if (m_lock.try_lock()) {
-            bool ret = erase_unsafe(input_key, dummy_val, false /* call_access_cb */);
-            m_lock.unlock();
-            return ret;
-        } else {
-            return false;
-        }
-#endif
-        return erase_unsafe(input_key, dummy_val, false);
+        return erase_unsafe(input_key, dummy_val, false /* call_access_cb */);
     }
 
     bool upsert_or_delete(const K& input_key, auto&& update_or_delete_cb) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::unique_lock< folly::SharedMutex >(m_lock);
-#endif
-        SingleEntryHashNode< V >* n = nullptr;
-
-        auto it = m_list.begin();
-        for (auto itend{m_list.end()}; it != itend; ++it) {
-            const K k = SimpleHashMap< K, V >::extractor_cb()(it->m_value);
-            if (input_key > k) {
-                break;
-            } else if (input_key == k) {
-                n = &*it;
-                break;
-            }
-        }
-
-        bool found{true};
-        if (n == nullptr) {
-            n = new SingleEntryHashNode< V >(V{});
-            m_list.insert(it, *n);
-            access_cb(*n, input_key, hash_op_t::CREATE);
-            found = false;
+        auto [at, n] = find(input_key);
+        const bool found{n != nullptr};
+
+        // A new node is linked only after the callback is done with it. With RCUReads, the readers could be copying
+        // the value of the existing node, so the callback updates a copy which then replaces it.
+        node_t* new_node{nullptr};
+        if (!found) {
+            new_node = new node_t(V{});
+            access_cb(*new_node, input_key, hash_op_t::CREATE);
+        } else if (RCUReads) {
+            new_node = new node_t(n->m_value);
         }
 
-        if (update_or_delete_cb(n->m_value, found)) {
-            access_cb(*n, input_key, hash_op_t::DELETE);
-            m_list.erase(it);
-            delete n;
+        if (update_or_delete_cb(new_node ? new_node->m_value : n->m_value, found)) {
+            if (found) {
+                access_cb(*n, input_key, hash_op_t::DELETE);
+                unlink(at, n);
+                retire(n);
+            } else {
+                access_cb(*new_node, input_key, hash_op_t::DELETE);
+            }
+            delete new_node;
+        } else if (!found) {
+            link(at, new_node);
+            access_cb(*new_node, input_key, hash_op_t::ACCESS);
+        } else if (new_node) {
+            replace(at, n, new_node, input_key);
         } else {
             access_cb(*n, input_key, hash_op_t::ACCESS);
         }
@@ -239,107 +325,204 @@ public:
     }
 
     bool update(const K& input_key, auto&& update_cb) {
-#ifndef GLOBAL_HASHSET_LOCK
-        auto holder = std::shared_lock< folly::SharedMutex >(m_lock);
-#endif
-        bool found{false};
-        for (auto& n : m_list) {
-            const K k = SimpleHashMap< K, V >::extractor_cb()(n.m_value);
-            if (input_key > k) {
-                break;
-            } else if (input_key == k) {
-                found = true;
-                access_cb(n, input_key, hash_op_t::ACCESS);
-                update_cb(n.m_value);
-                break;
-            }
+        auto [at, n] = find(input_key);
+        if (n == nullptr) { return false; }
+        if constexpr (RCUReads) {
+            auto* new_node = new node_t(n->m_value);
+            update_cb(new_node->m_value);
+            replace(at, n, new_node, input_key);
+        } else {
+            access_cb(*n, input_key, hash_op_t::ACCESS);
+            update_cb(n->m_value);
         }
-        return found;
+        return true;
     }
 
 private:
-    static void access_cb(const SingleEntryHashNode< V >& node, const K& key, hash_op_t op) {
-        SimpleHashMap< K, V >::call_access_cb((const ValueEntryBase&)node, key, op);
+    static void access_cb(const node_t& node, const K& key, hash_op_t op) {
+        map_t::call_access_cb((const ValueEntryBase&)node, key, op);
     }
 
-    bool erase_unsafe(const K& input_key, V& out_val, bool call_access_cb) {
-        SingleEntryHashNode< V >* n = nullptr;
+    static K key_of(const node_t& node) { return map_t::extractor_cb()(node.m_value); }
 
-        auto it = m_list.begin();
-        for (auto itend{m_list.end()}; it != itend; ++it) {
-            const K k = SimpleHashMap< K, V >::extractor_cb()(it->m_value);
+    // Returns the link where input_key belongs in the chain and the node which has the key, if any
+    std::pair< link_t*, node_t* > find(const K& input_key) {
+        link_t* prev = &m_head;
+        for (node_t* n = prev->load(std::memory_order_relaxed); n != nullptr;
+             n = prev->load(std::memory_order_relaxed)) {
+            const K k = key_of(*n);
             if (input_key > k) {
                 break;
             } else if (input_key == k) {
-                n = &*it;
-                break;
+                return {prev, n};
             }
+            prev = &n->m_next;
         }
+        return {prev, nullptr};
+    }
+
+    static void link(link_t* at, node_t* n) {
+        n->m_next.store(at->load(std::memory_order_relaxed), std::memory_order_relaxed);
+        at->store(n, std::memory_order_release);
+    }
 
-        if (n) {
-            if (call_access_cb) { access_cb(*n, input_key, hash_op_t::DELETE); }
-            out_val = n->m_value;
-            m_list.erase(it);
+    // Readers which are on n can still move on from it, since its next link stays as is
+    static void unlink(link_t* at, node_t* n) {
+        at->store(n->m_next.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    static void replace(link_t* at, node_t* old_node, node_t* new_node, const K& key) {
+        map_t::set_replaced_entry(old_node);
+        access_cb(*new_node, key, hash_op_t::REPLACE);
+        map_t::set_replaced_entry(nullptr);
+        new_node->m_next.store(old_node->m_next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        at->store(new_node, std::memory_order_release);
+        retire(old_node);
+    }
+
+    static void retire(node_t* n) {
+        if constexpr (RCUReads) {
+            call_rcu(&n->m_rcu_head, node_t::rcu_free);
+        } else {
             delete n;
-            return true;
         }
-        return false;
+    }
+
+    bool erase_unsafe(const K& input_key, V& out_val, bool call_access_cb) {
+        auto [at, n] = find(input_key);
+        if (n == nullptr) { return false; }
+        if (call_access_cb) { access_cb(*n, input_key, hash_op_t::DELETE); }
+        out_val = n->m_value;
+        unlink(at, n);
+        retire(n);
+        return true;
     }
 };
 
 ///////////////////////////////////////////// SimpleHashMap Definitions ///////////////////////////////////
-template < typename K, typename V >
-SimpleHashMap< K, V >::SimpleHashMap(uint32_t nBuckets, const key_extractor_cb_t< K, V >& extract_cb,
-                                     key_access_cb_t< K > access_cb) :
-        m_nbuckets{nBuckets}, m_key_extract_cb{extract_cb}, m_key_access_cb{std::move(access_cb)} {
-    m_buckets = new SimpleHashBucket< K, V >[nBuckets];
+template < typename K, typename V, bool RCUReads >
+SimpleHashMap< K, V, RCUReads >::SimpleHashMap(uint32_t nBuckets, const key_extractor_cb_t< K, V >& extract_cb,
+                                               key_access_cb_t< K > access_cb) :
+        m_buckets{nBuckets}, m_key_extract_cb{extract_cb}, m_key_access_cb{std::move(access_cb)} {}
+
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::insert(const K& key, const V& value) {
+#ifdef GLOBAL_HASHSET_LOCK
+    std::lock_guard< std::mutex > lk(m);
+#endif
+    set_current_instance(this);
+    const bool inserted = m_buckets.template with_bucket< std::unique_lock >(
+        compute_hash(key), [&](auto& b) { return b.insert(key, value, false /* overwrite_ok */); });
+    if (inserted) { m_buckets.entries_added(1); }
+    return inserted;
 }
 
-template < typename K, typename V >
-SimpleHashMap< K, V >::~SimpleHashMap() {
-    delete[] m_buckets;
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::upsert(const K& key, const V& value) {
+#ifdef GLOBAL_HASHSET_LOCK
+    std::lock_guard< std::mutex > lk(m);
+#endif
+    set_current_instance(this);
+    const bool inserted = m_buckets.template with_bucket< std::unique_lock >(
+        compute_hash(key), [&](auto& b) { return b.insert(key, value, true /* overwrite_ok */); });
+    if (inserted) { m_buckets.entries_added(1); }
+    return inserted;
 }
 
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::insert(const K& key, const V& value) {
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::get(const K& key, V& out_val) {
 #ifdef GLOBAL_HASHSET_LOCK
     std::lock_guard< std::mutex > lk(m);
 #endif
     set_current_instance(this);
-    return get_bucket(key).insert(key, value, false /* overwrite_ok */);
+    if constexpr (RCUReads) {
+        rcu_read_lock();
+        const bool found = m_buckets.read_unlocked(compute_hash(key),
+                                                   [&](const auto& b) { return b.get_unlocked(key, out_val); });
+        rcu_read_unlock();
+        return found;
+    }
+    return m_buckets.template with_bucket< std::shared_lock >(compute_hash(key),
+                                                              [&](auto& b) { return b.get(key, out_val); });
 }
 
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::upsert(const K& key, const V& value) {
+template < typename K, typename V, bool RCUReads >
+uint32_t SimpleHashMap< K, V, RCUReads >::multi_get(std::span< const K > keys,
+                                                    std::vector< std::pair< K, V > >& out_vals) {
 #ifdef GLOBAL_HASHSET_LOCK
     std::lock_guard< std::mutex > lk(m);
 #endif
     set_current_instance(this);
-    return get_bucket(key).insert(key, value, true /* overwrite_ok */);
+    std::vector< uint64_t > hash_codes;
+    hash_codes.reserve(keys.size());
+    for (const auto& key : keys) {
+        hash_codes.push_back(compute_hash(key));
+    }
+
+    uint32_t nfound{0};
+    V val;
+    if constexpr (RCUReads) {
+        for (const auto h : hash_codes) {
+            m_buckets.prefetch(h);
+        }
+        rcu_read_lock();
+        for (size_t i{0}; i < keys.size(); ++i) {
+            if (m_buckets.read_unlocked(hash_codes[i], [&](const auto& b) { return b.get_unlocked(keys[i], val); })) {
+                out_vals.emplace_back(keys[i], std::move(val));
+                ++nfound;
+            }
+        }
+        rcu_read_unlock();
+        return nfound;
+    }
+
+    m_buckets.template with_buckets< std::shared_lock >(hash_codes, [&](auto& b, const uint32_t i) {
+        if (b.get(keys[i], val)) {
+            out_vals.emplace_back(keys[i], std::move(val));
+            ++nfound;
+        }
+    });
+    return nfound;
 }
 
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::get(const K& key, V& out_val) {
+template < typename K, typename V, bool RCUReads >
+uint32_t SimpleHashMap< K, V, RCUReads >::multi_insert(std::span< const K > keys, std::span< const V > values) {
 #ifdef GLOBAL_HASHSET_LOCK
     std::lock_guard< std::mutex > lk(m);
 #endif
     set_current_instance(this);
-    return get_bucket(key).get(key, out_val);
+    std::vector< uint64_t > hash_codes;
+    hash_codes.reserve(keys.size());
+    for (const auto& key : keys) {
+        hash_codes.push_back(compute_hash(key));
+    }
+
+    uint32_t ninserted{0};
+    m_buckets.template with_buckets< std::unique_lock >(hash_codes, [&](auto& b, const uint32_t i) {
+        if (b.insert(keys[i], values[i], false /* overwrite_ok */)) { ++ninserted; }
+    });
+    if (ninserted) { m_buckets.entries_added(ninserted); }
+    return ninserted;
 }
 
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::erase(const K& key, V& out_val) {
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::erase(const K& key, V& out_val) {
 #ifdef GLOBAL_HASHSET_LOCK
     std::lock_guard< std::mutex > lk(m);
 #endif
     set_current_instance(this);
-    return get_bucket(key).erase(key, out_val);
+    const bool erased = m_buckets.template with_bucket< std::unique_lock >(
+        compute_hash(key), [&](auto& b) { return b.erase(key, out_val); });
+    if (erased) { m_buckets.entries_removed(1); }
+    return erased;
 }
 
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::try_erase(const K& key) {
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::try_erase(const K& key) {
     set_current_instance(this);
-    return get_bucket(key).try_erase(key);
+    const bool erased = m_buckets.try_with_bucket(compute_hash(key), [&](auto& b) { return b.try_erase(key); });
+    if (erased) { m_buckets.entries_removed(1); }
+    return erased;
 }
 
 /// This is a special atomic operation where user can insert_or_update_or_erase based on condition atomically. It
@@ -354,32 +537,40 @@ bool SimpleHashMap< K, V >::try_erase(const K& key) {
 ///    b) Return true from callback - in that case it will behave like erase operation of the KV
 ///
 /// Returns true if the value was inserted
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::upsert_or_delete(const K& key, auto&& update_or_delete_cb) {
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::upsert_or_delete(const K& key, auto&& update_or_delete_cb) {
 #ifdef GLOBAL_HASHSET_LOCK
     std::lock_guard< std::mutex > lk(m);
 #endif
     set_current_instance(this);
-    return get_bucket(key).upsert_or_delete(key, std::move(update_or_delete_cb));
+    bool deleted{false};
+    const bool inserted = m_buckets.template with_bucket< std::unique_lock >(compute_hash(key), [&](auto& b) {
+        return b.upsert_or_delete(key, [&](V& v, bool found) {
+            deleted = update_or_delete_cb(v, found);
+            return deleted;
+        });
+    });
+    if (inserted && !deleted) {
+        m_buckets.entries_added(1);
+    } else if (!inserted && deleted) {
+        m_buckets.entries_removed(1);
+    }
+    return inserted;
 }
 
-template < typename K, typename V >
-bool SimpleHashMap< K, V >::update(const K& key, auto&& update_cb) {
+template < typename K, typename V, bool RCUReads >
+bool SimpleHashMap< K, V, RCUReads >::update(const K& key, auto&& update_cb) {
 #ifdef GLOBAL_HASHSET_LOCK
     std::lock_guard< std::mutex > lk(m);
 #endif
     set_current_instance(this);
-    return get_bucket(key).update(key, std::move(update_cb));
-}
-
-template < typename K, typename V >
-SimpleHashBucket< K, V >& SimpleHashMap< K, V >::get_bucket(const K& key) const {
-    return (m_buckets[compute_hash(key) % m_nbuckets]);
-}
-
-template < typename K, typename V >
-SimpleHashBucket< K, V >& SimpleHashMap< K, V >::get_bucket(size_t hash_code) const {
-    return (m_buckets[hash_code % m_nbuckets]);
+    // With RCUReads the update replaces the node, which needs the bucket exclusively
+    if constexpr (RCUReads) {
+        return m_buckets.template with_bucket< std::unique_lock >(
+            compute_hash(key), [&](auto& b) { return b.update(key, std::move(update_cb)); });
+    }
+    return m_buckets.template with_bucket< std::shared_lock >(
+        compute_hash(key), [&](auto& b) { return b.update(key, std::move(update_cb)); });
 }
 
 } // namespace sisl
@@ -0,0 +1,313 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <sisl/cache/simple_hashmap.hpp>
+
+namespace sisl {
+
+/* Open addressing alternative to SimpleHashMap, with the same interface and callback contract, so it can be plugged
+ * into SimpleCache as its map.
+ *
+ * The map is split into shards by the hash, each with its own lock. A shard is a table of node pointers along with a
+ * control byte per slot, which is either empty, deleted or 7 bits of the hash of the key in the slot. A lookup loads
+ * the control bytes of a group of 16 slots at a time and compares them all with the hash bits in one SSE2 compare,
+ * so only the slots with a matching control byte have their node looked at. Nodes are allocated individually and
+ * never move when the table grows, so they can be cache records linked to the evictor, like in SimpleHashMap.
+ *
+ * NOTE: Readers are not lock free, there is no seqlock: get() and update() take the shard lock shared, like the bucket
+ * lock of SimpleHashMap. A reader copies the value out of the node (like a shared_ptr) and calls the ACCESS callback on
+ * it, neither of which a seqlock retry could undo if a writer freed the node meanwhile. It improves on the probing
+ * of SimpleHashMap, not on its locking. Use RCUSimpleHashMap for reads which take no lock. */
+template < typename K, typename V >
+class SwissHashMap {
+private:
+    typedef SingleEntryHashNode< V > node_t;
+
+    static constexpr int8_t s_empty{-128};  // 0b10000000
+    static constexpr int8_t s_deleted{-2};  // 0b11111110, full slots have the top bit reset
+    static constexpr uint32_t s_group_width{16};
+    static constexpr uint32_t s_max_shards{64};
+    static constexpr uint64_t s_npos{std::numeric_limits< uint64_t >::max()};
+
+    struct Shard {
+        mutable folly::SharedMutex m_lock;
+        std::vector< int8_t > m_ctrl;
+        std::vector< node_t* > m_nodes;
+        uint64_t m_size{0};
+        uint64_t m_deleted{0};
+    };
+
+    std::unique_ptr< Shard[] > m_shards;
+    uint32_t m_nshards;
+    key_extractor_cb_t< K, V > m_key_extract_cb;
+    key_access_cb_t< K > m_key_access_cb;
+
+public:
+    SwissHashMap(uint32_t nBuckets, const key_extractor_cb_t< K, V >& key_extractor,
+                 key_access_cb_t< K > access_cb = nullptr) :
+            m_key_extract_cb{key_extractor}, m_key_access_cb{std::move(access_cb)} {
+        m_nshards = std::min(s_max_shards, std::bit_floor(std::max(nBuckets / s_group_width, 1u)));
+        m_shards = std::make_unique< Shard[] >(m_nshards);
+        const uint64_t capacity{std::bit_ceil(std::max< uint64_t >(nBuckets / m_nshards, s_group_width))};
+        for (uint32_t i{0}; i < m_nshards; ++i) {
+            m_shards[i].m_ctrl.assign(capacity, s_empty);
+            m_shards[i].m_nodes.assign(capacity, nullptr);
+        }
+    }
+    SwissHashMap(const SwissHashMap&) = delete;
+    SwissHashMap& operator=(const SwissHashMap&) = delete;
+
+    ~SwissHashMap() {
+        for (uint32_t i{0}; i < m_nshards; ++i) {
+            for (node_t* n : m_shards[i].m_nodes) {
+                delete n;
+            }
+        }
+    }
+
+    bool insert(const K& key, const V& value) { return insert(key, value, false /* overwrite_ok */); }
+    bool upsert(const K& key, const V& value) { return insert(key, value, true /* overwrite_ok */); }
+
+    // Takes the shard lock shared, see the note above
+    bool get(const K& input_key, V& out_val) {
+        const uint64_t h{mixed_hash(input_key)};
+        Shard& s{get_shard(h)};
+        auto holder = std::shared_lock< folly::SharedMutex >(s.m_lock);
+        const uint64_t idx{find(s, input_key, h)};
+        if (idx == s_npos) { return false; }
+        const node_t* n{s.m_nodes[idx]};
+        out_val = n->m_value;
+        access_cb(*n, input_key, hash_op_t::ACCESS);
+        return true;
+    }
+
+    bool erase(const K& key, V& out_val) {
+        const uint64_t h{mixed_hash(key)};
+        Shard& s{get_shard(h)};
+        auto holder = std::unique_lock< folly::SharedMutex >(s.m_lock);
+        const uint64_t idx{find(s, key, h)};
+        if (idx == s_npos) { return false; }
+        node_t* n{s.m_nodes[idx]};
+        access_cb(*n, key, hash_op_t::DELETE);
+        out_val = n->m_value;
+        erase_slot(s, idx);
+        delete n;
+        return true;
+    }
+
+    // Same as erase, but gives up if the shard is locked, as it is called by the evictor while adding another record
+    bool try_erase(const K& key) {
+        const uint64_t h{mixed_hash(key)};
+        Shard& s{get_shard(h)};
+        auto holder = std::unique_lock< folly::SharedMutex >(s.m_lock, std::try_to_lock);
+        if (!holder.owns_lock()) { return false; }
+        const uint64_t idx{find(s, key, h)};
+        if (idx == s_npos) { return false; }
+        node_t* n{s.m_nodes[idx]};
+        erase_slot(s, idx);
+        delete n;
+        return true;
+    }
+
+    // Takes the shard lock shared, like SimpleHashMap::update(), so update_cb synchronizes its changes to the value
+    bool update(const K& key, auto&& update_cb) {
+        const uint64_t h{mixed_hash(key)};
+        Shard& s{get_shard(h)};
+        auto holder = std::shared_lock< folly::SharedMutex >(s.m_lock);
+        const uint64_t idx{find(s, key, h)};
+        if (idx == s_npos) { return false; }
+        node_t* n{s.m_nodes[idx]};
+        access_cb(*n, key, hash_op_t::ACCESS);
+        update_cb(n->m_value);
+        return true;
+    }
+
+    /// Same as SimpleHashMap::upsert_or_delete(). Returns true if the value was inserted
+    bool upsert_or_delete(const K& key, auto&& update_or_delete_cb) {
+        const uint64_t h{mixed_hash(key)};
+        Shard& s{get_shard(h)};
+        auto holder = std::unique_lock< folly::SharedMutex >(s.m_lock);
+        uint64_t idx{find(s, key, h)};
+        bool found{true};
+        if (idx == s_npos) {
+            idx = insert_node(s, h, new node_t(V{}));
+            access_cb(*s.m_nodes[idx], key, hash_op_t::CREATE);
+            found = false;
+        }
+
+        node_t* n{s.m_nodes[idx]};
+        if (update_or_delete_cb(n->m_value, found)) {
+            access_cb(*n, key, hash_op_t::DELETE);
+            erase_slot(s, idx);
+            delete n;
+        } else {
+            access_cb(*n, key, hash_op_t::ACCESS);
+        }
+        return !found;
+    }
+
+    static size_t compute_hash(const K& key) { return SimpleHashMap< K, V >::compute_hash(key); }
+
+private:
+    bool insert(const K& key, const V& value, const bool overwrite_ok) {
+        const uint64_t h{mixed_hash(key)};
+        Shard& s{get_shard(h)};
+        auto holder = std::unique_lock< folly::SharedMutex >(s.m_lock);
+        const uint64_t idx{find(s, key, h)};
+        if (idx == s_npos) {
+            node_t* n{new node_t(value)};
+            insert_node(s, h, n);
+            access_cb(*n, key, hash_op_t::CREATE);
+            return true;
+        }
+        if (overwrite_ok) {
+            node_t* n{s.m_nodes[idx]};
+            n->m_value = value;
+            access_cb(*n, key, hash_op_t::ACCESS);
+        }
+        return false;
+    }
+
+    void access_cb(const node_t& node, const K& key, const hash_op_t op) const {
+        if (m_key_access_cb) { m_key_access_cb(static_cast< const ValueEntryBase& >(node), key, op); }
+    }
+
+    // Hash codes of small keys from compute_hash() have mostly zero upper bits, so spread them before taking the
+    // shard, the group and the control byte out of it
+    static uint64_t mixed_hash(const K& key) {
+        uint64_t h{static_cast< uint64_t >(compute_hash(key)) * 0x9E3779B97F4A7C15ULL};
+        return h ^ (h >> 29);
+    }
+    static int8_t h2(const uint64_t h) { return static_cast< int8_t >(h >> 57); }
+    Shard& get_shard(const uint64_t h) const { return m_shards[(h >> 40) & (m_nshards - 1)]; }
+
+    static uint32_t match_byte(const int8_t* group, const int8_t b) {
+#if defined(__SSE2__)
+        const __m128i ctrl{_mm_loadu_si128(reinterpret_cast< const __m128i* >(group))};
+        return static_cast< uint32_t >(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b))));
+#else
+        uint32_t mask{0};
+        for (uint32_t i{0}; i < s_group_width; ++i) {
+            if (group[i] == b) { mask |= (1u << i); }
+        }
+        return mask;
+#endif
+    }
+
+    // Both empty and deleted have the top bit set
+    static uint32_t match_empty_or_deleted(const int8_t* group) {
+#if defined(__SSE2__)
+        return static_cast< uint32_t >(
+            _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast< const __m128i* >(group))));
+#else
+        uint32_t mask{0};
+        for (uint32_t i{0}; i < s_group_width; ++i) {
+            if (group[i] < 0) { mask |= (1u << i); }
+        }
+        return mask;
+#endif
+    }
+
+    // Groups are probed with increasing strides of 1, 2, 3... groups, which visits every group of the power of two
+    // number of groups. NOTE: must be called under the shard lock
+    uint64_t find(const Shard& s, const K& key, const uint64_t h) const {
+        const uint64_t group_mask{(s.m_ctrl.size() / s_group_width) - 1};
+        uint64_t g{h & group_mask};
+        for (uint64_t probe{1}; probe <= group_mask + 1; ++probe) {
+            const int8_t* group{&s.m_ctrl[g * s_group_width]};
+            for (uint32_t m{match_byte(group, h2(h))}; m != 0; m &= (m - 1)) {
+                const uint64_t idx{g * s_group_width + std::countr_zero(m)};
+                if (m_key_extract_cb(s.m_nodes[idx]->m_value) == key) { return idx; }
+            }
+            // A key is never placed past a group with an empty slot
+            if (match_byte(group, s_empty) != 0) { break; }
+            g = (g + probe) & group_mask;
+        }
+        return s_npos;
+    }
+
+    // NOTE: must be called under the shard lock
+    static uint64_t find_insert_slot(const Shard& s, const uint64_t h) {
+        const uint64_t group_mask{(s.m_ctrl.size() / s_group_width) - 1};
+        uint64_t g{h & group_mask};
+        for (uint64_t probe{1};; ++probe) {
+            const uint32_t m{match_empty_or_deleted(&s.m_ctrl[g * s_group_width])};
+            if (m != 0) { return g * s_group_width + std::countr_zero(m); }
+            g = (g + probe) & group_mask;
+        }
+    }
+
+    // Keeps the table at most 7/8 occupied, counting the deleted slots, since they don't stop a probe either. Returns
+    // the slot of the node. NOTE: must be called under the shard lock
+    uint64_t insert_node(Shard& s, const uint64_t h, node_t* n) {
+        const uint64_t capacity{s.m_ctrl.size()};
+        if ((s.m_size + s.m_deleted + 1) * 8 > capacity * 7) {
+            // Mostly deleted slots are cleaned up in place, otherwise the table doubles
+            rehash(s, ((s.m_size + 1) * 16 > capacity * 7) ? capacity * 2 : capacity);
+        }
+        const uint64_t idx{find_insert_slot(s, h)};
+        if (s.m_ctrl[idx] == s_deleted) { --s.m_deleted; }
+        s.m_ctrl[idx] = h2(h);
+        s.m_nodes[idx] = n;
+        ++s.m_size;
+        return idx;
+    }
+
+    // NOTE: must be called under the shard lock
+    static void erase_slot(Shard& s, const uint64_t idx) {
+        // If the group has an empty slot, no probe has gone past it, so the slot can be empty again
+        const int8_t* group{&s.m_ctrl[idx - (idx % s_group_width)]};
+        if (match_byte(group, s_empty) != 0) {
+            s.m_ctrl[idx] = s_empty;
+        } else {
+            s.m_ctrl[idx] = s_deleted;
+            ++s.m_deleted;
+        }
+        s.m_nodes[idx] = nullptr;
+        --s.m_size;
+    }
+
+    // NOTE: must be called under the shard lock
+    void rehash(Shard& s, const uint64_t capacity) {
+        std::vector< int8_t > old_ctrl(capacity, s_empty);
+        std::vector< node_t* > old_nodes(capacity, nullptr);
+        old_ctrl.swap(s.m_ctrl);
+        old_nodes.swap(s.m_nodes);
+        s.m_deleted = 0;
+        for (uint64_t i{0}; i < old_ctrl.size(); ++i) {
+            if (old_ctrl[i] < 0) { continue; }
+            const uint64_t h{mixed_hash(m_key_extract_cb(old_nodes[i]->m_value))};
+            const uint64_t idx{find_insert_slot(s, h)};
+            s.m_ctrl[idx] = h2(h);
+            s.m_nodes[idx] = old_nodes[i];
+        }
+    }
+};
+
+} // namespace sisl
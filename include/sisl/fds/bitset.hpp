@@ -17,17 +17,33 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #if defined __clang__ or defined __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpedantic"
@@ -39,6 +55,7 @@
 #endif
 
 #include <sisl/logging/logging.h>
+#include "bitset_simd.hpp"
 #include "bitword.hpp"
 #include "buffer.hpp"
 
@@ -51,16 +68,32 @@
 //
 
 namespace sisl {
-struct BitBlock {
-    uint64_t start_bit;
-    uint32_t nbits;
-    BitBlock(const uint64_t start, const uint32_t bits) : start_bit{start}, nbits{bits} {}
-    BitBlock(const BitBlock&) = default;
-    BitBlock(BitBlock&&) noexcept = default;
-    BitBlock& operator=(const BitBlock&) = default;
-    BitBlock& operator=(BitBlock&&) noexcept = default;
-    ~BitBlock() = default;
-};
+/**
+ * @brief Executor for the parallel scans of the bitset. It has to call fn(part) once for every part in [0, nparts),
+ * on whichever threads it likes, and return only after all of them are done. Typically adapts a thread pool of the
+ * caller.
+ */
+using bitset_executor = std::function< void(uint32_t nparts, const std::function< void(uint32_t) >& fn) >;
+
+/**
+ * @brief Executor which runs each part on a thread of its own, for callers which don't have a thread pool at hand
+ */
+static inline bitset_executor bitset_thread_executor() {
+    return [](const uint32_t nparts, const std::function< void(uint32_t) >& fn) {
+        std::vector< std::thread > threads;
+        threads.reserve(nparts);
+        for (uint32_t part{1}; part < nparts; ++part) {
+            threads.emplace_back(fn, part);
+        }
+        if (nparts > 0) { fn(0); }
+        for (auto& t : threads) {
+            t.join();
+        }
+    };
+}
+
+template < typename Word, const bool ThreadSafeResizing >
+class FileBackedBitsetImpl;
 
 template < typename Word, const bool ThreadSafeResizing = false >
 class BitsetImpl {
@@ -126,6 +159,22 @@ private:
             return ((nbits / word_size()) + (((nbits & m_word_mask) > 0) ? 1 : 0));
         }
     };
+
+    // Serialized delta between two versions of a bitset. Words are numbered from the first (logical) bit of the
+    // bitset, irrespective of the shrink_head offset. The header is followed by m_nranges of delta_range, each
+    // followed directly by its m_nwords words.
+    struct bitset_delta_serialized {
+        uint64_t m_id;
+        uint64_t m_nbits;      // Number of bits after applying the delta
+        uint64_t m_base_nbits; // Number of bits of the bitset the delta applies to
+        uint64_t m_nranges;
+        uint32_t m_word_bits{bitword_type::bits()};
+    };
+
+    struct delta_range {
+        uint64_t m_start_word;
+        uint64_t m_nwords;
+    };
 #pragma pack()
 
     class ReadLockGuard {
@@ -170,6 +219,112 @@ private:
         BitsetImpl* const m_b;
     };
 
+    // Optional summary index over the words. Level 0 has one bit per group of summary_fanout() words and every next
+    // level has one bit per summary_fanout() bits of the level below. A set bit guarantees everything underneath it is
+    // fully set, a reset bit only means there may be reset bits underneath. It lives outside the serialized buffer,
+    // so it is never persisted and is rebuilt from the words whenever the buffer is loaded or reallocated.
+    struct bitset_summary {
+        uint8_t nlevels{0};
+        std::vector< std::vector< std::atomic< uint64_t > > > levels;
+        std::vector< uint64_t > level_nbits;
+    };
+
+    // Reset run stats of the valid bits [lo, hi) of a segment of free_run_segment_words() words. Head and tail are the
+    // reset runs touching lo and hi (both are hi - lo if the segment is entirely reset) and the rest are inner runs.
+    struct segment_free_runs {
+        uint64_t head{0};
+        uint64_t tail{0};
+        uint64_t largest{0}; // Largest inner run and where it starts
+        uint64_t largest_start{0};
+        std::array< uint32_t, 16 > histogram{}; // Count of inner runs by log2 of the length
+    };
+
+    // Optional free run index with the stats of each segment. Updates only mark the segments they touch as stale, so
+    // they stay cheap, and queries recompute the stale segments (one segment worth of words each) before using them.
+    // Like the summary, it lives outside the serialized buffer and is shared along with the buffer.
+    struct bitset_free_runs {
+        std::mutex mtx; // Serializes the recomputes done by concurrent readers
+        std::vector< segment_free_runs > segments;
+        std::vector< std::atomic< uint64_t > > stale;
+    };
+
+    // Backing file of a file backed bitset, along with a bitmap of the file pages modified since the last flush. A new
+    // one (with a dup of the fd) is made every time the buffer is remapped.
+    struct bitset_mapping {
+        int fd{-1};
+        uint8_t* base{nullptr};
+        uint64_t page_size{static_cast< uint64_t >(::sysconf(_SC_PAGESIZE))};
+        std::vector< std::atomic< uint64_t > > dirty_pages;
+
+        explicit bitset_mapping(const int file_fd) : fd{file_fd} {}
+        bitset_mapping(const bitset_mapping&) = delete;
+        bitset_mapping& operator=(const bitset_mapping&) = delete;
+        ~bitset_mapping() {
+            if (fd >= 0) { ::close(fd); }
+        }
+    };
+
+    // A copy on write snapshot of the words. It has its own serialized buffer, into which each segment of
+    // snapshot_segment_words() words is copied by whoever gets to it first: a writer right before it updates the
+    // segment or a reader of the snapshot. Until then the snapshot reads through to the live words.
+    struct snapshot_state {
+        enum : uint8_t { live = 0, copying = 1, preserved = 2 };
+
+        sisl::byte_array buf; // Serialized snapshot, valid once every segment is preserved
+        bitset_serialized* s{nullptr};
+        sisl::byte_array live_buf; // Keeps the live words around while they are needed
+        const bitword_type* live_words{nullptr};
+        uint64_t nwords{0};
+        std::vector< std::atomic< uint8_t > > segment_states;
+        std::atomic< bool > released{false};
+
+        snapshot_state(const uint64_t nbits, const uint32_t alignment_size) :
+                nwords{bitset_serialized::total_words(nbits)},
+                segment_states((nwords + snapshot_segment_words() - 1) / snapshot_segment_words()) {
+            const uint64_t size{(alignment_size > 0) ? round_up(bitset_serialized::nbytes(nbits), alignment_size)
+                                                     : bitset_serialized::nbytes(nbits)};
+            buf = make_byte_array_with_deleter(static_cast< uint32_t >(size), alignment_size);
+            s = new (buf->bytes()) bitset_serialized{0, nbits, 0, alignment_size};
+        }
+
+        // Copy the segment from the live words unless already done. If someone else is copying it, wait for it to
+        // finish, since a writer must not update the segment before the copy is complete.
+        void preserve(const uint64_t segment) {
+            auto& state{segment_states[segment]};
+            uint8_t expected{state.load(std::memory_order_acquire)};
+            if (expected == preserved) { return; }
+            if ((expected == live) && state.compare_exchange_strong(expected, copying, std::memory_order_acq_rel)) {
+                const uint64_t first{segment * snapshot_segment_words()};
+                const uint64_t last{std::min(first + snapshot_segment_words(), nwords)};
+                bitword_type* const words{s->get_words()};
+                for (uint64_t w{first}; w < last; ++w) {
+                    words[w].set(live_words[w].to_integer());
+                }
+                state.store(preserved, std::memory_order_release);
+                return;
+            }
+            while (state.load(std::memory_order_acquire) != preserved) {
+                std::this_thread::yield();
+            }
+        }
+
+        void preserve_all() {
+            for (uint64_t segment{0}; segment < segment_states.size(); ++segment) {
+                preserve(segment);
+            }
+        }
+
+        bitword_type get_word(const uint64_t word_n) {
+            preserve(word_n / snapshot_segment_words());
+            return s->get_words()[word_n];
+        }
+    };
+
+    // Snapshots which still read through to the words of the buffer. Shared along with m_buf.
+    struct bitset_snapshots {
+        std::vector< std::shared_ptr< snapshot_state > > states;
+    };
+
     static sisl::byte_array make_byte_array_with_deleter(const uint32_t sz, const uint32_t alignment = 0,
                                                          const buftag tag = buftag::bitset) {
         return std::shared_ptr< byte_array_impl >{
@@ -185,8 +340,23 @@ private:
 
     sisl::byte_array m_buf;
     bitset_serialized* m_s{nullptr};
+    std::shared_ptr< bitset_summary > m_summary; // Shared along with m_buf, since it describes the same words
+    std::shared_ptr< bitset_mapping > m_mapping; // Only for file backed bitset
+    std::shared_ptr< bitset_free_runs > m_free_runs; // Shared along with m_buf
+    std::shared_ptr< bitset_snapshots > m_snapshots; // Shared along with m_buf
     mutable folly::SharedMutex m_lock;
     static constexpr uint64_t m_word_mask{bitword_type::bits() - 1};
+    static constexpr bool atomic_words{!std::is_same_v< value_type, word_t >};
+    // The vector kernels load the words with plain loads, which race with the atomic ops of other threads on atomic
+    // words, so those are always read one word at a time through to_integer()
+    static constexpr bool vector_words{!atomic_words && bitset_simd::is_vectorizable< bitword_type >()};
+    static constexpr uint64_t summary_fanout() { return 64; }
+    static constexpr uint64_t free_run_segment_words() { return 64; }
+    static constexpr uint64_t free_run_segment_bits() { return free_run_segment_words() * bitword_type::bits(); }
+    static_assert(free_run_segment_bits() < (uint64_t{1} << 16), "free run histogram has 16 log2 buckets");
+    static constexpr uint64_t snapshot_segment_words() { return 64; }
+    static constexpr uint64_t delta_merge_gap_words() { return 2; }
+    static constexpr uint64_t parallel_part_words() { return 16 * 1024; }
 
 #ifndef NDEBUG
     static constexpr size_t compaction_threshold() { return word_size() * 10; }
@@ -199,6 +369,87 @@ public:
     static constexpr uint8_t word_size() { return bitword_type::bits(); }
 
     static constexpr uint64_t npos{std::numeric_limits< uint64_t >::max()};
+    static constexpr uint8_t max_summary_levels() { return 2; }
+
+    // Forward iterator over the maximal runs of set (or reset) bits as BitBlock. A run longer than a BitBlock can hold
+    // is split into multiple blocks. Every increment finds the run boundaries a word at a time, without taking the lock,
+    // so it must only be used through a run_range, which holds the lock or leaves it to the caller.
+    class run_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::ptrdiff_t difference_type;
+        typedef BitBlock value_type;
+        typedef const BitBlock* pointer;
+        typedef const BitBlock& reference;
+
+        run_iterator() = default;
+        run_iterator(const BitsetImpl* const bitset, const bool value) : m_b{bitset}, m_value{value} {
+            m_next = m_b->m_s->m_skip_bits;
+            advance();
+        }
+
+        reference operator*() const { return m_cur; }
+        pointer operator->() const { return &m_cur; }
+        run_iterator& operator++() {
+            advance();
+            return *this;
+        }
+        run_iterator operator++(int) {
+            run_iterator it{*this};
+            advance();
+            return it;
+        }
+        bool operator==(const run_iterator& other) const { return m_cur.start_bit == other.m_cur.start_bit; }
+        bool operator!=(const run_iterator& other) const { return !(*this == other); }
+
+    private:
+        void advance() {
+            const uint64_t end_bit{m_b->m_s->m_nbits};
+            const uint64_t start{m_b->find_actual_bit(m_next, end_bit, m_value)};
+            if (start >= end_bit) {
+                m_cur = BitBlock{npos, 0};
+                m_next = end_bit;
+                return;
+            }
+            // Continuing a run split for its length, its end is already known
+            const uint64_t stop{(start < m_run_end) ? m_run_end : m_b->find_actual_bit(start, end_bit, !m_value)};
+            const uint64_t n{std::min< uint64_t >(stop - start, std::numeric_limits< uint32_t >::max())};
+            m_cur = BitBlock{start - m_b->m_s->m_skip_bits, static_cast< uint32_t >(n)};
+            m_next = start + n;
+            m_run_end = stop;
+        }
+
+        const BitsetImpl* m_b{nullptr};
+        bool m_value{true};
+        uint64_t m_next{0};    // Actual bit to look for the next run from
+        uint64_t m_run_end{0}; // Actual bit the current run ends at
+        BitBlock m_cur{npos, 0};
+    };
+
+    // Range of the runs of set (or reset) bits for a range based for loop. A locked range holds the read lock from its
+    // creation until it is destroyed, so the bitset must not be updated by the same thread while iterating over it.
+    class run_range {
+    public:
+        run_range(const BitsetImpl* const bitset, const bool value, const bool locked) :
+                m_b{bitset}, m_value{value}, m_locked{locked} {
+            if (ThreadSafeResizing && m_locked) { m_b->m_lock.lock_shared(); }
+        }
+        run_range(const run_range&) = delete;
+        run_range& operator=(const run_range&) = delete;
+        run_range(run_range&&) noexcept = delete;
+        run_range& operator=(run_range&&) noexcept = delete;
+        ~run_range() {
+            if (ThreadSafeResizing && m_locked) { m_b->m_lock.unlock_shared(); }
+        }
+
+        run_iterator begin() const { return run_iterator{m_b, m_value}; }
+        run_iterator end() const { return run_iterator{}; }
+
+    private:
+        const BitsetImpl* const m_b;
+        const bool m_value;
+        const bool m_locked;
+    };
 
     ~BitsetImpl() {
         {
@@ -207,11 +458,13 @@ public:
         }
     }
 
-    explicit BitsetImpl(const uint64_t nbits = 0, const uint64_t m_id = 0, const uint32_t alignment_size = 0) {
+    explicit BitsetImpl(const uint64_t nbits = 0, const uint64_t m_id = 0, const uint32_t alignment_size = 0,
+                        const uint8_t summary_levels = 0) {
         const uint64_t size{(alignment_size > 0) ? round_up(bitset_serialized::nbytes(nbits), alignment_size)
                                                  : bitset_serialized::nbytes(nbits)};
         m_buf = make_byte_array_with_deleter(static_cast< uint32_t >(size), alignment_size);
         m_s = new (m_buf->bytes()) bitset_serialized{m_id, nbits, 0, alignment_size};
+        if (summary_levels > 0) { build_summary(summary_levels); }
     }
 
     // this makes a shared copy of the rhs so that modifications of the shared version
@@ -220,10 +473,15 @@ public:
         ReadLockGuard lock{&other};
         m_buf = other.m_buf;
         m_s = other.m_s;
+        m_summary = other.m_summary;
+        m_mapping = other.m_mapping;
+        m_free_runs = other.m_free_runs;
+        m_snapshots = other.m_snapshots;
     }
 
     explicit BitsetImpl(const sisl::byte_array& b,
-                        const std::optional< uint32_t > opt_alignment_size = std::optional< uint32_t >{}) {
+                        const std::optional< uint32_t > opt_alignment_size = std::optional< uint32_t >{},
+                        const uint8_t summary_levels = 0) {
         // NOTE: This assumes that the passed byte_array already has an initialized bitset_serialized structure
         // Also assume that the words byte array contains packed word_t data since packed Word data is illegal
         // with any class besides POD
@@ -241,8 +499,50 @@ public:
         const word_t* b_words{reinterpret_cast< const word_t* >(b->cbytes() + sizeof(bitset_serialized))};
         // copy the data
         std::uninitialized_copy(b_words, std::next(b_words, m_s->m_words_cap), m_s->get_words());
+        if (summary_levels > 0) { build_summary(summary_levels); }
+    }
+
+    // File backed bitsets cannot be shared, see FileBackedBitsetImpl. Use copy function to get an independent copy
+    BitsetImpl(const FileBackedBitsetImpl< Word, ThreadSafeResizing >&) = delete;
+    BitsetImpl& operator=(const FileBackedBitsetImpl< Word, ThreadSafeResizing >&) = delete;
+
+protected:
+    // Construct a bitset backed by a memory mapped file, see FileBackedBitsetImpl
+    explicit BitsetImpl(const std::string& file_path, const std::optional< uint64_t > nbits,
+                        const std::optional< uint64_t > id, const uint8_t summary_levels) {
+        static_assert(bitset_simd::is_vectorizable< bitword_type >(),
+                      "File backed bitset needs words which are laid out as plain 64 bit integers");
+        const int fd{::open(file_path.c_str(), O_RDWR | O_CREAT, 0644)};
+        if (fd < 0) { throw std::system_error(errno, std::generic_category(), "Unable to open " + file_path); }
+        m_mapping = std::make_shared< bitset_mapping >(fd);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) { throw std::system_error(errno, std::generic_category(), "fstat " + file_path); }
+        if (st.st_size == 0) {
+            map_file(bitset_serialized::nbytes(nbits.value_or(0)));
+            m_s = new (m_buf->bytes()) bitset_serialized{id.value_or(0), nbits.value_or(0), 0, 0};
+            mark_dirty(0, m_buf->size());
+        } else {
+            alignas(bitset_serialized) uint8_t hdr_buf[sizeof(bitset_serialized)];
+            const bitset_serialized* const hdr{reinterpret_cast< const bitset_serialized* >(hdr_buf)};
+            if ((static_cast< uint64_t >(st.st_size) < sizeof(bitset_serialized)) ||
+                (::pread(fd, hdr_buf, sizeof(hdr_buf), 0) != static_cast< ssize_t >(sizeof(hdr_buf))) ||
+                (hdr->m_word_bits != bitword_type::bits()) ||
+                (bitset_serialized::nbytes(hdr->m_nbits) > static_cast< uint64_t >(st.st_size))) {
+                throw std::runtime_error("File " + file_path + " does not have a valid bitset");
+            }
+            if ((nbits && (*nbits != hdr->m_nbits - hdr->m_skip_bits)) || (id && (*id != hdr->m_id))) {
+                throw std::invalid_argument("File " + file_path + " has a bitset of " +
+                                            std::to_string(hdr->m_nbits - hdr->m_skip_bits) + " bits with id " +
+                                            std::to_string(hdr->m_id) + ", not the one asked for");
+            }
+            map_file(bitset_serialized::nbytes(hdr->m_nbits));
+            m_s = reinterpret_cast< bitset_serialized* >(m_buf->bytes());
+        }
+        if (summary_levels > 0) { build_summary(summary_levels); }
     }
 
+public:
     explicit BitsetImpl(const word_t* const start_ptr, const word_t* const end_ptr, const uint64_t id = 0,
                         const uint32_t alignment_size = 0) {
         assert(end_ptr >= start_ptr);
@@ -277,6 +577,10 @@ public:
         WriteLockGuard lock{&other};
         m_buf = std::move(other.m_buf);
         m_s = std::move(other.m_s);
+        m_summary = std::move(other.m_summary);
+        m_mapping = std::move(other.m_mapping);
+        m_free_runs = std::move(other.m_free_runs);
+        m_snapshots = std::move(other.m_snapshots);
         other.m_s = nullptr;
     }
 
@@ -292,6 +596,10 @@ public:
                 if (m_buf != rhs.m_buf) {
                     m_buf = rhs.m_buf;
                     m_s = rhs.m_s;
+                    m_summary = rhs.m_summary;
+                    m_mapping = rhs.m_mapping;
+                    m_free_runs = rhs.m_free_runs;
+                    m_snapshots = rhs.m_snapshots;
                 }
             }
         }
@@ -307,9 +615,17 @@ public:
                 if (m_buf != rhs.m_buf) {
                     m_buf = std::move(rhs.m_buf);
                     m_s = std::move(rhs.m_s);
+                    m_summary = std::move(rhs.m_summary);
+                    m_mapping = std::move(rhs.m_mapping);
+                    m_free_runs = std::move(rhs.m_free_runs);
+                    m_snapshots = std::move(rhs.m_snapshots);
                 } else {
                     // already sharing same buffer so just clear
                     rhs.m_buf.reset();
+                    rhs.m_summary.reset();
+                    rhs.m_mapping.reset();
+                    rhs.m_free_runs.reset();
+                    rhs.m_snapshots.reset();
                 }
                 rhs.m_s = nullptr;
             }
@@ -320,37 +636,7 @@ public:
     // get word size value.  data is stored in LSB to MSB order into the bitset
     word_t get_word_value(const uint64_t start_bit) const {
         ReadLockGuard lock{this};
-        const bitword_type* word_ptr{get_word_const(start_bit)};
-        if (!word_ptr) { return word_t{}; }
-
-        word_t val{word_ptr->to_integer()};
-        const uint8_t offset{get_word_offset(start_bit)};
-        uint64_t bits_remaining{total_bits() - start_bit};
-        if (offset > 0) {
-            // compose from multiple words
-            const uint8_t word_bits_remaining{static_cast< uint8_t >(word_size() - offset)};
-            const uint8_t valid_low_bits{
-                static_cast< uint8_t >((bits_remaining > word_bits_remaining) ? word_bits_remaining : bits_remaining)};
-            const word_t low_mask{static_cast< word_t >(consecutive_bitmask[valid_low_bits - 1])};
-            val = static_cast< word_t >(val >> offset) & low_mask;
-            bits_remaining -= valid_low_bits;
-
-            // add from next word if word_t size word spans two words
-            if (bits_remaining > 0) {
-                const uint8_t valid_high_bits{
-                    static_cast< uint8_t >((bits_remaining > offset) ? offset : bits_remaining)};
-                const word_t high_mask{static_cast< word_t >(consecutive_bitmask[valid_high_bits - 1])};
-                val |= static_cast< word_t >(((++word_ptr)->to_integer() & high_mask) << valid_low_bits);
-            }
-        } else {
-            // single word optimization
-            if (bits_remaining < word_size()) {
-                const word_t mask{static_cast< word_t >(consecutive_bitmask[bits_remaining - 1])};
-                val &= mask;
-            }
-        }
-
-        return val;
+        return get_word_value_impl(start_bit);
     }
 
     bool operator==(const BitsetImpl& rhs) const {
@@ -468,6 +754,61 @@ public:
 
     bool operator!=(const BitsetImpl& rhs) const { return !(operator==(rhs)); }
 
+    /**
+     * @brief Is this bitset backed by a memory mapped file
+     */
+    bool is_file_backed() const {
+        ReadLockGuard lock{this};
+        return static_cast< bool >(m_mapping);
+    }
+
+    /**
+     * @brief Number of pages of a file backed bitset modified since the last flush_dirty()
+     */
+    uint64_t dirty_page_count() const {
+        ReadLockGuard lock{this};
+        if (!m_mapping) { return 0; }
+        uint64_t count{0};
+        for (const auto& w : m_mapping->dirty_pages) {
+            count += get_set_bit_count(w.load(std::memory_order_relaxed));
+        }
+        return count;
+    }
+
+    /**
+     * @brief Write back to the file only the pages modified since the last flush. It can be called concurrently with
+     * set/reset of bits, in which case bits updated after the flush started may or may not be part of this flush, but
+     * will be part of the next one. It is a no-op for a bitset which is not file backed.
+     *
+     * @return uint64_t Number of pages written back. Throws std::system_error if msync fails.
+     */
+    uint64_t flush_dirty() {
+        ReadLockGuard lock{this};
+        if (!m_mapping) { return 0; }
+
+        const uint64_t page_size{m_mapping->page_size};
+        uint64_t flushed{0};
+        for (uint64_t w{0}; w < m_mapping->dirty_pages.size(); ++w) {
+            auto& dirty{m_mapping->dirty_pages[w]};
+            if (dirty.load(std::memory_order_relaxed) == 0) { continue; }
+            uint64_t pages{dirty.exchange(0, std::memory_order_acq_rel)};
+            while (pages != 0) {
+                // write back each run of dirty pages in one go
+                const uint8_t first{get_trailing_zeros(pages)};
+                const uint8_t run{get_trailing_zeros(~(pages >> first))};
+                const uint64_t run_mask{(run == 64) ? ~uint64_t{0} : (consecutive_bitmask[run - 1] << first)};
+                if (::msync(m_mapping->base + (w * 64 + first) * page_size, run * page_size, MS_SYNC) != 0) {
+                    const int err{errno};
+                    dirty.fetch_or(pages, std::memory_order_relaxed);
+                    throw std::system_error(err, std::generic_category(), "msync of bitset file failed");
+                }
+                pages &= ~run_mask;
+                flushed += run;
+            }
+        }
+        return flushed;
+    }
+
     uint64_t get_id() const {
         ReadLockGuard lock{this};
         assert(m_s);
@@ -478,6 +819,7 @@ public:
         WriteLockGuard lock{this};
         assert(m_s);
         m_s->m_id = id;
+        if (m_mapping) { mark_dirty(0, sizeof(bitset_serialized)); }
     }
 
     // create deep copy of other bitset
@@ -509,6 +851,32 @@ public:
         }
     }
 
+    /**
+     * @brief Bitwise and/or/xor of other bitset into this bitset (this = this op other), andnot_with clears the bits
+     * that are set in other (this = this & ~other). Operates on the first min(size(), other.size()) bits and the rest
+     * of the bits of this bitset are left as is. Bitsets with different shrink_head offsets are aligned to this
+     * bitset's words before applying the op, in blocks of words.
+     *
+     * NOTE: For atomic words every word is updated atomically, but the op as a whole is not atomic w.r.t concurrent
+     * updates on this bitset unless ThreadSafeResizing is set.
+     */
+    void and_with(const BitsetImpl& other) { apply_bitwise(other, bitwise_op::and_with); }
+    void or_with(const BitsetImpl& other) { apply_bitwise(other, bitwise_op::or_with); }
+    void xor_with(const BitsetImpl& other) { apply_bitwise(other, bitwise_op::xor_with); }
+    void andnot_with(const BitsetImpl& other) { apply_bitwise(other, bitwise_op::andnot_with); }
+
+    /**
+     * @brief Number of bits set in both this and other bitset (popcount of this & other) within the first
+     * min(size(), other.size()) bits, without materializing the result.
+     */
+    uint64_t popcount_of_and(const BitsetImpl& other) const { return popcount_bitwise(other, false); }
+
+    /**
+     * @brief Number of bits set in this bitset and not in other bitset (popcount of this & ~other) within the first
+     * min(size(), other.size()) bits, without materializing the result.
+     */
+    uint64_t popcount_of_andnot(const BitsetImpl& other) const { return popcount_bitwise(other, true); }
+
     /**
      * @brief Serialize the bitset and return the underlying serialized buffer that can be written as is (which can be
      * used to load later)
@@ -532,9 +900,14 @@ public:
             // so return the underlying byte_array
             return m_buf;
         } else {
-            // underlying BitWord is not standard layout or different alignment or copy
+            // underlying BitWord is not standard layout or different alignment or copy. Trivial words are copied as
+            // is along with the partial first word's skip bits.
             const uint64_t num_bits{total_bits()};
-            const uint64_t total_words{bitset_serialized::total_words(num_bits)};
+            const uint64_t skip_bits{(std::is_standard_layout_v< bitword_type > && std::is_trivial_v< value_type > &&
+                                      (sizeof(value_type) == sizeof(bitword_type)))
+                                         ? uint64_t{get_word_offset(0)}
+                                         : 0};
+            const uint64_t total_words{bitset_serialized::total_words(num_bits + skip_bits)};
             const uint64_t total_bytes{sizeof(bitset_serialized) + sizeof(word_t) * total_words};
             const uint64_t size{(alignment_size > 0) ? round_up(total_bytes, alignment_size) : total_bytes};
 
@@ -553,7 +926,6 @@ public:
             if (std::is_standard_layout_v< bitword_type > && std::is_trivial_v< value_type > &&
                 (sizeof(value_type) == sizeof(bitword_type))) {
                 const size_t num_words{static_cast< size_t >(m_s->end_words_const() - get_word_const(0))};
-                const uint64_t skip_bits{get_word_offset(0)};
                 new (buf->bytes()) bitset_serialized{m_s->m_id, num_bits + skip_bits, skip_bits, alignment_size, false};
                 std::memcpy(static_cast< void* >(word_ptr), static_cast< const void* >(get_word_const(0)),
                             num_words * sizeof(word_t));
@@ -586,15 +958,241 @@ public:
             // so return the underlying byte_array
             return static_cast< uint64_t >(m_buf->size());
         } else {
-            // underlying BitWord is not standard layout or different alignment or copy
+            // underlying BitWord is not standard layout or different alignment or copy. Trivial words are copied as
+            // is along with the partial first word's skip bits.
             const uint64_t num_bits{total_bits()};
-            const uint64_t total_words{bitset_serialized::total_words(num_bits)};
+            const uint64_t skip_bits{(std::is_standard_layout_v< bitword_type > && std::is_trivial_v< value_type > &&
+                                      (sizeof(value_type) == sizeof(bitword_type)))
+                                         ? uint64_t{get_word_offset(0)}
+                                         : 0};
+            const uint64_t total_words{bitset_serialized::total_words(num_bits + skip_bits)};
             const uint64_t total_bytes{sizeof(bitset_serialized) + sizeof(word_t) * total_words};
             const uint64_t size{(alignment_size > 0) ? round_up(total_bytes, alignment_size) : total_bytes};
             return size;
         }
     }
 
+    /**
+     * @brief Serialize only the words which differ from the base version of the bitset, so that a copy of the base
+     * can be brought up to date with apply_delta() instead of shipping the entire serialize() image. Words are compared
+     * in blocks with the vector kernels and changed words separated by a small stretch of unchanged words are sent as
+     * one range, since a range header costs more than those words. Bitsets of different sizes and shrink_head offsets
+     * can be compared, the delta resizes the bitset it is applied to.
+     *
+     * NOTE: Like serialize(), the delta is consistent only if the bitsets are not updated concurrently.
+     *
+     * @param base Version of the bitset the delta is going to be applied to
+     * @return sisl::byte_array Serialized delta, its size is proportional to the number of changed words
+     */
+    const sisl::byte_array serialize_delta(const BitsetImpl& base) const {
+        if (this == &base) {
+            ReadLockGuard lock{this};
+            return serialize_delta_locked(base);
+        }
+        const BitsetImpl* first{(&m_lock < &base.m_lock) ? this : &base};
+        const BitsetImpl* second{(&m_lock < &base.m_lock) ? &base : this};
+        ReadLockGuard lock{first};
+        ReadLockGuard base_lock{second};
+        return serialize_delta_locked(base);
+    }
+
+    /**
+     * @brief Apply a delta produced by serialize_delta() of a later version against this version of the bitset.
+     * Throws std::runtime_error if the delta was not produced against a bitset of this size and word size.
+     */
+    void apply_delta(const sisl::byte_array& delta) {
+        if (delta->size() < sizeof(bitset_delta_serialized)) { throw std::runtime_error("Invalid bitset delta"); }
+        const bitset_delta_serialized* const hdr{reinterpret_cast< const bitset_delta_serialized* >(delta->cbytes())};
+
+        WriteLockGuard lock{this};
+        assert(m_s);
+        if ((hdr->m_word_bits != bitword_type::bits()) || (hdr->m_base_nbits != total_bits())) {
+            throw std::runtime_error("Bitset delta does not apply to this bitset");
+        }
+
+        // Validate the ranges up front, so that a malformed delta does not leave the bitset half updated
+        const uint64_t target_words{bitset_serialized::total_words(hdr->m_nbits)};
+        const uint8_t* ptr{delta->cbytes() + sizeof(bitset_delta_serialized)};
+        const uint8_t* const end_ptr{delta->cbytes() + delta->size()};
+        for (uint64_t r{0}; r < hdr->m_nranges; ++r) {
+            if (static_cast< uint64_t >(end_ptr - ptr) < sizeof(delta_range)) {
+                throw std::runtime_error("Invalid bitset delta");
+            }
+            const delta_range* const range{reinterpret_cast< const delta_range* >(ptr)};
+            ptr += sizeof(delta_range);
+            if ((range->m_start_word > target_words) || (range->m_nwords > (target_words - range->m_start_word)) ||
+                (static_cast< uint64_t >(end_ptr - ptr) < (range->m_nwords * sizeof(word_t)))) {
+                throw std::runtime_error("Invalid bitset delta");
+            }
+            ptr += range->m_nwords * sizeof(word_t);
+        }
+
+        if (hdr->m_nbits != total_bits()) { resize_impl(hdr->m_nbits, false); }
+        m_s->m_id = hdr->m_id;
+        if (m_mapping) { mark_dirty(0, sizeof(bitset_serialized)); }
+
+        ptr = delta->cbytes() + sizeof(bitset_delta_serialized);
+        for (uint64_t r{0}; r < hdr->m_nranges; ++r) {
+            const delta_range* const range{reinterpret_cast< const delta_range* >(ptr)};
+            ptr += sizeof(delta_range);
+            if (range->m_nwords == 0) { continue; }
+
+            const uint64_t start_bit{range->m_start_word * word_size()};
+            const uint64_t nbits{std::min(range->m_nwords * word_size(), total_bits() - start_bit)};
+            const uint64_t first_word{word_index(get_word(start_bit))};
+            const uint8_t offset{get_word_offset(start_bit)};
+            const uint64_t last_word{first_word + (offset + nbits - 1) / word_size()};
+            if (m_snapshots) { preserve_for_snapshots(first_word, offset, nbits); }
+            for (uint64_t i{0}; i < range->m_nwords; ++i, ptr += sizeof(word_t)) {
+                word_t val;
+                std::memcpy(static_cast< void* >(&val), static_cast< const void* >(ptr), sizeof(word_t));
+                store_word_value_impl(start_bit + i * word_size(), val);
+            }
+
+            if (m_summary) {
+                // Words can have both set and reset bits, so clear the groups and mark back the ones still full
+                update_summary(first_word, last_word, false);
+                update_summary(first_word, last_word, true);
+            }
+            if (m_mapping) { mark_words_dirty(first_word, last_word); }
+            if (m_free_runs) { mark_free_runs_stale(first_word, last_word); }
+        }
+    }
+
+    /**
+     * @brief Maintain a summary index of fully set word groups, which lets the reset bit searches jump over fully
+     * allocated regions instead of walking every word. Each level adds one bit per 64 groups of the level below, so
+     * 1 level summarizes 64 words per bit and 2 levels 4096 words per bit. Summary is not part of the serialized
+     * format, loading a serialized bitset needs the summary levels to be passed again.
+     *
+     * @param levels Number of summary levels [1, max_summary_levels()]
+     */
+    void enable_summary(const uint8_t levels = max_summary_levels()) {
+        WriteLockGuard lock{this};
+        build_summary(levels);
+    }
+
+    void disable_summary() {
+        WriteLockGuard lock{this};
+        m_summary.reset();
+    }
+
+    uint8_t summary_levels() const {
+        ReadLockGuard lock{this};
+        return m_summary ? m_summary->nlevels : 0;
+    }
+
+    /**
+     * @brief Maintain per segment stats of the reset runs (head/tail runs, largest inner run and a log2 histogram of
+     * the inner runs), so that best fit and largest extent queries only look inside the segments which can have the
+     * answer. Like the summary, it is not part of the serialized format.
+     */
+    void enable_free_run_index() {
+        WriteLockGuard lock{this};
+        m_free_runs = std::make_shared< bitset_free_runs >();
+        refresh_free_runs();
+    }
+
+    void disable_free_run_index() {
+        WriteLockGuard lock{this};
+        m_free_runs.reset();
+    }
+
+    bool is_free_run_index_enabled() const {
+        ReadLockGuard lock{this};
+        return static_cast< bool >(m_free_runs);
+    }
+
+    /**
+     * @brief Read only view of the bitset as of the time snapshot() was taken. It stays the same while the bitset
+     * continues to be updated and remains valid even after the bitset is gone.
+     */
+    class Snapshot {
+    public:
+        explicit Snapshot(std::shared_ptr< snapshot_state > state) : m_state{std::move(state)} {}
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&&) noexcept = default;
+        Snapshot& operator=(Snapshot&&) noexcept = delete;
+        ~Snapshot() {
+            // Writers stop preserving segments for it
+            if (m_state) { m_state->released.store(true, std::memory_order_relaxed); }
+        }
+
+        uint64_t get_id() const { return m_state->s->m_id; }
+        uint64_t size() const { return m_state->s->m_nbits - m_state->s->m_skip_bits; }
+
+        bool get_bitval(const uint64_t bit) const {
+            if (bit >= size()) { throw std::out_of_range("Bit not in range"); }
+            const uint64_t phys_bit{bit + m_state->s->m_skip_bits};
+            return m_state->get_word(phys_bit / word_size()).get_bitval(static_cast< uint8_t >(phys_bit & m_word_mask));
+        }
+
+        uint64_t get_set_count() const {
+            const uint64_t skip_bits{m_state->s->m_skip_bits};
+            const uint64_t nbits{m_state->s->m_nbits};
+            uint64_t count{0};
+            for (uint64_t bit{skip_bits}; bit < nbits;) {
+                const uint8_t offset{static_cast< uint8_t >(bit & m_word_mask)};
+                const uint8_t n{static_cast< uint8_t >(std::min< uint64_t >(word_size() - offset, nbits - bit))};
+                const word_t val{static_cast< word_t >(m_state->get_word(bit / word_size()).to_integer() >> offset)};
+                count += get_set_bit_count(static_cast< word_t >(val & consecutive_bitmask[n - 1]));
+                bit += n;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Serialized form of the snapshot, in the same format as BitsetImpl::serialize() and thus can be
+         * loaded as a bitset. Copies the segments not yet copied and returns the snapshot's own buffer as is.
+         */
+        const sisl::byte_array serialize() const {
+            m_state->preserve_all();
+            return m_state->buf;
+        }
+
+    private:
+        std::shared_ptr< snapshot_state > m_state;
+    };
+
+    /**
+     * @brief Take a copy on write snapshot of the bitset. The snapshot buffer is allocated without holding the lock
+     * and the writers are paused only to publish the snapshot, which does not depend on the size of the bitset. After
+     * that, every segment of words is copied into the snapshot by the first writer updating it (or by a reader of the
+     * snapshot), so each segment is copied at most once per snapshot. Resize, shrink_head compaction, copy and the
+     * bulk bitwise ops copy all the remaining segments of the snapshots before they rewrite the words.
+     *
+     * NOTE: Writers are paused through the bitset lock, so consistency is guaranteed only with ThreadSafeResizing
+     * and only for updates made through this bitset (and not through shared copies of it having their own lock).
+     */
+    Snapshot snapshot() {
+        while (true) {
+            uint64_t nbits{0};
+            uint32_t alignment_size{0};
+            {
+                ReadLockGuard lock{this};
+                nbits = m_s->m_nbits;
+                alignment_size = m_s->m_alignment_size;
+            }
+            auto state{std::make_shared< snapshot_state >(nbits, alignment_size)};
+
+            WriteLockGuard lock{this};
+            // Resized in between, retry with the new size
+            if ((m_s->m_nbits != nbits) || (m_s->m_alignment_size != alignment_size)) { continue; }
+            state->s->m_id = m_s->m_id;
+            state->s->m_skip_bits = m_s->m_skip_bits;
+            state->live_buf = m_buf;
+            state->live_words = m_s->get_words_const();
+            if (!m_snapshots) { m_snapshots = std::make_shared< bitset_snapshots >(); }
+            auto& states{m_snapshots->states};
+            states.erase(std::remove_if(std::begin(states), std::end(states),
+                                        [](const auto& st) { return st->released.load(std::memory_order_relaxed); }),
+                         std::end(states));
+            states.push_back(state);
+            return Snapshot{std::move(state)};
+        }
+    }
+
     /**
      * @brief Get total bits available in this bitset
      *
@@ -650,6 +1248,117 @@ public:
         return set_cnt;
     }
 
+    /**
+     * @brief Parallel version of get_set_count(). Words of the range are split into upto nparts parts, which are
+     * counted on the executor and summed up. Parts are not made smaller than parallel_part_words() words, so a small
+     * range is counted on the calling thread itself.
+     */
+    uint64_t get_set_count(const bitset_executor& executor, const uint32_t nparts, const uint64_t start_bit = 0,
+                           const uint64_t end_bit = std::numeric_limits< uint64_t >::max()) const {
+        ReadLockGuard lock{this};
+        assert(end_bit >= start_bit);
+        if (start_bit >= total_bits()) { return 0; }
+        const uint64_t lo{start_bit + m_s->m_skip_bits};
+        const uint64_t hi{std::min(total_bits() - 1, end_bit) + m_s->m_skip_bits + 1};
+
+        std::vector< uint64_t > counts(std::max(nparts, 1u), 0);
+        run_parts(executor, nparts, lo, hi,
+                  [this, &counts](const uint32_t part, const uint64_t part_lo, const uint64_t part_hi) {
+                      counts[part] = count_actual_set_bits(part_lo, part_hi);
+                  });
+        return std::accumulate(std::begin(counts), std::end(counts), uint64_t{0});
+    }
+
+    /**
+     * @brief Call fn(start_bit, nbits) for every maximal run of set bits, in the order of the bits. Read lock is taken
+     * once for the entire walk, so fn must not update this bitset.
+     */
+    void foreach_set_range(const std::function< void(uint64_t, uint64_t) >& fn) const {
+        ReadLockGuard lock{this};
+        if (total_bits() == 0) { return; }
+        set_runs_of_part(m_s->m_skip_bits, m_s->m_nbits, fn);
+    }
+
+    /**
+     * @brief Parallel version of foreach_set_range(). Words are split into upto nparts parts walked on the executor and
+     * each run is reported exactly once, by the part it starts in, even if it extends into the next parts. So fn is
+     * called concurrently from the parts and the order of the runs across parts is not defined.
+     */
+    void foreach_set_range(const bitset_executor& executor, const uint32_t nparts,
+                           const std::function< void(uint64_t, uint64_t) >& fn) const {
+        ReadLockGuard lock{this};
+        if (total_bits() == 0) { return; }
+        run_parts(executor, nparts, m_s->m_skip_bits, m_s->m_nbits,
+                  [this, &fn](const uint32_t, const uint64_t part_lo, const uint64_t part_hi) {
+                      set_runs_of_part(part_lo, part_hi, fn);
+                  });
+    }
+
+    /**
+     * @brief Runs of set bits as extents, in the order of the bits. A run longer than a BitBlock can hold is split
+     * into multiple extents.
+     */
+    std::vector< BitBlock > to_extents() const {
+        std::vector< BitBlock > extents;
+        foreach_set_range(
+            [&extents](const uint64_t start, const uint64_t nbits) { add_extents(extents, start, nbits); });
+        return extents;
+    }
+
+    /**
+     * @brief Parallel version of to_extents(). Each part collects the runs starting in it and the parts are
+     * concatenated in order.
+     */
+    std::vector< BitBlock > to_extents(const bitset_executor& executor, const uint32_t nparts) const {
+        std::vector< std::vector< BitBlock > > part_extents(std::max(nparts, 1u));
+        {
+            ReadLockGuard lock{this};
+            if (total_bits() == 0) { return {}; }
+            run_parts(executor, nparts, m_s->m_skip_bits, m_s->m_nbits,
+                      [this, &part_extents](const uint32_t part, const uint64_t part_lo, const uint64_t part_hi) {
+                          auto& extents{part_extents[part]};
+                          set_runs_of_part(part_lo, part_hi, [&extents](const uint64_t start, const uint64_t nbits) {
+                              add_extents(extents, start, nbits);
+                          });
+                      });
+        }
+
+        std::vector< BitBlock > extents;
+        size_t total{0};
+        for (const auto& pe : part_extents) {
+            total += pe.size();
+        }
+        extents.reserve(total);
+        for (const auto& pe : part_extents) {
+            extents.insert(std::end(extents), std::begin(pe), std::end(pe));
+        }
+        return extents;
+    }
+
+    /**
+     * @brief Range over the runs of set bits as BitBlock, in the order of the bits. The read lock is taken once and held
+     * until the range is destroyed, so the bitset must not be updated from within the loop.
+     *
+     * for (const auto& b : bset.set_runs()) { ... }
+     */
+    run_range set_runs() const { return run_range{this, true, true}; }
+
+    /**
+     * @brief Range over the runs of reset bits as BitBlock, in the order of the bits. Locking is same as set_runs().
+     */
+    run_range reset_runs() const { return run_range{this, false, true}; }
+
+    /**
+     * @brief Same as set_runs(), but without taking the lock. Caller must make sure the bitset is not resized or
+     * reloaded while iterating, either by its own synchronization or because there is no concurrent user.
+     */
+    run_range set_runs_unlocked() const { return run_range{this, true, false}; }
+
+    /**
+     * @brief Same as reset_runs(), but without taking the lock, see set_runs_unlocked().
+     */
+    run_range reset_runs_unlocked() const { return run_range{this, false, false}; }
+
     /**
      * @brief Set the bit. If the bit is outside the available range throws std::out_of_range exception
      *
@@ -680,6 +1389,18 @@ public:
      */
     void reset_bits(const uint64_t start, const uint64_t nbits) { set_reset_bits(start, nbits, false); }
 
+    /**
+     * @brief Set the bits of a batch of blocks in a single pass under the lock. The blocks can be in any order and can
+     * overlap, adjacent blocks are merged and whole words are stored in one go. If any of the blocks is outside the
+     * available range, throws std::out_of_range exception without updating any bits.
+     */
+    void set_bits_batch(const std::span< const BitBlock > blocks) { set_reset_bits_batch(blocks, true); }
+
+    /**
+     * @brief Reset the bits of a batch of blocks in a single pass under the lock, see set_bits_batch()
+     */
+    void reset_bits_batch(const std::span< const BitBlock > blocks) { set_reset_bits_batch(blocks, false); }
+
     /**
      * @brief Is a particular bit is set/reset. If the bit is outside the available range throws std::out_of_range
      * exception
@@ -760,7 +1481,14 @@ public:
         if (nbits > total_bits()) {
             throw std::out_of_range("Right shift to out of range");
         } else {
+            const uint64_t old_skip_bits{m_s->m_skip_bits};
             m_s->m_skip_bits += nbits;
+            if (m_mapping) { mark_dirty(0, sizeof(bitset_serialized)); }
+            if (m_free_runs && (m_s->m_words_cap > 0)) {
+                // Skipped bits are no longer part of any run
+                mark_free_runs_stale(old_skip_bits / word_size(),
+                                     std::min(m_s->m_skip_bits / word_size(), m_s->m_words_cap - 1));
+            }
             if (m_s->m_skip_bits >= compaction_threshold()) { resize_impl(total_bits(), false); }
         }
     }
@@ -810,67 +1538,167 @@ public:
     BitBlock get_next_contiguous_n_reset_bits(const uint64_t start_bit, const std::optional< uint64_t > end_bit,
                                               const uint32_t min_needed, const uint32_t max_needed) const {
         ReadLockGuard lock{this};
-        BitBlock retb{start_bit, 0};
+        return get_next_contiguous_n_reset_bits_impl(start_bit, end_bit, min_needed, max_needed);
+    }
 
-        const bitword_type* word_ptr{get_word_const(start_bit)};
-        if (!word_ptr) { return {npos, 0}; }
-        uint8_t offset{get_word_offset(start_bit)};
-        uint64_t current_bit{start_bit};
-        const uint64_t final_bit{end_bit ? std::min(*end_bit + 1, total_bits()) : total_bits()};
-
-        while ((retb.nbits < max_needed) && (current_bit < final_bit)) {
-            const bit_filter filter{(retb.nbits >= min_needed)
-                                        ? static_cast< uint32_t >(1)
-                                        : std::min< uint32_t >(min_needed - retb.nbits, word_size()),
-                                    min_needed, static_cast< uint32_t >(1)};
-            const auto result{word_ptr->get_next_reset_bits_filtered(offset, filter)};
-            LOGTRACE("current_bit={} word filter={} result={}", current_bit, filter.to_string(), result.to_string());
-
-            if (result.match_type == bit_match_type::full_match) {
-                // We got the entire word, keep adding to the chain
-                assert(offset == 0);
-                retb.nbits += result.count;
-            } else if (result.match_type == bit_match_type::lsb_match) {
-                // We got atleast min from the chain, keep adding to the chain
-                assert(offset == 0);
-                retb.nbits += result.count;
-                if (retb.nbits >= min_needed) { break; }
-            } else if (result.match_type == bit_match_type::mid_match) {
-                assert(result.count >= min_needed);
-                if (result.count > retb.nbits) { retb = {current_bit + result.start_bit - offset, result.count}; }
-                break;
-            } else if (result.match_type == bit_match_type::msb_match) {
-                if (retb.nbits >= min_needed) { break; } // It has met the min with previous scan, use it - greedy algo
-                retb = {current_bit + result.start_bit - offset, result.count};
-            } else if (result.match_type == bit_match_type::no_match) {
-                if (retb.nbits >= min_needed) { break; } // It has met the min with previous scan, use it - greedy algo
-                retb = {current_bit + word_size() - offset, 0}; // Reset everything and start over
+    /**
+     * @brief Get the smallest run of reset bits which is at least n bits long in the range [start_bit, end_bit]
+     * inclusive. Allocating from the best fit run instead of the first fit keeps the larger runs intact. Ties are
+     * broken by the lowest start bit.
+     *
+     * @param n Minimum number of reset bits needed
+     * @param start_bit Start bit to search from
+     * @param end_bit Optional End bit to search to inclusive; otherwise to end of set
+     *
+     * @return BitBlock Start bit and the length of the entire run (capped to uint32_t max), which can be more than n.
+     * If there is no such run, start bit is npos and nbits is 0.
+     */
+    BitBlock get_best_fit_contiguous_reset_bits(const uint32_t n, const uint64_t start_bit = 0,
+                                                const std::optional< uint64_t > end_bit = std::nullopt) const {
+        ReadLockGuard lock{this};
+        assert(n > 0);
+        const uint8_t n_bucket{logBase2(static_cast< uint64_t >(n))};
+        uint64_t best_start{npos};
+        uint64_t best_len{0};
+        const auto consider{[&best_start, &best_len, n](const uint64_t start, const uint64_t len) {
+            if ((len >= n) && ((best_len == 0) || (len < best_len))) {
+                best_start = start;
+                best_len = len;
             }
+            return (best_len != n); // Nothing fits better than exact fit
+        }};
+
+        walk_free_runs(
+            start_bit, end_bit, consider,
+            [this, &consider, &best_len, n, n_bucket](const segment_free_runs& st, const uint64_t lo,
+                                                      const uint64_t hi) {
+                if (st.largest < n) { return true; }
+                if (best_len > 0) {
+                    // Lower bound of the inner runs >= n from the histogram, skip if none of them can beat best
+                    uint8_t b{n_bucket};
+                    while (st.histogram[b] == 0) {
+                        ++b;
+                    }
+                    if (((b == n_bucket) ? n : (uint64_t{1} << b)) >= best_len) { return true; }
+                }
+                bool keep_going{true};
+                for_each_run(lo + st.head, hi - st.tail, false,
+                                   [this, &consider, &keep_going](const uint64_t start, const uint64_t len) {
+                                       keep_going = consider(start - m_s->m_skip_bits, len);
+                                       return keep_going;
+                                   });
+                return keep_going;
+            });
+        return BitBlock{best_start, static_cast< uint32_t >(
+                                        std::min< uint64_t >(best_len, std::numeric_limits< uint32_t >::max()))};
+    }
 
-            current_bit += (word_size() - offset);
-            offset = 0;
-            ++word_ptr;
-        }
+    /**
+     * @brief Get the largest run of reset bits in the range [start_bit, end_bit] inclusive, the lowest one if there
+     * are multiple of them.
+     *
+     * @return BitBlock Start bit and length of the run (capped to uint32_t max). If everything is set, start bit is
+     * npos and nbits is 0.
+     */
+    BitBlock get_largest_contiguous_reset_bits(const uint64_t start_bit = 0,
+                                               const std::optional< uint64_t > end_bit = std::nullopt) const {
+        ReadLockGuard lock{this};
+        uint64_t best_start{npos};
+        uint64_t best_len{0};
+        walk_free_runs(
+            start_bit, end_bit,
+            [&best_start, &best_len](const uint64_t start, const uint64_t len) {
+                if (len > best_len) {
+                    best_start = start;
+                    best_len = len;
+                }
+                return true;
+            },
+            [this, &best_start, &best_len](const segment_free_runs& st, const uint64_t, const uint64_t) {
+                if (st.largest > best_len) {
+                    best_start = st.largest_start - m_s->m_skip_bits;
+                    best_len = st.largest;
+                }
+                return true;
+            });
+        return BitBlock{best_start, static_cast< uint32_t >(
+                                        std::min< uint64_t >(best_len, std::numeric_limits< uint32_t >::max()))};
+    }
 
-        if (retb.nbits > 0) {
-            // Do alignment adjustments if need be
-            if ((retb.start_bit + retb.nbits) > final_bit) {
-                // It is an unlikely path - only when total bits are not 64 bit aligned and retb happens to be at
-                // the end
-                if (retb.start_bit >= final_bit) {
-                    retb = {npos, 0};
-                } else {
-                    retb.nbits = static_cast< uint32_t >(final_bit - retb.start_bit);
+    /**
+     * @brief Histogram of the lengths of the runs of reset bits in the range [start_bit, end_bit] inclusive, entry i
+     * is the number of runs with length in [2^i, 2^(i+1)). It is a measure of how fragmented the reset bits are.
+     */
+    std::array< uint64_t, 64 > get_free_run_histogram(const uint64_t start_bit = 0,
+                                                      const std::optional< uint64_t > end_bit = std::nullopt) const {
+        ReadLockGuard lock{this};
+        std::array< uint64_t, 64 > histogram{};
+        walk_free_runs(
+            start_bit, end_bit,
+            [&histogram](const uint64_t, const uint64_t len) {
+                ++histogram[logBase2(len)];
+                return true;
+            },
+            [&histogram](const segment_free_runs& st, const uint64_t, const uint64_t) {
+                for (size_t b{0}; b < st.histogram.size(); ++b) {
+                    histogram[b] += st.histogram[b];
                 }
-            }
-            // Note: these belong here since must be done after above since nbits may be reduced
-            if (retb.nbits > max_needed) { retb.nbits = max_needed; }
-            if (retb.nbits < min_needed) { retb = {npos, 0}; }
-        } else {
-            retb.start_bit = npos;
-        }
+                return true;
+            });
+        return histogram;
+    }
 
-        return retb;
+    /**
+     * @brief Atomically claim (set) the bit if it is reset. Unlike get_bitval() followed by set_bit(), only one of
+     * the concurrent callers claiming the same bit succeeds.
+     *
+     * NOTE: Only available for bitsets with atomic words (AtomicBitset and ThreadSafeBitset)
+     *
+     * @param bit Bit to claim
+     *
+     * @return true if the bit was reset and is now claimed, false if it was already set
+     */
+    bool claim_bit(const uint64_t bit) {
+        static_assert(atomic_words, "claim_bit needs a bitset with atomic words");
+        ReadLockGuard lock{this};
+        assert(m_s && m_s->valid_bit(bit));
+        return (claim_bits(bit, 1) == 1);
+    }
+
+    /**
+     * @brief Find the next contiguous [min_needed, max_needed] inclusive reset bits from start bit and atomically
+     * claim (set) them. Unlike get_next_contiguous_n_reset_bits() followed by set_bits(), concurrent callers never
+     * get overlapping bits, so no external lock is needed around it. Words are claimed one at a time using CAS and if
+     * another thread takes any of them before min_needed bits are claimed, the partial claim is rolled back and the
+     * search is retried.
+     *
+     * NOTE: Only available for bitsets with atomic words (AtomicBitset and ThreadSafeBitset)
+     *
+     * @param start_bit Start bit to search from
+     * @param min_needed Minimum number of reset bits needed
+     * @param max_needed Maximum number of reset bits needed
+     *
+     * @return BitBlock Returns a BitBlock of bits claimed. If no such run is available start_bit is npos with 0 bits.
+     */
+    BitBlock claim_next_contiguous_n_reset_bits(const uint64_t start_bit, const uint32_t min_needed,
+                                                const uint32_t max_needed) {
+        static_assert(atomic_words, "claim_next_contiguous_n_reset_bits needs a bitset with atomic words");
+        ReadLockGuard lock{this};
+
+        uint64_t search_bit{start_bit};
+        while (true) {
+            const BitBlock b{get_next_contiguous_n_reset_bits_impl(search_bit, std::nullopt, min_needed, max_needed)};
+            if (b.nbits == 0) { return b; }
+
+            const uint32_t claimed{claim_bits(b.start_bit, b.nbits)};
+            if (claimed >= min_needed) { return BitBlock{b.start_bit, claimed}; }
+
+            // Lost the race on part of the run, release what we got and retry from the same place
+            LOGTRACE("Lost the race to claim bits start={} nbits={} after claiming {} bits, retrying", b.start_bit,
+                     b.nbits, claimed);
+            if (claimed > 0) { set_reset_bits_impl(b.start_bit, claimed, false); }
+            search_bit = b.start_bit;
+        }
     }
 
     uint64_t get_next_reset_bit(const uint64_t start_bit) const {
@@ -889,7 +1717,18 @@ public:
             uint64_t current_bit{start_bit + (word_size() - offset)};
             uint64_t bits_remaining{current_bit > total_bits() ? 0 : total_bits() - current_bit};
             while (bits_remaining > 0) {
-                if ((++word_ptr)->get_next_reset_bit(0, &nbit)) {
+                ++word_ptr;
+                if (m_summary && ((word_index(word_ptr) % summary_fanout()) == 0)) {
+                    // jump over the groups which are known to be fully set
+                    const uint64_t skip_bits{summary_skip_words(word_index(word_ptr)) * word_size()};
+                    if (skip_bits > 0) {
+                        if (skip_bits >= bits_remaining) { break; }
+                        word_ptr += skip_bits / word_size();
+                        current_bit += skip_bits;
+                        bits_remaining -= skip_bits;
+                    }
+                }
+                if (word_ptr->get_next_reset_bit(0, &nbit)) {
                     ret = current_bit + nbit;
                     break;
                 }
@@ -902,6 +1741,76 @@ public:
         return ret;
     }
 
+    /**
+     * @brief Get the previous set bit from given bit, walking the words backwards. It takes time proportional to the
+     * distance from the start bit rather than the size of the bitset.
+     *
+     * @param start_bit Start bit before which (inclusive) search for previous bit is on. If it is beyond the size,
+     * search starts from the last bit.
+     * @return uint64_t Returns the previous set bit, if one available, else Bitset::npos is returned
+     */
+    uint64_t get_prev_set_bit(const uint64_t start_bit) const {
+        ReadLockGuard lock{this};
+        if (total_bits() == 0) { return npos; }
+        return get_prev_set_or_reset_bit_impl(std::min(start_bit, total_bits() - 1), 0, true);
+    }
+
+    /**
+     * @brief Get the previous reset bit from given bit, see get_prev_set_bit(). Groups of words which are fully set are
+     * skipped using the summary, if enabled.
+     */
+    uint64_t get_prev_reset_bit(const uint64_t start_bit) const {
+        ReadLockGuard lock{this};
+        if (total_bits() == 0) { return npos; }
+        return get_prev_set_or_reset_bit_impl(std::min(start_bit, total_bits() - 1), 0, false);
+    }
+
+    /**
+     * @brief Get the previous contiguous n reset bits ending at or before the start bit
+     */
+    BitBlock get_prev_contiguous_n_reset_bits(const uint64_t start_bit, const uint32_t n) const {
+        return get_prev_contiguous_n_reset_bits(start_bit, std::nullopt, n, n);
+    }
+
+    /**
+     * @brief Get the last contiguous [min_needed, max_needed] inclusive reset bits in the range [end_bit, start_bit]
+     * inclusive, searching backwards from the start bit. It is the mirror of get_next_contiguous_n_reset_bits(): the
+     * first run of at least min_needed reset bits found from start bit downwards is returned, trimmed to its top
+     * max_needed bits.
+     *
+     * @param start_bit Start bit to search backwards from. If it is beyond the size, search starts from the last bit.
+     * @param end_bit Optional lowest bit to search to inclusive; otherwise to the first bit of the set
+     * @param min_needed Minimum number of reset bits needed
+     * @param max_needed Maximum number of reset bits needed
+     *
+     * @return BitBlock Returns a BitBlock which provides the start bit and total number of bits found. If there is no
+     * such run, start bit is npos and nbits is 0.
+     */
+    BitBlock get_prev_contiguous_n_reset_bits(const uint64_t start_bit, const std::optional< uint64_t > end_bit,
+                                              const uint32_t min_needed, const uint32_t max_needed) const {
+        ReadLockGuard lock{this};
+        assert(min_needed > 0);
+        if (total_bits() == 0) { return {npos, 0}; }
+        const uint64_t first_bit{std::min(start_bit, total_bits() - 1)};
+        const uint64_t last_bit{end_bit ? *end_bit : 0};
+        if (last_bit > first_bit) { return {npos, 0}; }
+
+        uint64_t bit{first_bit};
+        while (true) {
+            const uint64_t top{get_prev_set_or_reset_bit_impl(bit, last_bit, false)};
+            if (top == npos) { break; }
+            const uint64_t below{(top == last_bit) ? npos : get_prev_set_or_reset_bit_impl(top - 1, last_bit, true)};
+            const uint64_t len{(below == npos) ? (top - last_bit + 1) : (top - below)};
+            if (len >= min_needed) {
+                const uint32_t nbits{static_cast< uint32_t >(std::min< uint64_t >(len, max_needed))};
+                return BitBlock{top - nbits + 1, nbits};
+            }
+            if ((below == npos) || (below == last_bit)) { break; }
+            bit = below - 1;
+        }
+        return {npos, 0};
+    }
+
     void print() const { std::cout << to_string() << std::endl; }
 
     // print out the bitset in the order last bit to first bit
@@ -951,8 +1860,11 @@ public:
 
 private:
     void copy_locked(const BitsetImpl& other) {
+        complete_snapshots();
         // ensure distinct buffers
         if ((m_buf->size() != other.m_buf->size()) || (m_buf == other.m_buf)) {
+            detach_summary();
+            detach_free_runs();
             m_buf = make_byte_array_with_deleter(other.m_buf->size(), other.m_s->m_alignment_size);
             m_s = new (m_buf->bytes()) bitset_serialized{other.m_s->m_id, other.m_s->m_nbits, other.m_s->m_skip_bits,
                                                          other.m_s->m_alignment_size, false};
@@ -980,9 +1892,13 @@ private:
                 std::copy(other.m_s->get_words_const(), other.m_s->end_words_const(), m_s->get_words());
             }
         }
+        refresh_mapping();
+        refresh_summary();
+        refresh_free_runs();
     }
 
     void copy_unshifted_locked(const BitsetImpl& other) {
+        complete_snapshots();
         const uint32_t alignment_size{other.m_s->m_alignment_size};
         const uint64_t nbits{other.total_bits()};
         const uint64_t size{(alignment_size > 0) ? round_up(bitset_serialized::nbytes(nbits), alignment_size)
@@ -991,6 +1907,8 @@ private:
         bool uninitialized{false};
         const auto old_words_cap{m_s->m_words_cap};
         if ((m_buf->size() != size) || (m_buf == other.m_buf)) {
+            detach_summary();
+            detach_free_runs();
             m_buf = make_byte_array_with_deleter(size, alignment_size);
             uninitialized = true;
         }
@@ -1075,10 +1993,96 @@ private:
                 }
             }
         }
+        refresh_mapping();
+        refresh_summary();
+        refresh_free_runs();
+    }
+
+    // NOTE: must be called under lock. Looks at the whole words starting at word_ptr (which must be word aligned to
+    // current_bit) and if they are all reset extends the retb chain or if they are all set (and no chain in progress)
+    // skips them. Returns the number of words consumed, 0 if the first word is not uniform.
+    // Only bitsets with plain words (sisl::Bitset) scan the uniform words with the vector kernels. On atomic words
+    // (AtomicBitset, ThreadSafeBitset) vector loads would race with the atomic ops of other threads, so this consumes
+    // at most one word at a time there, apart from the summary skip.
+    uint64_t skip_uniform_words(const bitword_type* const word_ptr, const uint64_t current_bit, const uint64_t final_bit,
+                                const uint32_t max_needed, BitBlock& retb) const {
+        const uint64_t avail_words{(final_bit - current_bit) / word_size()};
+        if (avail_words == 0) { return 0; }
+
+        const word_t val{word_ptr->to_integer()};
+        if (m_summary && (val == static_cast< word_t >(~word_t{})) && (retb.nbits == 0)) {
+            // Jump over the groups which are known to be fully set before looking at individual words
+            const uint64_t nwords{std::min(summary_skip_words(word_index(word_ptr)), avail_words)};
+            if (nwords > 0) {
+                retb.start_bit = current_bit + nwords * word_size();
+                return nwords;
+            }
+        }
+
+        if constexpr (vector_words) {
+            const uint64_t* const words{reinterpret_cast< const uint64_t* >(word_ptr)};
+            if (val == word_t{}) {
+                const uint64_t needed_words{(max_needed - retb.nbits + word_size() - 1) / word_size()};
+                const uint64_t nwords{
+                    bitset_simd::count_equal_words(words, std::min(avail_words, needed_words), uint64_t{0})};
+                if (retb.nbits == 0) { retb.start_bit = current_bit; }
+                retb.nbits += static_cast< uint32_t >(nwords * word_size());
+                return nwords;
+            } else if ((val == static_cast< word_t >(~word_t{})) && (retb.nbits == 0)) {
+                const uint64_t nwords{bitset_simd::count_equal_words(words, avail_words, ~uint64_t{0})};
+                retb.start_bit = current_bit + nwords * word_size();
+                return nwords;
+            }
+        }
+        return 0;
     }
 
     void set_reset_bits(const uint64_t start, const uint64_t nbits, const bool value) {
         ReadLockGuard lock{this};
+        set_reset_bits_impl(start, nbits, value);
+    }
+
+    void set_reset_bits_batch(const std::span< const BitBlock > blocks, const bool value) {
+        const auto merged{merge_bit_blocks(blocks)};
+        if (merged.empty()) { return; }
+
+        ReadLockGuard lock{this};
+        assert(m_s);
+        if ((merged.back().first + merged.back().second) > total_bits()) {
+            throw std::out_of_range("Set/Reset bits not in range");
+        }
+        for (const auto& [start, nbits] : merged) {
+            store_bits_impl(start, nbits, value);
+        }
+    }
+
+    // NOTE: must be called under lock and the bits must be in range. Same as set_reset_bits_impl, except that the
+    // whole words are stored as is instead of updating their bits.
+    void store_bits_impl(const uint64_t start, uint64_t nbits, const bool value) {
+        bitword_type* word_ptr{get_word(start)};
+        const uint8_t offset{get_word_offset(start)};
+        const uint64_t first_word{word_index(word_ptr)};
+        const uint64_t last_word{first_word + (offset + nbits - 1) / word_size()};
+        if (m_snapshots) { preserve_for_snapshots(first_word, offset, nbits); }
+
+        if ((offset > 0) || (nbits < word_size())) {
+            const uint8_t count{static_cast< uint8_t >(std::min< uint64_t >(word_size() - offset, nbits))};
+            (word_ptr++)->set_reset_bits(offset, count, value);
+            nbits -= count;
+        }
+        const word_t fill{value ? static_cast< word_t >(~word_t{}) : word_t{}};
+        for (; nbits >= word_size(); nbits -= word_size()) {
+            (word_ptr++)->set(fill);
+        }
+        if (nbits > 0) { word_ptr->set_reset_bits(0, static_cast< uint8_t >(nbits), value); }
+
+        if (m_summary) { update_summary(first_word, last_word, value); }
+        if (m_mapping) { mark_words_dirty(first_word, last_word); }
+        if (m_free_runs) { mark_free_runs_stale(first_word, last_word); }
+    }
+
+    // NOTE: must be called under lock
+    void set_reset_bits_impl(const uint64_t start, const uint64_t nbits, const bool value) {
         assert(m_s && m_s->valid_bit(start));
 
         // NOTE: we ignore the fact here that the total number of bits may not consume the entire
@@ -1087,6 +2091,7 @@ private:
         bitword_type* word_ptr{get_word(start)};
         if (!word_ptr) { throw std::out_of_range("Set/Reset bits not in range"); }
         const uint8_t offset{get_word_offset(start)};
+        if (m_snapshots) { preserve_for_snapshots(word_index(word_ptr), offset, nbits); }
         uint8_t count{static_cast< uint8_t >(
             (nbits > static_cast< uint8_t >(word_size() - offset)) ? (word_size() - offset) : nbits)};
         word_ptr->set_reset_bits(offset, count, value);
@@ -1095,6 +2100,7 @@ private:
         uint64_t current_bit{start + count};
         uint64_t bits_remaining{nbits - count};
         const bitword_type* const end_words_ptr{m_s->end_words_const()};
+        const uint64_t first_word{word_index(word_ptr)};
         while ((bits_remaining > 0) && (++word_ptr != end_words_ptr)) {
             count = static_cast< uint8_t >((bits_remaining > word_size()) ? word_size() : bits_remaining);
             word_ptr->set_reset_bits(0, count, value);
@@ -1102,10 +2108,159 @@ private:
             current_bit += count;
             bits_remaining -= count;
         }
+        if (m_summary || m_mapping || m_free_runs) {
+            const uint64_t last_word{(word_ptr == end_words_ptr) ? word_index(word_ptr) - 1 : word_index(word_ptr)};
+            if (m_summary) { update_summary(first_word, last_word, value); }
+            if (m_mapping) { mark_words_dirty(first_word, last_word); }
+            if (m_free_runs) { mark_free_runs_stale(first_word, last_word); }
+        }
 
         if (bits_remaining > 0) { throw std::out_of_range("Set/Reset bits not in range"); }
     }
 
+    // Match the word with the filter of the contiguous reset bits search (lsb_reqd, mid_reqd, 1), using the compile
+    // time specialized filters for the common shapes. Any reset bit does for a single bit search, while a mid_reqd of
+    // a word or more can only be met by a full word or the run at the msb of a word.
+    static bit_match_result match_reset_bits(const bitword_type* const word_ptr, const uint8_t offset,
+                                             const uint32_t lsb_reqd, const uint32_t mid_reqd) {
+        if (mid_reqd == 1) {
+            return word_ptr->template get_next_reset_bits_filtered< 1, 1, 1 >(offset);
+        } else if ((lsb_reqd == word_size()) && (mid_reqd >= word_size())) {
+            return word_ptr->template get_next_reset_bits_filtered< word_size(), word_size(), 1 >(offset);
+        }
+        return word_ptr->get_next_reset_bits_filtered(offset, bit_filter{lsb_reqd, mid_reqd, 1});
+    }
+
+    // NOTE: must be called under lock. Walks the words backwards from start_bit down to end_bit, both inclusive and
+    // within the bitset, for the previous set or reset bit.
+    uint64_t get_prev_set_or_reset_bit_impl(const uint64_t start_bit, const uint64_t end_bit,
+                                            const bool search_for_set_bit) const {
+        const uint64_t skip_bits{m_s->m_skip_bits};
+        const uint64_t last_word{(end_bit + skip_bits) / word_size()};
+        uint64_t word_n{(start_bit + skip_bits) / word_size()};
+        uint8_t offset{get_word_offset(start_bit)};
+        uint8_t nbit{};
+        while (true) {
+            if (!search_for_set_bit && m_summary && (offset == (word_size() - 1)) &&
+                (((word_n + 1) % summary_fanout()) == 0)) {
+                // jump over the groups which are known to be fully set
+                const uint64_t nwords{summary_prev_skip_words(word_n)};
+                if (nwords > (word_n - last_word)) { return npos; }
+                word_n -= nwords;
+            }
+            const bitword_type* word_ptr{nth_word(word_n)};
+            const bool found{search_for_set_bit ? word_ptr->get_prev_set_bit(offset, &nbit)
+                                                : word_ptr->get_prev_reset_bit(offset, &nbit)};
+            if (found) {
+                const uint64_t ret{word_n * word_size() + nbit};
+                return (ret >= (end_bit + skip_bits)) ? (ret - skip_bits) : npos;
+            }
+            if (word_n == last_word) { return npos; }
+            --word_n;
+            offset = word_size() - 1;
+        }
+    }
+
+    // NOTE: must be called under lock
+    BitBlock get_next_contiguous_n_reset_bits_impl(const uint64_t start_bit, const std::optional< uint64_t > end_bit,
+                                                   const uint32_t min_needed, const uint32_t max_needed) const {
+        BitBlock retb{start_bit, 0};
+
+        const bitword_type* word_ptr{get_word_const(start_bit)};
+        if (!word_ptr) { return {npos, 0}; }
+        uint8_t offset{get_word_offset(start_bit)};
+        uint64_t current_bit{start_bit};
+        const uint64_t final_bit{end_bit ? std::min(*end_bit + 1, total_bits()) : total_bits()};
+
+        while ((retb.nbits < max_needed) && (current_bit < final_bit)) {
+            if (offset == 0) {
+                // Skip over stretches of fully set/reset words in bulk and only apply the per word filter at the run
+                // boundaries
+                const uint64_t nwords{skip_uniform_words(word_ptr, current_bit, final_bit, max_needed, retb)};
+                if (nwords > 0) {
+                    current_bit += nwords * word_size();
+                    word_ptr += nwords;
+                    continue;
+                }
+            }
+
+            const uint32_t lsb_reqd{(retb.nbits >= min_needed)
+                                        ? static_cast< uint32_t >(1)
+                                        : std::min< uint32_t >(min_needed - retb.nbits, word_size())};
+            const auto result{match_reset_bits(word_ptr, offset, lsb_reqd, min_needed)};
+            LOGTRACE("current_bit={} word filter lsb={} mid={} result={}", current_bit, lsb_reqd, min_needed,
+                     result.to_string());
+
+            if (result.match_type == bit_match_type::full_match) {
+                // We got the entire word, keep adding to the chain
+                assert(offset == 0);
+                retb.nbits += result.count;
+            } else if (result.match_type == bit_match_type::lsb_match) {
+                // We got atleast min from the chain, keep adding to the chain
+                assert(offset == 0);
+                retb.nbits += result.count;
+                if (retb.nbits >= min_needed) { break; }
+            } else if (result.match_type == bit_match_type::mid_match) {
+                assert(result.count >= min_needed);
+                if (result.count > retb.nbits) { retb = {current_bit + result.start_bit - offset, result.count}; }
+                break;
+            } else if (result.match_type == bit_match_type::msb_match) {
+                if (retb.nbits >= min_needed) { break; } // It has met the min with previous scan, use it - greedy algo
+                retb = {current_bit + result.start_bit - offset, result.count};
+            } else if (result.match_type == bit_match_type::no_match) {
+                if (retb.nbits >= min_needed) { break; } // It has met the min with previous scan, use it - greedy algo
+                retb = {current_bit + word_size() - offset, 0}; // Reset everything and start over
+            }
+
+            current_bit += (word_size() - offset);
+            offset = 0;
+            ++word_ptr;
+        }
+
+        if (retb.nbits > 0) {
+            // Do alignment adjustments if need be
+            if ((retb.start_bit + retb.nbits) > final_bit) {
+                // It is an unlikely path - only when total bits are not 64 bit aligned and retb happens to be at
+                // the end
+                if (retb.start_bit >= final_bit) {
+                    retb = {npos, 0};
+                } else {
+                    retb.nbits = static_cast< uint32_t >(final_bit - retb.start_bit);
+                }
+            }
+            // Note: these belong here since must be done after above since nbits may be reduced
+            if (retb.nbits > max_needed) { retb.nbits = max_needed; }
+            if (retb.nbits < min_needed) { retb = {npos, 0}; }
+        } else {
+            retb.start_bit = npos;
+        }
+
+        return retb;
+    }
+
+    // NOTE: must be called under lock. Claim the bits word by word from start, stopping at the first word which has
+    // any of its bits already set. Returns the number of bits claimed from start.
+    uint32_t claim_bits(const uint64_t start, const uint32_t nbits) {
+        bitword_type* word_ptr{get_word(start)};
+        const uint64_t first_word{word_index(word_ptr)};
+        uint8_t offset{get_word_offset(start)};
+        if (m_snapshots) { preserve_for_snapshots(first_word, offset, nbits); }
+        uint32_t claimed{0};
+        while (claimed < nbits) {
+            const uint8_t count{static_cast< uint8_t >(std::min< uint32_t >(word_size() - offset, nbits - claimed))};
+            if (!word_ptr->set_bits_if_reset(offset, count)) { break; }
+            claimed += count;
+            offset = 0;
+            ++word_ptr;
+        }
+        if (claimed > 0) {
+            if (m_summary) { update_summary(first_word, word_index(word_ptr) - 1, true); }
+            if (m_mapping) { mark_words_dirty(first_word, word_index(word_ptr) - 1); }
+            if (m_free_runs) { mark_free_runs_stale(first_word, word_index(word_ptr) - 1); }
+        }
+        return claimed;
+    }
+
     void set_reset_bit(const uint64_t bit, const bool value) {
         ReadLockGuard lock{this};
         assert(m_s && m_s->valid_bit(bit));
@@ -1113,7 +2268,11 @@ private:
         bitword_type* word_ptr{get_word(bit)};
         if (!word_ptr) { return; }
         const uint8_t offset{get_word_offset(bit)};
+        if (m_snapshots) { preserve_for_snapshots(word_index(word_ptr), offset, 1); }
         word_ptr->set_reset_bits(offset, 1, value);
+        if (m_summary) { update_summary(word_index(word_ptr), word_index(word_ptr), value); }
+        if (m_mapping) { mark_words_dirty(word_index(word_ptr), word_index(word_ptr)); }
+        if (m_free_runs) { mark_free_runs_stale(word_index(word_ptr), word_index(word_ptr)); }
     }
 
     bool is_bits_set_reset(const uint64_t start, const uint64_t nbits, const bool expected) const {
@@ -1150,6 +2309,7 @@ private:
         // We use the resize opportunity to compact bits. So we only to need to allocate nbits + first word skip
         // list size. Rest of them will be compacted.
         assert(m_s);
+        complete_snapshots();
         const uint64_t shrink_words{m_s->m_skip_bits / word_size()};
         const uint64_t new_skip_bits{m_s->m_skip_bits & m_word_mask};
 
@@ -1171,11 +2331,845 @@ private:
         // swap old with new
         m_buf = new_buf;
         m_s = new_s;
+        refresh_mapping();
+        if (m_summary) { build_summary(m_summary->nlevels); }
+        if (m_free_runs) {
+            m_free_runs = std::make_shared< bitset_free_runs >();
+            refresh_free_runs();
+        }
 
         LOGDEBUG("Resize to total_bits={} total_actual_bits={}, skip_bits={}, words_cap={}", total_bits(), m_s->m_nbits,
                  m_s->m_skip_bits, m_s->m_words_cap);
     }
 
+    // NOTE: must be called under write lock. Map size bytes of the backing file as the buffer, growing the file if
+    // needed. The file is never shrunk, since a snapshot being completed may still have the older buffer mapped.
+    void map_file(const uint64_t size) {
+        // The buffer size is 32 bits, like the in memory bitsets
+        if (size > std::numeric_limits< uint32_t >::max()) {
+            throw std::length_error("File backed bitset of " + std::to_string(size) + " bytes is too large to map");
+        }
+        struct stat st;
+        if (::fstat(m_mapping->fd, &st) != 0) {
+            throw std::system_error(errno, std::generic_category(), "fstat of bitset file failed");
+        }
+        const uint64_t file_size{round_up(size, m_mapping->page_size)};
+        if ((static_cast< uint64_t >(st.st_size) < file_size) &&
+            (::ftruncate(m_mapping->fd, static_cast< off_t >(file_size)) != 0)) {
+            throw std::system_error(errno, std::generic_category(), "Unable to grow bitset file");
+        }
+
+        void* const addr{::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_mapping->fd, 0)};
+        if (addr == MAP_FAILED) { throw std::system_error(errno, std::generic_category(), "mmap of bitset file failed"); }
+        m_buf = std::shared_ptr< byte_array_impl >{
+            new byte_array_impl{static_cast< uint8_t* >(addr), static_cast< uint32_t >(size), false},
+            [size](byte_array_impl* const ptr) {
+                if (ptr) {
+                    ::munmap(ptr->bytes(), size);
+                    ptr->set_bytes(static_cast< uint8_t* >(nullptr)); // so that it does not free the mapping
+                    delete ptr;
+                }
+            }};
+        m_mapping->base = m_buf->bytes();
+        const uint64_t npages{(size + m_mapping->page_size - 1) / m_mapping->page_size};
+        m_mapping->dirty_pages = std::vector< std::atomic< uint64_t > >((npages + 63) / 64);
+    }
+
+    // NOTE: must be called under write lock, after the words are rewritten in bulk (copy/resize). If they were
+    // rewritten into a new buffer, move them into a fresh mapping of the file. Either way the whole file is dirty.
+    void refresh_mapping() {
+        if (!m_mapping) { return; }
+        if (m_buf->bytes() != m_mapping->base) {
+            const sisl::byte_array new_buf{m_buf};
+            const uint64_t size{bitset_serialized::nbytes(m_s->m_nbits)};
+            const int fd{::dup(m_mapping->fd)};
+            if (fd < 0) { throw std::system_error(errno, std::generic_category(), "dup of bitset file failed"); }
+            auto old_mapping{std::exchange(m_mapping, std::make_shared< bitset_mapping >(fd))};
+            try {
+                map_file(size);
+            } catch (...) {
+                m_mapping = std::move(old_mapping);
+                throw;
+            }
+            std::memcpy(static_cast< void* >(m_buf->bytes()), static_cast< const void* >(new_buf->cbytes()), size);
+            m_s = reinterpret_cast< bitset_serialized* >(m_buf->bytes());
+        }
+        mark_dirty(0, m_buf->size());
+    }
+
+    // NOTE: must be called under lock. Mark the pages of the bytes [offset, offset + nbytes) as dirty
+    void mark_dirty(const uint64_t offset, const uint64_t nbytes) {
+        const uint64_t first_page{offset / m_mapping->page_size};
+        const uint64_t last_page{(offset + nbytes - 1) / m_mapping->page_size};
+        for (uint64_t page{first_page}; page <= last_page; page = (page | 63) + 1) {
+            const uint64_t end_bit{std::min< uint64_t >(last_page - (page & ~uint64_t{63}), 63)};
+            const uint64_t mask{consecutive_bitmask[end_bit] & (~uint64_t{0} << (page % 64))};
+            auto& dirty{m_mapping->dirty_pages[page / 64]};
+            if constexpr (atomic_words) {
+                // Unconditional, so that a concurrent flush either sees this or the word update
+                dirty.fetch_or(mask, std::memory_order_release);
+            } else {
+                if ((dirty.load(std::memory_order_relaxed) & mask) != mask) { dirty.fetch_or(mask); }
+            }
+        }
+    }
+
+    // NOTE: must be called under lock
+    word_t get_word_value_impl(const uint64_t start_bit) const {
+        const bitword_type* word_ptr{get_word_const(start_bit)};
+        if (!word_ptr) { return word_t{}; }
+
+        word_t val{word_ptr->to_integer()};
+        const uint8_t offset{get_word_offset(start_bit)};
+        uint64_t bits_remaining{total_bits() - start_bit};
+        if (offset > 0) {
+            // compose from multiple words
+            const uint8_t word_bits_remaining{static_cast< uint8_t >(word_size() - offset)};
+            const uint8_t valid_low_bits{
+                static_cast< uint8_t >((bits_remaining > word_bits_remaining) ? word_bits_remaining : bits_remaining)};
+            const word_t low_mask{static_cast< word_t >(consecutive_bitmask[valid_low_bits - 1])};
+            val = static_cast< word_t >(val >> offset) & low_mask;
+            bits_remaining -= valid_low_bits;
+
+            // add from next word if word_t size word spans two words
+            if (bits_remaining > 0) {
+                const uint8_t valid_high_bits{
+                    static_cast< uint8_t >((bits_remaining > offset) ? offset : bits_remaining)};
+                const word_t high_mask{static_cast< word_t >(consecutive_bitmask[valid_high_bits - 1])};
+                val |= static_cast< word_t >(((++word_ptr)->to_integer() & high_mask) << valid_low_bits);
+            }
+        } else {
+            // single word optimization
+            if (bits_remaining < word_size()) {
+                const word_t mask{static_cast< word_t >(consecutive_bitmask[bits_remaining - 1])};
+                val &= mask;
+            }
+        }
+
+        return val;
+    }
+
+    // NOTE: must be called under lock of both bitsets
+    const sisl::byte_array serialize_delta_locked(const BitsetImpl& base) const {
+        const uint64_t nbits{total_bits()};
+        const uint64_t base_nbits{base.total_bits()};
+        const uint64_t common_words{std::min(nbits, base_nbits) / word_size()};
+
+        std::vector< delta_range > ranges;
+        std::vector< word_t > words;
+        const auto add_run{[this, &ranges, &words](const uint64_t start_word, const uint64_t nwords,
+                                                   const word_t* const vals) {
+            const uint64_t prev_end{ranges.empty() ? 0 : (ranges.back().m_start_word + ranges.back().m_nwords)};
+            if (!ranges.empty() && ((start_word - prev_end) <= delta_merge_gap_words())) {
+                // Cheaper to send the unchanged words in between than a new range
+                for (uint64_t w{prev_end}; w < start_word; ++w) {
+                    words.push_back(get_word_value_impl(w * word_size()));
+                }
+                ranges.back().m_nwords = start_word + nwords - ranges.back().m_start_word;
+            } else {
+                ranges.push_back(delta_range{start_word, nwords});
+            }
+            words.insert(std::end(words), vals, vals + nwords);
+        }};
+
+        // Whole words present in both, compared in blocks
+        std::array< word_t, 256 > self_buf;
+        std::array< word_t, 256 > base_buf;
+        for (uint64_t word_n{0}; word_n < common_words;) {
+            const uint64_t n{std::min< uint64_t >(common_words - word_n, self_buf.size())};
+            const word_t* const vals{logical_words(word_n, n, self_buf)};
+            const word_t* const base_vals{base.logical_words(word_n, n, base_buf)};
+            uint64_t i{count_matching_words(vals, base_vals, n, true)};
+            while (i < n) {
+                const uint64_t ndiff{count_matching_words(vals + i, base_vals + i, n - i, false)};
+                add_run(word_n + i, ndiff, vals + i);
+                i += ndiff;
+                i += count_matching_words(vals + i, base_vals + i, n - i, true);
+            }
+            word_n += n;
+        }
+
+        // Rest of the words of this bitset, where base has a partial word or no word at all. Bits beyond base are
+        // reset upon resize, so only the words which have any of them set need to be sent.
+        for (uint64_t word_n{common_words}; word_n < bitset_serialized::total_words(nbits); ++word_n) {
+            const uint64_t bit{word_n * word_size()};
+            const uint64_t count{std::min< uint64_t >(word_size(), nbits - bit)};
+            const word_t mask{static_cast< word_t >(consecutive_bitmask[count - 1])};
+            const word_t val{static_cast< word_t >(get_word_value_impl(bit) & mask)};
+            const word_t base_val{
+                static_cast< word_t >((bit < base_nbits) ? (base.get_word_value_impl(bit) & mask) : word_t{})};
+            if (val != base_val) { add_run(word_n, 1, &val); }
+        }
+
+        const uint64_t size{sizeof(bitset_delta_serialized) + ranges.size() * sizeof(delta_range) +
+                            words.size() * sizeof(word_t)};
+        auto buf{make_byte_array(static_cast< uint32_t >(size), 0, buftag::bitset)};
+        bitset_delta_serialized* const hdr{new (buf->bytes()) bitset_delta_serialized{}};
+        hdr->m_id = m_s->m_id;
+        hdr->m_nbits = nbits;
+        hdr->m_base_nbits = base_nbits;
+        hdr->m_nranges = ranges.size();
+
+        uint8_t* ptr{buf->bytes() + sizeof(bitset_delta_serialized)};
+        const word_t* vals{words.data()};
+        for (const auto& range : ranges) {
+            std::memcpy(static_cast< void* >(ptr), static_cast< const void* >(&range), sizeof(delta_range));
+            ptr += sizeof(delta_range);
+            std::memcpy(static_cast< void* >(ptr), static_cast< const void* >(vals), range.m_nwords * sizeof(word_t));
+            ptr += range.m_nwords * sizeof(word_t);
+            vals += range.m_nwords;
+        }
+        return buf;
+    }
+
+    // NOTE: must be called under lock. Get n whole logical words starting at word_n, pointing directly into the words
+    // if they are aligned, otherwise composed into buf.
+    const word_t* logical_words(const uint64_t word_n, const uint64_t n, std::array< word_t, 256 >& buf) const {
+        const uint64_t bit{word_n * word_size()};
+        if constexpr (std::is_standard_layout_v< bitword_type > && (sizeof(bitword_type) == sizeof(word_t))) {
+            if (get_word_offset(bit) == 0) { return reinterpret_cast< const word_t* >(get_word_const(bit)); }
+        }
+        for (uint64_t i{0}; i < n; ++i) {
+            buf[i] = get_word_value_impl(bit + i * word_size());
+        }
+        return buf.data();
+    }
+
+    static uint64_t count_matching_words(const word_t* const a, const word_t* const b, const uint64_t nwords,
+                                         const bool equal) {
+        if constexpr (std::is_same_v< word_t, uint64_t >) {
+            return bitset_simd::count_matching_words(a, b, nwords, equal);
+        } else {
+            uint64_t i{0};
+            while ((i < nwords) && ((a[i] == b[i]) == equal)) {
+                ++i;
+            }
+            return i;
+        }
+    }
+
+    // NOTE: must be called under lock. Store the logical word of bits starting at bit, which can span two words if
+    // the bitset is shifted. Bits beyond the bitset are ignored.
+    void store_word_value_impl(const uint64_t bit, const word_t val) {
+        bitword_type* word_ptr{get_word(bit)};
+        const uint8_t offset{get_word_offset(bit)};
+        uint64_t nbits{std::min< uint64_t >(word_size(), total_bits() - bit)};
+        const uint8_t count{static_cast< uint8_t >(std::min< uint64_t >(word_size() - offset, nbits))};
+        store_bits_value(*word_ptr, offset, count, static_cast< word_t >(val << offset));
+        nbits -= count;
+        if (nbits > 0) {
+            store_bits_value(*(++word_ptr), 0, static_cast< uint8_t >(nbits), static_cast< word_t >(val >> count));
+        }
+    }
+
+    // Store count bits of val starting at offset into the word, leaving the rest of the word as is
+    static void store_bits_value(bitword_type& word, const uint8_t offset, const uint8_t count, const word_t val) {
+        const word_t mask{static_cast< word_t >(consecutive_bitmask[count - 1] << offset)};
+        if (mask == static_cast< word_t >(~word_t{})) {
+            word.set(val);
+        } else {
+            word.and_with(static_cast< word_t >(val | ~mask));
+            word.or_with(static_cast< word_t >(val & mask));
+        }
+    }
+
+    void apply_bitwise(const BitsetImpl& other, const bitwise_op op) {
+        if (this == &other) {
+            // and/or with itself is a no-op, xor/andnot with itself clears everything
+            if ((op == bitwise_op::xor_with) || (op == bitwise_op::andnot_with)) {
+                WriteLockGuard lock{this};
+                if (total_bits() > 0) { set_reset_bits_impl(0, total_bits(), false); }
+            }
+            return;
+        }
+
+        // Same canonical lock order as copy()
+        if (&m_lock < &other.m_lock) {
+            WriteLockGuard lock{this};
+            ReadLockGuard other_lock{&other};
+            apply_bitwise_locked(other, op);
+        } else {
+            ReadLockGuard other_lock{&other};
+            WriteLockGuard lock{this};
+            apply_bitwise_locked(other, op);
+        }
+    }
+
+    uint64_t popcount_bitwise(const BitsetImpl& other, const bool negate_other) const {
+        if (this == &other) { return negate_other ? 0 : get_set_count(); }
+
+        const BitsetImpl* first{(&m_lock < &other.m_lock) ? this : &other};
+        const BitsetImpl* second{(&m_lock < &other.m_lock) ? &other : this};
+        ReadLockGuard lock{first};
+        ReadLockGuard other_lock{second};
+
+        const uint64_t nbits{std::min(total_bits(), other.total_bits())};
+        if (nbits == 0) { return 0; }
+
+        uint64_t count{0};
+        walk_aligned_words(
+            *this, other, nbits,
+            [&count, negate_other](const bitword_type* const word_ptr, const word_t other_val, const word_t mask) {
+                const word_t val{static_cast< word_t >(negate_other ? ~other_val : other_val)};
+                count += get_set_bit_count(static_cast< word_t >(word_ptr->to_integer() & val & mask));
+            },
+            [&count, negate_other](const bitword_type* const word_ptr, const word_t* const other_words,
+                                   const uint64_t nwords) {
+                if constexpr (vector_words) {
+                    count += bitset_simd::count_and_words(reinterpret_cast< const uint64_t* >(word_ptr),
+                                                          reinterpret_cast< const uint64_t* >(other_words), nwords,
+                                                          negate_other);
+                } else {
+                    for (uint64_t i{0}; i < nwords; ++i) {
+                        const word_t val{static_cast< word_t >(negate_other ? ~other_words[i] : other_words[i])};
+                        count += get_set_bit_count(static_cast< word_t >(word_ptr[i].to_integer() & val));
+                    }
+                }
+            });
+        return count;
+    }
+
+    // NOTE: must be called under write lock of this and read lock of other
+    void apply_bitwise_locked(const BitsetImpl& other, const bitwise_op op) {
+        const uint64_t nbits{std::min(total_bits(), other.total_bits())};
+        if (nbits == 0) { return; }
+        complete_snapshots();
+
+        walk_aligned_words(
+            *this, other, nbits,
+            [op](bitword_type* const word_ptr, const word_t other_val, const word_t mask) {
+                apply_word(*word_ptr, other_val, mask, op);
+            },
+            [op](bitword_type* const word_ptr, const word_t* const other_words, const uint64_t nwords) {
+                // Vector stores are only safe on plain words, atomic words are updated one atomic op at a time
+                if constexpr (vector_words) {
+                    bitset_simd::bitwise_words(op, reinterpret_cast< uint64_t* >(word_ptr),
+                                               reinterpret_cast< const uint64_t* >(other_words), nwords);
+                } else {
+                    for (uint64_t i{0}; i < nwords; ++i) {
+                        apply_word(word_ptr[i], other_words[i], static_cast< word_t >(~word_t{}), op);
+                    }
+                }
+            });
+
+        refresh_summary();
+        refresh_free_runs();
+        if (m_mapping) {
+            const uint64_t first_word{word_index(get_word_const(0))};
+            mark_words_dirty(first_word, word_index(get_word_const(nbits - 1)));
+        }
+    }
+
+    // Apply op of the masked bits of val on to the word with a single update of the word
+    static void apply_word(bitword_type& word, const word_t val, const word_t mask, const bitwise_op op) {
+        switch (op) {
+        case bitwise_op::and_with:
+            word.and_with(static_cast< word_t >(val | ~mask));
+            break;
+        case bitwise_op::or_with:
+            word.or_with(static_cast< word_t >(val & mask));
+            break;
+        case bitwise_op::xor_with:
+            word.xor_with(static_cast< word_t >(val & mask));
+            break;
+        case bitwise_op::andnot_with:
+            word.and_with(static_cast< word_t >(~(val & mask)));
+            break;
+        }
+    }
+
+    // NOTE: must be called under lock of both bitsets. Walks the words covering the first nbits of self along with
+    // the same bits of other aligned to self's words. Partial words at either end are passed to partial_fn as
+    // (word_ptr, other_value, mask of valid bits) and whole words to block_fn as (word_ptr, other_words, nwords).
+    // If both have the same word offset other's words are passed as is, otherwise shifted values are composed from
+    // adjacent words of other in blocks.
+    template < typename SelfType, typename PartialFn, typename BlockFn >
+    static void walk_aligned_words(SelfType& self, const BitsetImpl& other, const uint64_t nbits,
+                                   PartialFn&& partial_fn, BlockFn&& block_fn) {
+        static constexpr bool raw_words{std::is_standard_layout_v< bitword_type > &&
+                                        (sizeof(bitword_type) == sizeof(word_t))};
+        auto* word_ptr{self.nth_word(self.m_s->m_skip_bits / word_size())};
+        uint64_t bit{0};
+
+        const uint8_t offset{self.get_word_offset(0)};
+        if (offset > 0) {
+            const uint64_t count{std::min< uint64_t >(word_size() - offset, nbits)};
+            partial_fn(word_ptr++, static_cast< word_t >(other.get_word_value_impl(0) << offset),
+                       static_cast< word_t >(consecutive_bitmask[count - 1] << offset));
+            bit += count;
+        }
+
+        uint64_t nwords{(nbits - bit) / word_size()};
+        const uint8_t other_offset{(nwords > 0) ? other.get_word_offset(bit) : uint8_t{0}};
+        if ((nwords > 0) && raw_words && (other_offset == 0)) {
+            block_fn(word_ptr, reinterpret_cast< const word_t* >(other.get_word_const(bit)), nwords);
+            word_ptr += nwords;
+            bit += nwords * word_size();
+        } else {
+            std::array< word_t, 256 > other_words;
+            while (nwords > 0) {
+                const uint64_t n{std::min< uint64_t >(nwords, other_words.size())};
+                if (other_offset > 0) {
+                    // Every whole word of self is within nbits, so the two words of other it spans always exist
+                    const bitword_type* const src{other.get_word_const(bit)};
+                    for (uint64_t i{0}; i < n; ++i) {
+                        const word_t low{static_cast< word_t >(src[i].to_integer() >> other_offset)};
+                        const word_t high{static_cast< word_t >(src[i + 1].to_integer() << (word_size() - other_offset))};
+                        other_words[i] = static_cast< word_t >(low | high);
+                    }
+                    bit += n * word_size();
+                } else {
+                    for (uint64_t i{0}; i < n; ++i, bit += word_size()) {
+                        other_words[i] = other.get_word_value_impl(bit);
+                    }
+                }
+                block_fn(word_ptr, other_words.data(), n);
+                word_ptr += n;
+                nwords -= n;
+            }
+        }
+
+        if (bit < nbits) {
+            partial_fn(word_ptr, other.get_word_value_impl(bit),
+                       static_cast< word_t >(consecutive_bitmask[nbits - bit - 1]));
+        }
+    }
+
+    // NOTE: must be called under write lock, when this bitset moves on to a new buffer
+    void detach_free_runs() {
+        if (m_free_runs) { m_free_runs = std::make_shared< bitset_free_runs >(); }
+    }
+
+    // NOTE: must be called under write lock. Size the free run index to the words and mark every segment stale
+    void refresh_free_runs() {
+        if (!m_free_runs) { return; }
+        const uint64_t nsegments{(m_s->m_words_cap + free_run_segment_words() - 1) / free_run_segment_words()};
+        if (m_free_runs->segments.size() != nsegments) {
+            m_free_runs->segments.resize(nsegments);
+            m_free_runs->stale = std::vector< std::atomic< uint64_t > >((nsegments + 63) / 64);
+        }
+        for (auto& stale : m_free_runs->stale) {
+            stale.store(~uint64_t{0}, std::memory_order_release);
+        }
+    }
+
+    // NOTE: must be called under lock
+    void mark_free_runs_stale(const uint64_t first_word, const uint64_t last_word) {
+        for (uint64_t seg{first_word / free_run_segment_words()}; seg <= last_word / free_run_segment_words(); ++seg) {
+            auto& stale{m_free_runs->stale[seg / 64]};
+            if constexpr (atomic_words) {
+                // Unconditional, so that a concurrent recompute either sees this or the word update
+                stale.fetch_or(bit_mask[seg % 64], std::memory_order_release);
+            } else {
+                if ((stale.load(std::memory_order_relaxed) & bit_mask[seg % 64]) == 0) {
+                    stale.fetch_or(bit_mask[seg % 64]);
+                }
+            }
+        }
+    }
+
+    // NOTE: must be called under lock. Calls fn(start, len) for each maximal run of set (or reset) bits within the
+    // actual bits [lo, hi), stopping if fn returns false. Runs are cut at lo and hi.
+    template < typename RunFn >
+    void for_each_run(uint64_t lo, const uint64_t hi, const bool value, RunFn&& fn) const {
+        uint64_t run_start{0};
+        bool in_run{false};
+        while (lo < hi) {
+            const uint8_t offset{static_cast< uint8_t >(lo & m_word_mask)};
+            const uint64_t n{std::min< uint64_t >(word_size() - offset, hi - lo)};
+            const word_t val{nth_word(lo / word_size())->to_integer()};
+            const word_t word{static_cast< word_t >(value ? val : ~val)};
+            const uint64_t free{(static_cast< uint64_t >(word) >> offset) & consecutive_bitmask[n - 1]};
+            uint64_t pos{0};
+            while (pos < n) {
+                if (in_run) {
+                    pos += std::min< uint64_t >(get_trailing_zeros(~free >> pos), n - pos);
+                    if (pos == n) { break; } // run continues on to the next word
+                    in_run = false;
+                    if (!fn(run_start, lo + pos - run_start)) { return; }
+                } else {
+                    const uint64_t rest{free >> pos};
+                    if (rest == 0) { break; }
+                    pos += get_trailing_zeros(rest);
+                    run_start = lo + pos;
+                    in_run = true;
+                }
+            }
+            lo += n;
+        }
+        if (in_run) { fn(run_start, hi - run_start); }
+    }
+
+    // NOTE: must be called under lock. First actual bit in [lo, hi) having the value, hi if there is none
+    uint64_t find_actual_bit(uint64_t lo, const uint64_t hi, const bool value) const {
+        while (lo < hi) {
+            const uint8_t offset{static_cast< uint8_t >(lo & m_word_mask)};
+            const uint64_t n{std::min< uint64_t >(word_size() - offset, hi - lo)};
+            const word_t val{nth_word(lo / word_size())->to_integer()};
+            const uint64_t bits{(static_cast< uint64_t >(static_cast< word_t >(value ? val : ~val)) >> offset) &
+                                consecutive_bitmask[n - 1]};
+            if (bits != 0) { return lo + get_trailing_zeros(bits); }
+            lo += n;
+        }
+        return hi;
+    }
+
+    // NOTE: must be called under lock. Number of set bits among the actual bits [lo, hi)
+    uint64_t count_actual_set_bits(uint64_t lo, const uint64_t hi) const {
+        uint64_t count{0};
+        const uint8_t offset{static_cast< uint8_t >(lo & m_word_mask)};
+        if ((offset > 0) && (lo < hi)) {
+            const uint64_t n{std::min< uint64_t >(word_size() - offset, hi - lo)};
+            count += get_set_bit_count(static_cast< uint64_t >(nth_word(lo / word_size())->to_integer() >> offset) &
+                                       consecutive_bitmask[n - 1]);
+            lo += n;
+        }
+
+        const uint64_t nwords{(hi - lo) / word_size()};
+        if (nwords > 0) {
+            const bitword_type* const words{nth_word(lo / word_size())};
+            if constexpr (vector_words) {
+                const uint64_t* const raw{reinterpret_cast< const uint64_t* >(words)};
+                count += bitset_simd::count_and_words(raw, raw, nwords);
+            } else {
+                for (uint64_t i{0}; i < nwords; ++i) {
+                    count += words[i].get_set_count();
+                }
+            }
+            lo += nwords * word_size();
+        }
+
+        if (lo < hi) {
+            count += get_set_bit_count(static_cast< uint64_t >(nth_word(lo / word_size())->to_integer()) &
+                                       consecutive_bitmask[hi - lo - 1]);
+        }
+        return count;
+    }
+
+    // NOTE: must be called under lock. Calls fn(start_bit, nbits) for every run of set bits starting within the actual
+    // bits [lo, hi), with the whole run even if it extends beyond hi. A run continuing from before lo is left to
+    // whoever walks the bits before lo.
+    template < typename RunFn >
+    void set_runs_of_part(uint64_t lo, const uint64_t hi, RunFn&& fn) const {
+        const uint64_t skip_bits{m_s->m_skip_bits};
+        const uint64_t end_bit{m_s->m_nbits};
+        if ((lo > skip_bits) && (find_actual_bit(lo - 1, lo, true) != lo)) { lo = find_actual_bit(lo, hi, false); }
+        for_each_run(lo, hi, true, [this, &fn, skip_bits, hi, end_bit](const uint64_t start, uint64_t len) {
+            if ((start + len) == hi) { len = find_actual_bit(hi, end_bit, false) - start; }
+            fn(start - skip_bits, len);
+            return true;
+        });
+    }
+
+    static void add_extents(std::vector< BitBlock >& extents, uint64_t start, uint64_t nbits) {
+        while (nbits > 0) {
+            const uint32_t n{
+                static_cast< uint32_t >(std::min< uint64_t >(nbits, std::numeric_limits< uint32_t >::max()))};
+            extents.emplace_back(start, n);
+            start += n;
+            nbits -= n;
+        }
+    }
+
+    // Split the actual bits [lo, hi) into upto nparts parts on word boundaries, of at least parallel_part_words()
+    // words each, and call fn(part, part_lo, part_hi) for each of them through the executor
+    template < typename PartFn >
+    static void run_parts(const bitset_executor& executor, const uint32_t nparts, const uint64_t lo, const uint64_t hi,
+                          PartFn&& fn) {
+        const uint64_t base{lo - (lo & m_word_mask)};
+        const uint64_t nwords{(hi - base + word_size() - 1) / word_size()};
+        const uint64_t max_parts{std::max< uint64_t >(nwords / parallel_part_words(), 1)};
+        const uint64_t want_parts{std::min< uint64_t >(std::max(nparts, 1u), max_parts)};
+        const uint64_t part_words{(nwords + want_parts - 1) / want_parts};
+        const uint64_t part_bits{part_words * word_size()};
+        const uint32_t n{static_cast< uint32_t >((hi - base + part_bits - 1) / part_bits)};
+        const auto part_fn{[&fn, lo, hi, base, part_bits](const uint32_t part) {
+            fn(part, std::max(lo, base + part * part_bits), std::min(hi, base + (part + 1) * part_bits));
+        }};
+        if (n <= 1) {
+            part_fn(0);
+        } else {
+            executor(n, part_fn);
+        }
+    }
+
+    // NOTE: must be called under lock. Compute the stats of the actual bits [lo, hi)
+    segment_free_runs compute_free_runs(const uint64_t lo, const uint64_t hi) const {
+        segment_free_runs st;
+        for_each_run(lo, hi, false, [&st, lo, hi](const uint64_t start, const uint64_t len) {
+            if (start == lo) { st.head = len; }
+            if (start + len == hi) { st.tail = len; }
+            if ((start != lo) && (start + len != hi)) {
+                ++st.histogram[logBase2(len)];
+                if (len > st.largest) {
+                    st.largest = len;
+                    st.largest_start = start;
+                }
+            }
+            return true;
+        });
+        return st;
+    }
+
+    // NOTE: must be called under lock. Walks the maximal reset runs of [start_bit, end_bit] segment by segment. Runs
+    // touching a segment boundary (stitched across segments) are passed to run_fn(start, len), whereas for the inner
+    // runs inner_fn(stats, lo, hi) gets the stats of each segment along with its actual bits [lo, hi), so that it can
+    // decide whether to look into them. Segments fully inside the range use the free run index if enabled, the rest
+    // are computed on the fly. Either function can return false to stop the walk.
+    template < typename RunFn, typename InnerFn >
+    void walk_free_runs(const uint64_t start_bit, const std::optional< uint64_t > end_bit, RunFn&& run_fn,
+                        InnerFn&& inner_fn) const {
+        assert(m_s);
+        const uint64_t skip_bits{m_s->m_skip_bits};
+        const uint64_t nbits{m_s->m_nbits};
+        uint64_t lo{start_bit + skip_bits};
+        const uint64_t end{end_bit ? std::min(*end_bit + skip_bits + 1, nbits) : nbits};
+
+        std::unique_lock< std::mutex > index_lock;
+        if (m_free_runs) { index_lock = std::unique_lock< std::mutex >{m_free_runs->mtx}; }
+
+        uint64_t carry_start{0};
+        uint64_t carry_len{0};
+        while (lo < end) {
+            const uint64_t seg{lo / free_run_segment_bits()};
+            const uint64_t seg_lo{std::max(seg * free_run_segment_bits(), skip_bits)};
+            const uint64_t seg_hi{std::min((seg + 1) * free_run_segment_bits(), nbits)};
+            const uint64_t hi{std::min(seg_hi, end)};
+            const segment_free_runs st{(m_free_runs && (lo == seg_lo) && (hi == seg_hi)) ? indexed_free_runs(seg)
+                                                                                       : compute_free_runs(lo, hi)};
+            if (st.head == (hi - lo)) {
+                if (carry_len == 0) { carry_start = lo; }
+                carry_len += hi - lo;
+            } else {
+                if ((carry_len + st.head) > 0) {
+                    if (!run_fn(((carry_len > 0) ? carry_start : lo) - skip_bits, carry_len + st.head)) { return; }
+                }
+                if (!inner_fn(st, lo, hi)) { return; }
+                carry_start = hi - st.tail;
+                carry_len = st.tail;
+            }
+            lo = hi;
+        }
+        if (carry_len > 0) { run_fn(carry_start - skip_bits, carry_len); }
+    }
+
+    // NOTE: must be called under lock and the free run index lock. Get the stats of the segment, recomputing them if
+    // stale
+    const segment_free_runs& indexed_free_runs(const uint64_t seg) const {
+        auto& stale{m_free_runs->stale[seg / 64]};
+        if (stale.load(std::memory_order_acquire) & bit_mask[seg % 64]) {
+            stale.fetch_and(~bit_mask[seg % 64], std::memory_order_acq_rel);
+            const uint64_t skip_bits{m_s->m_skip_bits};
+            const uint64_t nbits{m_s->m_nbits};
+            const uint64_t seg_lo{std::max(seg * free_run_segment_bits(), skip_bits)};
+            const uint64_t seg_hi{std::min((seg + 1) * free_run_segment_bits(), nbits)};
+            m_free_runs->segments[seg] = compute_free_runs(seg_lo, seg_hi);
+        }
+        return m_free_runs->segments[seg];
+    }
+
+    // NOTE: must be called under lock, before updating the words starting at offset of first_word for nbits. Copies
+    // their segments into the snapshots which don't have them yet.
+    void preserve_for_snapshots(const uint64_t first_word, const uint8_t offset, const uint64_t nbits) {
+        if (nbits == 0) { return; }
+        const uint64_t last_word{
+            std::min< uint64_t >(first_word + (offset + nbits - 1) / word_size(), m_s->m_words_cap - 1)};
+        for (const auto& state : m_snapshots->states) {
+            if (state->released.load(std::memory_order_relaxed)) { continue; }
+            for (uint64_t seg{first_word / snapshot_segment_words()}; seg <= last_word / snapshot_segment_words();
+                 ++seg) {
+                state->preserve(seg);
+            }
+        }
+    }
+
+    // NOTE: must be called under write lock, before the words are rewritten in bulk or the bitset moves on to a new
+    // buffer. Copies all the remaining segments into the snapshots, after which they don't need the words anymore.
+    void complete_snapshots() {
+        if (!m_snapshots) { return; }
+        for (const auto& state : m_snapshots->states) {
+            if (!state->released.load(std::memory_order_relaxed)) { state->preserve_all(); }
+            state->live_buf.reset();
+        }
+        m_snapshots.reset();
+    }
+
+    // NOTE: must be called under lock
+    void mark_words_dirty(const uint64_t first_word, const uint64_t last_word) {
+        mark_dirty(sizeof(bitset_serialized) + first_word * sizeof(bitword_type),
+                   (last_word - first_word + 1) * sizeof(bitword_type));
+    }
+
+    // NOTE: must be called under write lock. Summary gets a new object since copies sharing the old buffer still
+    // refer to the old one
+    void build_summary(const uint8_t levels) {
+        assert((levels > 0) && (levels <= max_summary_levels()));
+        m_summary = std::make_shared< bitset_summary >();
+        m_summary->nlevels = std::min(levels, max_summary_levels());
+        refresh_summary();
+    }
+
+    // NOTE: must be called under write lock, when this bitset moves on to a new buffer
+    void detach_summary() {
+        if (!m_summary) { return; }
+        const uint8_t levels{m_summary->nlevels};
+        m_summary = std::make_shared< bitset_summary >();
+        m_summary->nlevels = levels;
+    }
+
+    // NOTE: must be called under write lock. Recompute the summary (if any) from the current words
+    void refresh_summary() {
+        if (!m_summary) { return; }
+        auto& summary{*m_summary};
+        summary.levels.clear();
+        summary.level_nbits.clear();
+
+        uint64_t nbits{(m_s->m_words_cap + summary_fanout() - 1) / summary_fanout()};
+        for (uint8_t l{0}; l < summary.nlevels; ++l) {
+            summary.level_nbits.push_back(nbits);
+            summary.levels.emplace_back((nbits + 63) / 64);
+            nbits = (nbits + summary_fanout() - 1) / summary_fanout();
+        }
+
+        for (uint64_t group{0}; group < summary.level_nbits[0]; ++group) {
+            if (is_group_full(group)) { summary.levels[0][group / 64].fetch_or(bit_mask[group % 64]); }
+        }
+        for (uint8_t l{1}; l < summary.nlevels; ++l) {
+            for (uint64_t pos{0}; pos < summary.level_nbits[l]; ++pos) {
+                if (is_summary_word_full(l - 1, pos)) { summary.levels[l][pos / 64].fetch_or(bit_mask[pos % 64]); }
+            }
+        }
+    }
+
+    // NOTE: must be called under lock
+    bool is_group_full(const uint64_t group) const {
+        const uint64_t first_word{group * summary_fanout()};
+        const uint64_t words_cap{m_s->m_words_cap};
+        const uint64_t nwords{std::min(first_word + summary_fanout(), words_cap) - first_word};
+        const bitword_type* const word_ptr{nth_word(first_word)};
+        if constexpr (vector_words) {
+            return bitset_simd::count_equal_words(reinterpret_cast< const uint64_t* >(word_ptr), nwords,
+                                                  ~uint64_t{0}) == nwords;
+        } else {
+            return std::all_of(word_ptr, word_ptr + nwords, [](const bitword_type& w) {
+                return w.to_integer() == static_cast< word_t >(~word_t{});
+            });
+        }
+    }
+
+    // NOTE: must be called under lock. Is the summary word number word_num at level all set (ignoring the bits beyond
+    // the level size)
+    bool is_summary_word_full(const uint8_t level, const uint64_t word_num) const {
+        const uint64_t valid_bits{std::min< uint64_t >(m_summary->level_nbits[level] - word_num * 64, 64)};
+        const uint64_t mask{consecutive_bitmask[valid_bits - 1]};
+        return (m_summary->levels[level][word_num].load() & mask) == mask;
+    }
+
+    // NOTE: must be called under lock. Reset the summary bit for pos at level and all levels above it
+    void clear_summary(uint8_t level, uint64_t pos) {
+        if constexpr (atomic_words) {
+            // Pairs with the fence in mark_summary_full, either the setter sees our word update or we see its bit
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        for (; level < m_summary->nlevels; ++level, pos /= summary_fanout()) {
+            auto& sword{m_summary->levels[level][pos / 64]};
+            if (sword.load() & bit_mask[pos % 64]) { sword.fetch_and(~bit_mask[pos % 64]); }
+        }
+    }
+
+    // NOTE: must be called under lock. Set the summary bit of a group which is found fully set and propagate upwards.
+    // Since concurrent resets only clear the summary after updating the words, we recheck what is summarized after
+    // setting each bit and back off if it changed in between. This keeps the summary conservative at all times.
+    void mark_summary_full(const uint64_t group) {
+        uint64_t pos{group};
+        for (uint8_t level{0}; level < m_summary->nlevels; ++level) {
+            m_summary->levels[level][pos / 64].fetch_or(bit_mask[pos % 64]);
+            if constexpr (atomic_words) { std::atomic_thread_fence(std::memory_order_seq_cst); }
+            const bool still_full{(level == 0) ? is_group_full(pos) : is_summary_word_full(level - 1, pos)};
+            if (!still_full) {
+                clear_summary(level, pos);
+                return;
+            }
+            if (!is_summary_word_full(level, pos / 64)) { return; }
+            pos /= summary_fanout();
+        }
+    }
+
+    // NOTE: must be called under lock, after the words in [first_word, last_word] are set (value = true) or reset
+    void update_summary(const uint64_t first_word, const uint64_t last_word, const bool value) {
+        for (uint64_t group{first_word / summary_fanout()}; group <= last_word / summary_fanout(); ++group) {
+            if (value) {
+                // Cheap check on the updated words first, before checking the entire group
+                const uint64_t check_word{std::min((group + 1) * summary_fanout() - 1, last_word)};
+                if (nth_word(check_word)->to_integer() != static_cast< word_t >(~word_t{})) { continue; }
+                if (is_group_full(group)) { mark_summary_full(group); }
+            } else {
+                clear_summary(0, group);
+            }
+        }
+    }
+
+    // NOTE: must be called under lock. Get the first position >= pos at level which is not known to be fully set
+    uint64_t summary_next_nonfull(const uint8_t level, uint64_t pos) const {
+        const uint64_t nbits{m_summary->level_nbits[level]};
+        while (pos < nbits) {
+            const uint64_t word_num{pos / 64};
+            const uint64_t avail{~m_summary->levels[level][word_num].load() & (~uint64_t{0} << (pos % 64))};
+            if (avail) { return std::min(word_num * 64 + get_trailing_zeros(avail), nbits); }
+
+            // rest of this summary word is full, use the level above to find the next candidate summary word
+            pos = (word_num + 1) * 64;
+            if ((level + 1) < m_summary->nlevels) {
+                const uint64_t up{summary_next_nonfull(level + 1, word_num + 1)};
+                if (up >= m_summary->level_nbits[level + 1]) { return nbits; }
+                pos = std::max(pos, up * 64);
+            }
+        }
+        return nbits;
+    }
+
+    // NOTE: must be called under lock. Number of words starting from word_num which are known to be fully set from
+    // the summary
+    uint64_t summary_skip_words(const uint64_t word_num) const {
+        const uint64_t group{word_num / summary_fanout()};
+        const uint64_t next_group{summary_next_nonfull(0, group)};
+        if (next_group == group) { return 0; }
+        return std::min(next_group * summary_fanout(), static_cast< uint64_t >(m_s->m_words_cap)) - word_num;
+    }
+
+    // NOTE: must be called under lock. Get the last position <= pos at level which is not known to be fully set, npos
+    // if there is none
+    uint64_t summary_prev_nonfull(const uint8_t level, uint64_t pos) const {
+        while (true) {
+            const uint64_t word_num{pos / 64};
+            const uint64_t avail{~m_summary->levels[level][word_num].load() & consecutive_bitmask[pos % 64]};
+            if (avail) { return word_num * 64 + logBase2(avail); }
+            if (word_num == 0) { return npos; }
+
+            // rest of this summary word is full, use the level above to find the previous candidate summary word
+            pos = word_num * 64 - 1;
+            if ((level + 1) < m_summary->nlevels) {
+                const uint64_t up{summary_prev_nonfull(level + 1, word_num - 1)};
+                if (up == npos) { return npos; }
+                pos = std::min(pos, up * 64 + 63);
+            }
+        }
+    }
+
+    // NOTE: must be called under lock. Number of words ending at word_num (inclusive) backwards which are known to be
+    // fully set from the summary
+    uint64_t summary_prev_skip_words(const uint64_t word_num) const {
+        const uint64_t group{word_num / summary_fanout()};
+        const uint64_t prev_group{summary_prev_nonfull(0, group)};
+        if (prev_group == group) { return 0; }
+        return word_num + 1 - ((prev_group == npos) ? 0 : (prev_group + 1) * summary_fanout());
+    }
+
+    // NOTE: must be called under lock
+    uint64_t word_index(const bitword_type* const word_ptr) const {
+        return static_cast< uint64_t >(word_ptr - m_s->get_words_const());
+    }
+
     // NOTE: must be called under lock
     bitword_type* get_word(const uint64_t bit) {
         assert(m_s);
@@ -1244,6 +3238,37 @@ inline bool operator!=(const BitsetImpl< Word, ThreadSafeResizing >& bitset1,
     return bitset1.operator!=(bitset2);
 }
 
+/**
+ * @brief FileBackedBitsetImpl: Bitset backed by a memory mapped file. If the file already has a bitset in it, it is
+ * loaded as is, otherwise the file is created with nbits all reset. All updates go directly to the mapping and the pages modified are tracked, so that flush_dirty() writes back only those pages instead of the
+ * entire bitset.
+ *
+ * NOTE: Resize and compaction (shrink_head) rewrite the entire file into a new mapping, which would leave copies
+ * sharing the buffer with a stale view of the file. Hence it cannot be shared: copy construction and assignment are
+ * deleted, both into another file backed bitset and into a plain one. Use copy() to get an independent in memory copy.
+ */
+template < typename Word, const bool ThreadSafeResizing = false >
+class FileBackedBitsetImpl : public BitsetImpl< Word, ThreadSafeResizing > {
+public:
+    /**
+     * @param file_path Path of the file to map
+     * @param nbits Number of bits of the bitset. If the file already has a bitset of a different size,
+     * std::invalid_argument is thrown. Defaults to 0 bits when the file is created.
+     * @param id Persistent id of the bitset, checked the same way as nbits
+     * @param summary_levels Number of summary levels to maintain, see enable_summary()
+     */
+    explicit FileBackedBitsetImpl(const std::string& file_path, const std::optional< uint64_t > nbits = std::nullopt,
+                                  const std::optional< uint64_t > id = std::nullopt,
+                                  const uint8_t summary_levels = 0) :
+            BitsetImpl< Word, ThreadSafeResizing >{file_path, nbits, id, summary_levels} {}
+
+    FileBackedBitsetImpl(const FileBackedBitsetImpl&) = delete;
+    FileBackedBitsetImpl& operator=(const FileBackedBitsetImpl&) = delete;
+    FileBackedBitsetImpl(FileBackedBitsetImpl&&) noexcept = default;
+    FileBackedBitsetImpl& operator=(FileBackedBitsetImpl&&) noexcept = default;
+    ~FileBackedBitsetImpl() = default;
+};
+
 /**
  * @brief Bitset: Plain bitset with no safety. Concurrent updates and access are not thread safe and it is
  * expected the user to handle that. This is equivalent to boost::dynamic_bitset
@@ -1268,4 +3293,11 @@ typedef BitsetImpl< Bitword< safe_bits< uint64_t > >, false > AtomicBitset;
  */
 typedef BitsetImpl< Bitword< safe_bits< uint64_t > >, true > ThreadSafeBitset;
 
+/**
+ * @brief File backed versions of the above, with the same thread safety
+ */
+typedef FileBackedBitsetImpl< Bitword< unsafe_bits< uint64_t > >, false > FileBackedBitset;
+typedef FileBackedBitsetImpl< Bitword< safe_bits< uint64_t > >, false > FileBackedAtomicBitset;
+typedef FileBackedBitsetImpl< Bitword< safe_bits< uint64_t > >, true > FileBackedThreadSafeBitset;
+
 } // namespace sisl
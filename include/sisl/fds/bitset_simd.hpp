@@ -0,0 +1,378 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam, Bryan Zimmerman
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#if defined __x86_64__ && (defined __GNUC__ || defined __clang__)
+#define SISL_BITSET_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#include <sisl/utility/enum.hpp>
+
+//
+// Word array scan kernels used by the bitset family. Each kernel has a scalar version and, on x86_64, AVX2 and
+// AVX-512 versions which are compiled with function level target attributes. So the library does not need any
+// special compile flags and the right variant is picked at runtime based on what the cpu supports.
+// The kernels read and write the words with plain vector loads and stores, so only the bitsets with plain words
+// (sisl::Bitset) use them. Atomic words are always accessed one word at a time.
+//
+
+namespace sisl {
+ENUM(bitset_isa, uint8_t, scalar, avx2, avx512)
+ENUM(bitwise_op, uint8_t, and_with, or_with, xor_with, andnot_with)
+
+namespace bitset_simd {
+
+// Kernels operate on raw 64 bit words. Only Bitwords which are laid out exactly as a uint64_t can use them.
+template < typename BitwordType >
+constexpr bool is_vectorizable() {
+    return std::is_same_v< typename BitwordType::word_t, uint64_t > && (sizeof(BitwordType) == sizeof(uint64_t)) &&
+        std::is_standard_layout_v< BitwordType >;
+}
+
+inline bool is_isa_supported(const bitset_isa isa) {
+    switch (isa) {
+    case bitset_isa::scalar:
+        return true;
+#ifdef SISL_BITSET_X86_SIMD
+    case bitset_isa::avx2:
+        return __builtin_cpu_supports("avx2");
+    case bitset_isa::avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+inline bitset_isa detect_isa() {
+    if (is_isa_supported(bitset_isa::avx512)) { return bitset_isa::avx512; }
+    if (is_isa_supported(bitset_isa::avx2)) { return bitset_isa::avx2; }
+    return bitset_isa::scalar;
+}
+
+inline std::atomic< bitset_isa >& isa_holder() {
+    static std::atomic< bitset_isa > s_isa{detect_isa()};
+    return s_isa;
+}
+
+/**
+ * @brief Get the instruction set the bitset kernels are currently dispatched to
+ */
+inline bitset_isa active_isa() { return isa_holder().load(std::memory_order_relaxed); }
+
+/**
+ * @brief Force the bitset kernels to a particular instruction set. Primarily meant for tests and benchmarks to
+ * compare variants.
+ *
+ * @return false if the cpu does not support the requested isa, in which case active isa is left unchanged
+ */
+inline bool set_active_isa(const bitset_isa isa) {
+    if (!is_isa_supported(isa)) { return false; }
+    isa_holder().store(isa, std::memory_order_relaxed);
+    return true;
+}
+
+inline bool is_bmi2_supported() {
+#ifdef SISL_BITSET_X86_SIMD
+    return __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("abm");
+#else
+    return false;
+#endif
+}
+
+inline std::atomic< bool >& bmi2_holder() {
+    static std::atomic< bool > s_bmi2{is_bmi2_supported()};
+    return s_bmi2;
+}
+
+/**
+ * @brief Whether the single word bit run matching (Bitword::get_next_reset_bits_filtered) uses the BMI2 version.
+ * It is independent of the active isa, since cpus can have BMI2 without the wider vector units.
+ */
+inline bool is_bmi2_enabled() { return bmi2_holder().load(std::memory_order_relaxed); }
+
+/**
+ * @brief Turn the BMI2 run matching on or off. Primarily meant for tests and benchmarks to compare variants.
+ *
+ * @return false if enabling is requested but the cpu does not support BMI2, in which case it is left unchanged
+ */
+inline bool set_bmi2_enabled(const bool enable) {
+    if (enable && !is_bmi2_supported()) { return false; }
+    bmi2_holder().store(enable, std::memory_order_relaxed);
+    return true;
+}
+
+inline uint64_t count_equal_words_scalar(const uint64_t* const words, const uint64_t nwords,
+                                         const uint64_t pattern) {
+    uint64_t i{0};
+    while ((i < nwords) && (words[i] == pattern)) {
+        ++i;
+    }
+    return i;
+}
+
+#ifdef SISL_BITSET_X86_SIMD
+__attribute__((target("avx2"))) inline uint64_t count_equal_words_avx2(const uint64_t* const words,
+                                                                       const uint64_t nwords, const uint64_t pattern) {
+    const __m256i pat{_mm256_set1_epi64x(static_cast< long long >(pattern))};
+    uint64_t i{0};
+    for (; (i + 4) <= nwords; i += 4) {
+        const __m256i v{_mm256_loadu_si256(reinterpret_cast< const __m256i* >(words + i))};
+        const uint32_t mask{static_cast< uint32_t >(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, pat))))};
+        if (mask != 0xF) { return i + __builtin_ctz(~mask); }
+    }
+    return i + count_equal_words_scalar(words + i, nwords - i, pattern);
+}
+
+__attribute__((target("avx512f"))) inline uint64_t
+count_equal_words_avx512(const uint64_t* const words, const uint64_t nwords, const uint64_t pattern) {
+    const __m512i pat{_mm512_set1_epi64(static_cast< long long >(pattern))};
+    uint64_t i{0};
+    for (; (i + 8) <= nwords; i += 8) {
+        const __m512i v{_mm512_loadu_si512(static_cast< const void* >(words + i))};
+        const uint32_t mask{static_cast< uint32_t >(_mm512_cmpeq_epi64_mask(v, pat))};
+        if (mask != 0xFF) { return i + __builtin_ctz(~mask); }
+    }
+    return i + count_equal_words_scalar(words + i, nwords - i, pattern);
+}
+#endif
+
+/**
+ * @brief Count the number of leading words (upto nwords) which are exactly equal to the pattern. Used to skip over
+ * fully set (pattern = ~0) or fully reset (pattern = 0) stretches of a bitset.
+ */
+inline uint64_t count_equal_words(const uint64_t* const words, const uint64_t nwords, const uint64_t pattern) {
+#ifdef SISL_BITSET_X86_SIMD
+    switch (active_isa()) {
+    case bitset_isa::avx512:
+        return count_equal_words_avx512(words, nwords, pattern);
+    case bitset_isa::avx2:
+        return count_equal_words_avx2(words, nwords, pattern);
+    default:
+        break;
+    }
+#endif
+    return count_equal_words_scalar(words, nwords, pattern);
+}
+inline void bitwise_words_scalar(const bitwise_op op, uint64_t* const dst, const uint64_t* const src,
+                                 const uint64_t nwords) {
+    switch (op) {
+    case bitwise_op::and_with:
+        for (uint64_t i{0}; i < nwords; ++i) {
+            dst[i] &= src[i];
+        }
+        break;
+    case bitwise_op::or_with:
+        for (uint64_t i{0}; i < nwords; ++i) {
+            dst[i] |= src[i];
+        }
+        break;
+    case bitwise_op::xor_with:
+        for (uint64_t i{0}; i < nwords; ++i) {
+            dst[i] ^= src[i];
+        }
+        break;
+    case bitwise_op::andnot_with:
+        for (uint64_t i{0}; i < nwords; ++i) {
+            dst[i] &= ~src[i];
+        }
+        break;
+    }
+}
+
+inline uint64_t count_and_words_scalar(const uint64_t* const a, const uint64_t* const b, const uint64_t nwords,
+                                       const bool negate_b) {
+    const uint64_t flip{negate_b ? ~uint64_t{0} : 0};
+    uint64_t count{0};
+    for (uint64_t i{0}; i < nwords; ++i) {
+        count += static_cast< uint64_t >(__builtin_popcountll(a[i] & (b[i] ^ flip)));
+    }
+    return count;
+}
+
+#ifdef SISL_BITSET_X86_SIMD
+__attribute__((target("avx2"))) inline void bitwise_words_avx2(const bitwise_op op, uint64_t* const dst,
+                                                               const uint64_t* const src, const uint64_t nwords) {
+    uint64_t i{0};
+    for (; (i + 4) <= nwords; i += 4) {
+        __m256i* const d{reinterpret_cast< __m256i* >(dst + i)};
+        const __m256i dv{_mm256_loadu_si256(d)};
+        const __m256i sv{_mm256_loadu_si256(reinterpret_cast< const __m256i* >(src + i))};
+        switch (op) {
+        case bitwise_op::and_with:
+            _mm256_storeu_si256(d, _mm256_and_si256(dv, sv));
+            break;
+        case bitwise_op::or_with:
+            _mm256_storeu_si256(d, _mm256_or_si256(dv, sv));
+            break;
+        case bitwise_op::xor_with:
+            _mm256_storeu_si256(d, _mm256_xor_si256(dv, sv));
+            break;
+        case bitwise_op::andnot_with:
+            _mm256_storeu_si256(d, _mm256_andnot_si256(sv, dv));
+            break;
+        }
+    }
+    bitwise_words_scalar(op, dst + i, src + i, nwords - i);
+}
+
+__attribute__((target("avx512f"))) inline void bitwise_words_avx512(const bitwise_op op, uint64_t* const dst,
+                                                                    const uint64_t* const src, const uint64_t nwords) {
+    const __m512i ones{_mm512_set1_epi64(-1)};
+    uint64_t i{0};
+    for (; (i + 8) <= nwords; i += 8) {
+        const __m512i dv{_mm512_loadu_si512(static_cast< const void* >(dst + i))};
+        const __m512i sv{_mm512_loadu_si512(static_cast< const void* >(src + i))};
+        switch (op) {
+        case bitwise_op::and_with:
+            _mm512_storeu_si512(static_cast< void* >(dst + i), _mm512_and_si512(dv, sv));
+            break;
+        case bitwise_op::or_with:
+            _mm512_storeu_si512(static_cast< void* >(dst + i), _mm512_or_si512(dv, sv));
+            break;
+        case bitwise_op::xor_with:
+            _mm512_storeu_si512(static_cast< void* >(dst + i), _mm512_xor_si512(dv, sv));
+            break;
+        case bitwise_op::andnot_with:
+            // spelt as and of the complement, since _mm512_andnot_si512 trips maybe-uninitialized on some gcc versions
+            _mm512_storeu_si512(static_cast< void* >(dst + i), _mm512_and_si512(dv, _mm512_xor_si512(sv, ones)));
+            break;
+        }
+    }
+    bitwise_words_scalar(op, dst + i, src + i, nwords - i);
+}
+
+// Nibble lookup popcount (Mula et al), summing up byte counts of each 64 bit lane with sad
+__attribute__((target("avx2"))) inline uint64_t count_and_words_avx2(const uint64_t* const a, const uint64_t* const b,
+                                                                     const uint64_t nwords, const bool negate_b) {
+    const __m256i lookup{_mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                          2, 3, 2, 3, 3, 4)};
+    const __m256i low_mask{_mm256_set1_epi8(0x0f)};
+    const __m256i flip{negate_b ? _mm256_set1_epi64x(-1) : _mm256_setzero_si256()};
+    __m256i acc{_mm256_setzero_si256()};
+    uint64_t i{0};
+    for (; (i + 4) <= nwords; i += 4) {
+        const __m256i av{_mm256_loadu_si256(reinterpret_cast< const __m256i* >(a + i))};
+        const __m256i bv{_mm256_loadu_si256(reinterpret_cast< const __m256i* >(b + i))};
+        const __m256i v{_mm256_and_si256(av, _mm256_xor_si256(bv, flip))};
+        const __m256i lo{_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_mask))};
+        const __m256i hi{_mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask))};
+        const __m256i cnt{_mm256_add_epi8(lo, hi)};
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+    }
+    uint64_t count{static_cast< uint64_t >(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                                           _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3))};
+    return count + count_and_words_scalar(a + i, b + i, nwords - i, negate_b);
+}
+#endif
+
+/**
+ * @brief dst[i] = dst[i] op src[i] for nwords words
+ */
+inline void bitwise_words(const bitwise_op op, uint64_t* const dst, const uint64_t* const src,
+                          const uint64_t nwords) {
+#ifdef SISL_BITSET_X86_SIMD
+    switch (active_isa()) {
+    case bitset_isa::avx512:
+        return bitwise_words_avx512(op, dst, src, nwords);
+    case bitset_isa::avx2:
+        return bitwise_words_avx2(op, dst, src, nwords);
+    default:
+        break;
+    }
+#endif
+    bitwise_words_scalar(op, dst, src, nwords);
+}
+
+/**
+ * @brief Number of bits set in both a and b (or in a and not in b if negate_b) across nwords words
+ */
+inline uint64_t count_and_words(const uint64_t* const a, const uint64_t* const b, const uint64_t nwords,
+                                const bool negate_b = false) {
+#ifdef SISL_BITSET_X86_SIMD
+    // AVX-512 without VPOPCNTDQ does not have anything better than the AVX2 nibble lookup
+    if (active_isa() != bitset_isa::scalar) { return count_and_words_avx2(a, b, nwords, negate_b); }
+#endif
+    return count_and_words_scalar(a, b, nwords, negate_b);
+}
+
+inline uint64_t count_matching_words_scalar(const uint64_t* const a, const uint64_t* const b,
+                                            const uint64_t nwords, const bool equal) {
+    uint64_t i{0};
+    while ((i < nwords) && ((a[i] == b[i]) == equal)) {
+        ++i;
+    }
+    return i;
+}
+
+#ifdef SISL_BITSET_X86_SIMD
+__attribute__((target("avx2"))) inline uint64_t count_matching_words_avx2(const uint64_t* const a,
+                                                                          const uint64_t* const b,
+                                                                          const uint64_t nwords, const bool equal) {
+    const uint32_t flip{equal ? 0xFu : 0u};
+    uint64_t i{0};
+    for (; (i + 4) <= nwords; i += 4) {
+        const __m256i av{_mm256_loadu_si256(reinterpret_cast< const __m256i* >(a + i))};
+        const __m256i bv{_mm256_loadu_si256(reinterpret_cast< const __m256i* >(b + i))};
+        const uint32_t mask{
+            static_cast< uint32_t >(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(av, bv)))) ^ flip};
+        if (mask != 0) { return i + __builtin_ctz(mask); }
+    }
+    return i + count_matching_words_scalar(a + i, b + i, nwords - i, equal);
+}
+
+__attribute__((target("avx512f"))) inline uint64_t count_matching_words_avx512(const uint64_t* const a,
+                                                                               const uint64_t* const b,
+                                                                               const uint64_t nwords,
+                                                                               const bool equal) {
+    const uint32_t flip{equal ? 0xFFu : 0u};
+    uint64_t i{0};
+    for (; (i + 8) <= nwords; i += 8) {
+        const __m512i av{_mm512_loadu_si512(static_cast< const void* >(a + i))};
+        const __m512i bv{_mm512_loadu_si512(static_cast< const void* >(b + i))};
+        const uint32_t mask{static_cast< uint32_t >(_mm512_cmpeq_epi64_mask(av, bv)) ^ flip};
+        if (mask != 0) { return i + __builtin_ctz(mask); }
+    }
+    return i + count_matching_words_scalar(a + i, b + i, nwords - i, equal);
+}
+#endif
+
+/**
+ * @brief Count the number of leading words (upto nwords) where a and b are equal (or differ if equal is false). Used
+ * to find the changed stretches between two versions of a bitset.
+ */
+inline uint64_t count_matching_words(const uint64_t* const a, const uint64_t* const b, const uint64_t nwords,
+                                     const bool equal) {
+#ifdef SISL_BITSET_X86_SIMD
+    switch (active_isa()) {
+    case bitset_isa::avx512:
+        return count_matching_words_avx512(a, b, nwords, equal);
+    case bitset_isa::avx2:
+        return count_matching_words_avx2(a, b, nwords, equal);
+    default:
+        break;
+    }
+#endif
+    return count_matching_words_scalar(a, b, nwords, equal);
+}
+} // namespace bitset_simd
+} // namespace sisl
@@ -25,11 +25,15 @@
 #include <cassert>
 #include <cstdint>
 #include <iostream>
+#include <span>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 
 #include <sisl/utility/enum.hpp>
+#include "bitset_simd.hpp"
 
 namespace sisl {
 
@@ -223,6 +227,49 @@ static inline constexpr uint8_t get_leading_zeros(const uint64_t v) {
 #endif
 }
 
+struct BitBlock {
+    uint64_t start_bit;
+    uint32_t nbits;
+    BitBlock(const uint64_t start, const uint32_t bits) : start_bit{start}, nbits{bits} {}
+    BitBlock(const BitBlock&) = default;
+    BitBlock(BitBlock&&) noexcept = default;
+    BitBlock& operator=(const BitBlock&) = default;
+    BitBlock& operator=(BitBlock&&) noexcept = default;
+    ~BitBlock() = default;
+};
+
+/**
+ * @brief Sort the blocks by start bit and merge the overlapping and adjacent ones, so that a batch of blocks can be
+ * applied in a single pass. Empty blocks are dropped.
+ *
+ * @return Merged blocks as (start bit, number of bits) pairs, since merged blocks can exceed BitBlock's bit count
+ */
+static inline std::vector< std::pair< uint64_t, uint64_t > >
+merge_bit_blocks(const std::span< const BitBlock > blocks) {
+    std::vector< std::pair< uint64_t, uint64_t > > merged;
+    merged.reserve(blocks.size());
+    for (const auto& b : blocks) {
+        if (b.nbits > 0) { merged.emplace_back(b.start_bit, b.nbits); }
+    }
+    // Order of the blocks with the same start bit does not matter for the merge
+    const auto start_less{[](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; }};
+    if (!std::is_sorted(std::begin(merged), std::end(merged), start_less)) {
+        std::sort(std::begin(merged), std::end(merged), start_less);
+    }
+
+    size_t last{0};
+    for (size_t i{1}; i < merged.size(); ++i) {
+        auto& [start, nbits]{merged[last]};
+        if (merged[i].first <= (start + nbits)) {
+            nbits = std::max(start + nbits, merged[i].first + merged[i].second) - start;
+        } else {
+            merged[++last] = merged[i];
+        }
+    }
+    if (!merged.empty()) { merged.resize(last + 1); }
+    return merged;
+}
+
 ENUM(bit_match_type, uint8_t, no_match, full_match, lsb_match, mid_match, msb_match)
 
 struct bit_filter {
@@ -268,6 +315,76 @@ struct bit_match_result {
     }
 };
 
+#ifdef SISL_BITSET_X86_SIMD
+//
+// BMI2 version of Bitword::get_next_reset_bits_filtered for 64 bit words. Instead of walking the runs of the word one
+// at a time, it computes the result in closed form: the lsb and msb runs with tzcnt/lzcnt and the first mid run of the
+// required size by folding the reset bits mask onto itself (log2(n_mid_reqd) shift-ands), with bzhi/shrx for the
+// variable masks and shifts. The results are identical to the generic version, including the start/count of no_match.
+//
+// The result is returned packed as match_type | start_bit << 8 | count << 16 and unpacked by the caller, since gcc
+// assembles a bit_match_result returned from a target function through the stack and stalls on store forwarding.
+//
+namespace bitword_bmi2 {
+static constexpr uint32_t pack(const bit_match_type match_type, const uint32_t start_bit, const uint32_t count) {
+    return static_cast< uint32_t >(match_type) | (start_bit << 8) | (count << 16);
+}
+
+static inline bit_match_result unpack(const uint32_t packed) {
+    return bit_match_result{static_cast< bit_match_type >(packed & 0xFF), static_cast< uint8_t >(packed >> 8),
+                            static_cast< uint8_t >(packed >> 16)};
+}
+
+__attribute__((target("bmi,bmi2,lzcnt"), always_inline)) inline uint32_t
+match_reset_bits_impl(const uint64_t word, const uint8_t offset, const uint32_t lsb_reqd, const uint32_t mid_reqd,
+                      const uint32_t msb_reqd) {
+    const uint64_t in_range{~uint64_t{0} << offset};
+    const uint64_t reset_bits{~word & in_range};
+    if (reset_bits == 0) { return pack(bit_match_type::no_match, 64, 0); }
+
+    if ((offset == 0) && (reset_bits & 1)) {
+        const uint32_t lsb_count{static_cast< uint32_t >(_tzcnt_u64(word))};
+        if (lsb_count >= lsb_reqd) {
+            return pack((word == 0) ? bit_match_type::full_match : bit_match_type::lsb_match, 0, lsb_count);
+        }
+    }
+
+    // Reset run touching the msb, it is looked at only after all the runs below it
+    const uint32_t msb_count{static_cast< uint32_t >((word & in_range) ? _lzcnt_u64(word) : (64 - offset))};
+    if (mid_reqd <= 64) {
+        // After folding, a bit remains set only if it starts a run of atleast mid_reqd reset bits
+        uint64_t starts{_bzhi_u64(reset_bits, 64 - msb_count)};
+        uint32_t len{1};
+        while ((len < mid_reqd) && starts) {
+            const uint32_t shift{std::min(len, mid_reqd - len)};
+            starts &= (starts >> shift);
+            len += shift;
+        }
+        if (starts) {
+            const uint32_t start_bit{static_cast< uint32_t >(_tzcnt_u64(starts))};
+            return pack(bit_match_type::mid_match, start_bit, static_cast< uint32_t >(_tzcnt_u64(word >> start_bit)));
+        }
+    }
+
+    if (msb_count == 0) { return pack(bit_match_type::no_match, 64, 0); }
+    return pack(((msb_count >= mid_reqd) || (msb_count >= msb_reqd)) ? bit_match_type::msb_match
+                                                                      : bit_match_type::no_match,
+                64 - msb_count, msb_count);
+}
+
+__attribute__((target("bmi,bmi2,lzcnt"))) inline uint32_t match_reset_bits(const uint64_t word, const uint8_t offset,
+                                                                         const bit_filter& filter) {
+    return match_reset_bits_impl(word, offset, filter.n_lsb_reqd, filter.n_mid_reqd, filter.n_msb_reqd);
+}
+
+// Filter known at compile time, which lets the compiler drop the checks and unroll the folding for it
+template < uint32_t LsbReqd, uint32_t MidReqd, uint32_t MsbReqd >
+__attribute__((target("bmi,bmi2,lzcnt"))) inline uint32_t match_reset_bits(const uint64_t word, const uint8_t offset) {
+    return match_reset_bits_impl(word, offset, LsbReqd, MidReqd, MsbReqd);
+}
+} // namespace bitword_bmi2
+#endif
+
 template < typename Word >
 class Bitword {
 public:
@@ -292,6 +409,13 @@ public:
 
     void set(const word_t& value) { m_bits.set(value); }
 
+    /**
+     * @brief: Bitwise and/or/xor of the value into the word, returns the resulting word
+     */
+    word_t and_with(const word_t value) { return m_bits.and_with(value); }
+    word_t or_with(const word_t value) { return m_bits.or_with(value); }
+    word_t xor_with(const word_t value) { return m_bits.xor_with(value); }
+
     /**
      * @brief:
      * Total number of bits set in the bitset
@@ -353,6 +477,25 @@ public:
         }
     }
 
+    /**
+     * @brief: Set multiple bits specified at the start, only if all of them are reset. For atomic words the check and
+     * set is done as a single compare and swap, so concurrent callers can never both succeed on overlapping bits.
+     *
+     * Returns true if the bits were all reset and are now set, false if any of them was already set
+     */
+    bool set_bits_if_reset(const uint8_t start, const uint8_t nbits) {
+        assert(start < bits());
+        const uint8_t wanted_bits{std::min< uint8_t >(bits() - start, nbits)};
+        const word_t wanted_mask{
+            static_cast< word_t >(static_cast< word_t >(consecutive_bitmask[wanted_bits - 1]) << start)};
+        word_t old_value{m_bits.get()};
+        while ((old_value & wanted_mask) == 0) {
+            if (m_bits.set_if(old_value, static_cast< word_t >(old_value | wanted_mask))) { return true; }
+            old_value = m_bits.get();
+        }
+        return false;
+    }
+
     bool get_bitval(const uint8_t bit) const { return (m_bits.get() & bit_mask[bit]); }
 
     /**
@@ -411,6 +554,18 @@ public:
         }
     }
 
+    bool get_prev_reset_bit(const uint8_t start, uint8_t* const p_reset_bit) const {
+        assert(p_reset_bit);
+        const uint8_t nbits{std::min< uint8_t >(start + 1, bits())};
+        const word_t e{static_cast< word_t >(~extract(0, nbits) & consecutive_bitmask[nbits - 1])};
+        if (e) {
+            *p_reset_bit = logBase2(e);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
     uint8_t get_next_reset_bits(const uint8_t start, uint8_t* const pcount) const {
         assert(start < bits());
         assert(pcount);
@@ -437,6 +592,37 @@ public:
     // match the number of bits required at the beginning(lsb), middle(mid), end(msb) of the value
     bit_match_result get_next_reset_bits_filtered(const uint8_t offset, const bit_filter& filter) const {
         assert(offset < bits());
+#ifdef SISL_BITSET_X86_SIMD
+        if constexpr (std::is_same_v< word_t, uint64_t >) {
+            if (bitset_simd::is_bmi2_enabled()) {
+                return bitword_bmi2::unpack(bitword_bmi2::match_reset_bits(to_integer(), offset, filter));
+            }
+        }
+#endif
+        return get_next_reset_bits_filtered_generic(offset, filter.n_lsb_reqd, filter.n_mid_reqd, filter.n_msb_reqd);
+    }
+
+    /**
+     * @brief Same as above, with the filter fixed at compile time. Meant for the common shapes, like any single
+     * reset bit (1, 1, 1) or a full word (bits(), bits(), 1), so that the matching gets specialized for them.
+     */
+    template < uint32_t LsbReqd, uint32_t MidReqd, uint32_t MsbReqd >
+    bit_match_result get_next_reset_bits_filtered(const uint8_t offset) const {
+        assert(offset < bits());
+#ifdef SISL_BITSET_X86_SIMD
+        if constexpr (std::is_same_v< word_t, uint64_t >) {
+            if (bitset_simd::is_bmi2_enabled()) {
+                return bitword_bmi2::unpack(
+                    bitword_bmi2::match_reset_bits< LsbReqd, MidReqd, MsbReqd >(to_integer(), offset));
+            }
+        }
+#endif
+        return get_next_reset_bits_filtered_generic(offset, LsbReqd, MidReqd, MsbReqd);
+    }
+
+    bit_match_result get_next_reset_bits_filtered_generic(const uint8_t offset, const uint32_t lsb_reqd,
+                                                          const uint32_t mid_reqd, const uint32_t msb_reqd) const {
+        assert(offset < bits());
         bit_match_result result{bit_match_type::no_match, offset};
         bool lsb_search{offset == 0};
 
@@ -459,7 +645,7 @@ public:
             result.count = ((e > static_cast< word_t >(0)) ? get_trailing_zeros(e) : nbits);
 
             if (lsb_search) {
-                if ((first_0bit == static_cast< uint8_t >(0)) && (result.count >= filter.n_lsb_reqd)) {
+                if ((first_0bit == static_cast< uint8_t >(0)) && (result.count >= lsb_reqd)) {
                     // We matched lsb with required count
                     result.match_type = ((e == 0) ? bit_match_type::full_match : bit_match_type::lsb_match);
                     break;
@@ -467,11 +653,11 @@ public:
             }
 
             if (e == 0) {
-                if ((result.count >= filter.n_mid_reqd) || (result.count >= filter.n_msb_reqd)) {
+                if ((result.count >= mid_reqd) || (result.count >= msb_reqd)) {
                     result.match_type = bit_match_type::msb_match;
                 }
                 break;
-            } else if (result.count >= filter.n_mid_reqd) {
+            } else if (result.count >= mid_reqd) {
                 result.match_type = bit_match_type::mid_match;
                 break;
             }
@@ -619,6 +805,11 @@ public:
         return m_Value;
     }
 
+    word_t xor_with(const word_t value) {
+        m_Value ^= value;
+        return m_Value;
+    }
+
     word_t right_shift(const uint8_t nbits) {
         m_Value >>= nbits;
         return m_Value;
@@ -649,9 +840,10 @@ public:
     ~safe_bits() = default;
 
     void set(const word_t& bits) { m_Value.store(bits, std::memory_order_relaxed); }
-    void set_if(const word_t& old_value, const word_t& new_value) {
+    bool set_if(const word_t& old_value, const word_t& new_value) {
         word_t expected_value{old_value};
-        return m_Value.compare_exchange_strong(expected_value, new_value, std::memory_order_relaxed);
+        return m_Value.compare_exchange_strong(expected_value, new_value, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed);
     }
 
     word_t or_with(const word_t value) {
@@ -664,6 +856,11 @@ public:
         return (old_value & value);
     }
 
+    word_t xor_with(const word_t value) {
+        const word_t old_value{m_Value.fetch_xor(value, std::memory_order_relaxed)};
+        return (old_value ^ value);
+    }
+
     word_t right_shift(const uint8_t nbits) {
         word_t old_value{m_Value.get(std::memory_order_acquire)};
         word_t new_value{static_cast< word_t >(old_value >> nbits)};
@@ -462,7 +462,9 @@ public:
         m_view.set_bytes(v.m_view.cbytes() + offset);
         m_view.set_size(sz);
     }
-    byte_view(const sisl::io_blob& b) : byte_view(b.size(), b.is_aligned()) {}
+    byte_view(const sisl::io_blob& b) : byte_view(b.size(), b.is_aligned()) {
+        std::memcpy(m_base_buf->bytes(), b.cbytes(), b.size());
+    }
 
     ~byte_view() = default;
     byte_view(const byte_view& other) = default;
@@ -15,6 +15,7 @@
  *
  *********************************************************************************/
 #include <cstdint>
+#include <span>
 #include <sisl/fds/bitword.hpp>
 #include <sisl/fds/utils.hpp>
 #include <sisl/fds/buffer.hpp>
@@ -84,17 +85,149 @@ public:
     /// is 1, it will return the start bit.
     /// @param start_bit: Start bit should be > 0 and <= size()
     /// @return Returns the previous set bit or inval_bit if nothing is set
-    bit_count_t get_prev_set_bit(bit_count_t start_bit) const {
+    bit_count_t get_prev_set_bit(bit_count_t start_bit) const { return get_prev_set_or_reset_bit(start_bit, true); }
+    bit_count_t get_prev_reset_bit(bit_count_t start_bit) const { return get_prev_set_or_reset_bit(start_bit, false); }
+
+    /// @brief This method gets the last n contiguous reset bits ending at or before the start bit, by walking the
+    /// runs backwards.
+    /// @param start_bit: Start bit should be < size()
+    /// @return Returns the block of n reset bits with the highest start bit or {inval_bit, 0} if there is none
+    BitBlock get_prev_contiguous_n_reset_bits(bit_count_t start_bit, uint32_t n) const {
+        DEBUG_ASSERT_GT(n, 0, "compact bitset contiguous search needs n > 0");
+        bit_count_t bit = start_bit;
+        while (true) {
+            bit_count_t const top = get_prev_reset_bit(bit);
+            if (top == inval_bit) { break; }
+            bit_count_t const below = (top == 0) ? inval_bit : get_prev_set_bit(top - 1);
+            uint32_t const len = (below == inval_bit) ? top + 1 : top - below;
+            if (len >= n) { return BitBlock{top - n + 1, n}; }
+            if ((below == inval_bit) || (below == 0)) { break; }
+            bit = below - 1;
+        }
+        return BitBlock{inval_bit, 0};
+    }
+
+    void set_reset_bit(bit_count_t bit, bool value) {
+        bitword_type* word_ptr = get_word(bit);
+        if (!word_ptr) { return; }
+        uint8_t const offset = get_word_offset(bit);
+        word_ptr->set_reset_bits(offset, 1, value);
+    }
+
+    /// @brief Set or reset n bits from the start bit, a whole word at a time. Bits beyond size() are ignored.
+    void set_bits(bit_count_t start, bit_count_t n) { set_reset_bits(start, n, true); }
+    void reset_bits(bit_count_t start, bit_count_t n) { set_reset_bits(start, n, false); }
+
+    void set_reset_bits(bit_count_t start, bit_count_t n, bool value) {
+        if (start >= size()) { return; }
+        DEBUG_ASSERT_LE(uint64_t{start} + n, size(), "compact bitset set/reset bits beyond size");
+        uint64_t nbits = std::min< uint64_t >(n, size() - start);
+        if (nbits == 0) { return; }
+
+        bitword_type* word_ptr = get_word(start);
+        uint8_t const offset = get_word_offset(start);
+        if ((offset > 0) || (nbits < bitword_type::bits())) {
+            uint8_t const count = s_cast< uint8_t >(std::min< uint64_t >(bitword_type::bits() - offset, nbits));
+            (word_ptr++)->set_reset_bits(offset, count, value);
+            nbits -= count;
+        }
+        for (; nbits >= bitword_type::bits(); nbits -= bitword_type::bits()) {
+            (word_ptr++)->set(value ? ~uint64_t{0} : uint64_t{0});
+        }
+        if (nbits > 0) { word_ptr->set_reset_bits(0, s_cast< uint8_t >(nbits), value); }
+    }
+
+    /// @brief Set the bits of a batch of blocks in one pass. Blocks can be in any order and can overlap, adjacent
+    /// blocks are merged and the whole words are stored in one go. Bits beyond size() are ignored.
+    void set_bits_batch(std::span< const BitBlock > blocks) { set_reset_bits_batch(blocks, true); }
+    void reset_bits_batch(std::span< const BitBlock > blocks) { set_reset_bits_batch(blocks, false); }
+
+    void set_reset_bits_batch(std::span< const BitBlock > blocks, bool value) {
+        for (auto const& [start, count] : merge_bit_blocks(blocks)) {
+            if (start >= size()) { break; }
+            set_reset_bits(s_cast< bit_count_t >(start), s_cast< bit_count_t >(std::min< uint64_t >(count, size())),
+                           value);
+        }
+    }
+
+    /// @brief Count the set bits in the range [start_bit, end_bit], both inclusive, a whole word at a time.
+    /// @param end_bit: End bit of the range, if it is beyond size() counts till the end
+    bit_count_t count_set_bits(bit_count_t start_bit, bit_count_t end_bit = inval_bit) const {
+        if (start_bit >= size()) { return 0; }
+        bit_count_t const last_bit = std::min(end_bit, size() - 1);
+        DEBUG_ASSERT_LE(start_bit, last_bit, "compact bitset count range is inverted");
+
+        bit_count_t const first_word = get_word_index(start_bit);
+        bit_count_t const last_word = get_word_index(last_bit);
+        uint64_t const first_mask = ~uint64_t{0} << get_word_offset(start_bit);
+        uint64_t const last_mask = consecutive_bitmask[get_word_offset(last_bit)];
+        if (first_word == last_word) {
+            return get_set_bit_count(s_->words[first_word].to_integer() & first_mask & last_mask);
+        }
+
+        bit_count_t count = get_set_bit_count(s_->words[first_word].to_integer() & first_mask);
+        for (bit_count_t w{first_word + 1}; w < last_word; ++w) {
+            count += get_set_bit_count(s_->words[w].to_integer());
+        }
+        return count + get_set_bit_count(s_->words[last_word].to_integer() & last_mask);
+    }
+
+    /// @brief This method gets the first n contiguous reset bits at or after the start bit. Fully set and fully
+    /// reset words are consumed a word at a time and the runs within a mixed word are walked using bit scans.
+    /// @return Returns the block of n reset bits with the lowest start bit or {inval_bit, 0} if there is none
+    BitBlock get_next_contiguous_n_reset_bits(bit_count_t start_bit, uint32_t n) const {
+        DEBUG_ASSERT_GT(n, 0, "compact bitset contiguous search needs n > 0");
+        if (start_bit >= size()) { return BitBlock{inval_bit, 0}; }
+
+        bit_count_t word_idx = get_word_index(start_bit);
+        bit_count_t const num_words = size() / word_size_bits();
+        // Treat the bits before the start bit as set, so that no run starts before it
+        uint64_t val = s_->words[word_idx].to_integer() | ~(~uint64_t{0} << get_word_offset(start_bit));
+        bit_count_t run_start = 0;
+        uint64_t run_len = 0;
+        while (true) {
+            bit_count_t const word_bit = word_idx * word_size_bits();
+            if (val == 0) {
+                if (run_len == 0) { run_start = word_bit; }
+                run_len += word_size_bits();
+                if (run_len >= n) { return BitBlock{run_start, n}; }
+            } else if (val != ~uint64_t{0}) {
+                uint8_t pos = 0;
+                while (pos < word_size_bits()) {
+                    // reset run at pos followed by set run
+                    uint8_t const zeros = std::min< uint8_t >(get_trailing_zeros(val >> pos), word_size_bits() - pos);
+                    if (zeros > 0) {
+                        if (run_len == 0) { run_start = word_bit + pos; }
+                        run_len += zeros;
+                        if (run_len >= n) { return BitBlock{run_start, n}; }
+                        pos += zeros;
+                        if (pos == word_size_bits()) { break; }
+                    }
+                    run_len = 0;
+                    uint64_t const rest = ~(val >> pos);
+                    pos += (rest == 0) ? (word_size_bits() - pos) : get_trailing_zeros(rest);
+                }
+            } else {
+                run_len = 0;
+            }
+
+            if (++word_idx == num_words) { break; }
+            val = s_->words[word_idx].to_integer();
+        }
+        return BitBlock{inval_bit, 0};
+    }
+
+    bit_count_t get_prev_set_or_reset_bit(bit_count_t start_bit, bool search_for_set_bit) const {
         // check first word which may be partial
         uint8_t offset = get_word_offset(start_bit);
         bit_count_t word_idx = get_word_index(start_bit);
 
         do {
             bitword_type const* word_ptr = &s_->words[word_idx];
-            if (!word_ptr) { return inval_bit; }
-
             uint8_t nbit{0};
-            if (word_ptr->get_prev_set_bit(offset, &nbit)) { return start_bit - (offset - nbit); }
+            bool const found = search_for_set_bit ? word_ptr->get_prev_set_bit(offset, &nbit)
+                                                  : word_ptr->get_prev_reset_bit(offset, &nbit);
+            if (found) { return start_bit - (offset - nbit); }
 
             start_bit -= offset;
             offset = bitword_type::bits();
@@ -103,13 +236,6 @@ public:
         return inval_bit;
     }
 
-    void set_reset_bit(bit_count_t bit, bool value) {
-        bitword_type* word_ptr = get_word(bit);
-        if (!word_ptr) { return; }
-        uint8_t const offset = get_word_offset(bit);
-        word_ptr->set_reset_bits(offset, 1, value);
-    }
-
     bit_count_t get_next_set_or_reset_bit(bit_count_t start_bit, bool search_for_set_bit) const {
         bit_count_t ret{inval_bit};
 
@@ -16,15 +16,32 @@
  *********************************************************************************/
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <cassert>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 #include "bitset.hpp"
 #include "utils.hpp"
 
 namespace sisl {
+/**
+ * @brief Reserves unique ids from a growable bitset. Ids are claimed directly on the atomic words of the bitset, which
+ * reserve and unreserve only hold the shared lock of the bitset for, so they don't serialize on one another. Growing the
+ * bitset is the only operation which takes it exclusively.
+ *
+ * To avoid every reserve going to the bitset, each thread keeps a small range of ids pre-reserved in a cache slot and
+ * hands them out from there. Pre-reserved ids are set in the bitset, but are not considered reserved by is_reserved(),
+ * the reserved id iteration and serialize(). New ranges are claimed starting from a rotating hint, so that the search
+ * does not start over from the first id every time.
+ *
+ * NOTE: Ids are not handed out in increasing order and ids reserved or unreserved concurrently with serialize() may or
+ * may not be part of it.
+ */
 class IDReserver {
 public:
     IDReserver(uint32_t estimated_ids = 1024) : m_reserved_bits(estimated_ids) { assert(estimated_ids != 0); }
@@ -32,56 +49,145 @@ public:
     IDReserver(const sisl::byte_array& b) : m_reserved_bits(b) {}
 
     uint32_t reserve() {
-        std::unique_lock lg(m_mutex);
-        size_t nbit = m_reserved_bits.get_next_reset_bit(0);
-        if (nbit == Bitset::npos) {
-            // We ran out of room to allocate bits, resize and allocate more
-            const auto cur_size = m_reserved_bits.size();
-            assert(cur_size != 0);
-            m_reserved_bits.resize(cur_size * 2);
-            nbit = cur_size;
+        auto& cache{m_caches[thread_slot()].range};
+        uint64_t range{cache.load(std::memory_order_acquire)};
+        while (range_next(range) < range_end(range)) {
+            if (cache.compare_exchange_weak(range, range + 1, std::memory_order_acq_rel)) { return range_next(range); }
+        }
+
+        // Cache is empty, claim a new range of ids from the bitset and keep the rest of it in the cache
+        const BitBlock b{claim_ids(cache_batch())};
+        const uint32_t id{static_cast< uint32_t >(b.start_bit)};
+        if (b.nbits > 1) {
+            if (!cache.compare_exchange_strong(range, pack_range(id + 1, id + b.nbits), std::memory_order_acq_rel)) {
+                // Another thread sharing the slot refilled it meanwhile, give the rest back
+                m_reserved_bits.reset_bits(id + 1, b.nbits - 1);
+            }
         }
-        m_reserved_bits.set_bit(nbit);
-        return nbit;
+        return id;
     }
 
     void reserve(uint32_t id) {
-        std::unique_lock lg(m_mutex);
-        assert(!(m_reserved_bits.get_bitval(id)));
         assert(id < m_reserved_bits.size());
-        m_reserved_bits.set_bit(id);
+        // A concurrent reserve() may have claimed the id as part of a range it is yet to put in its cache, so if the
+        // id is neither free nor cached, look in the caches again after it gets there
+        for (uint32_t attempt{0}; attempt < s_max_reserve_attempts; ++attempt) {
+            if (take_from_caches(id) || m_reserved_bits.claim_bit(id)) { return; }
+            std::this_thread::yield();
+        }
+        assert(false && "id is already reserved");
     }
 
     void unreserve(uint32_t id) {
-        std::unique_lock lg(m_mutex);
         assert(id < m_reserved_bits.size());
         m_reserved_bits.reset_bit(id);
     }
 
-    bool is_reserved(uint32_t id) {
-        std::unique_lock lg(m_mutex);
-        return m_reserved_bits.get_bitval(id);
-    }
+    bool is_reserved(uint32_t id) { return m_reserved_bits.get_bitval(id) && !is_cached(id); }
 
     sisl::byte_array serialize() {
-        std::unique_lock lg(m_mutex);
-        return m_reserved_bits.serialize();
+        // Pre-reserved ids are not persisted. Take them out of a copy, since they still need to be set in the live bits
+        ThreadSafeBitset reserved_bits{m_reserved_bits.size()};
+        reserved_bits.copy(m_reserved_bits);
+        for (const auto& slot : m_caches) {
+            const uint64_t range{slot.range.load(std::memory_order_acquire)};
+            if (range_next(range) < range_end(range)) {
+                reserved_bits.reset_bits(range_next(range), range_end(range) - range_next(range));
+            }
+        }
+        return reserved_bits.serialize();
     }
 
     bool first_reserved_id(uint32_t& found_id) { return find_next_reserved_id(true, found_id); }
     bool next_reserved_id(uint32_t& last_found_id) { return find_next_reserved_id(false, last_found_id); }
 
 private:
+    static constexpr uint32_t s_cache_slots{16};
+    static constexpr uint32_t s_max_reserve_attempts{1000};
+    static constexpr uint32_t max_cached_ids() { return 64; }
+
+    // Cache slot holds a range of pre-reserved ids [next, end) packed into one word, so that it can be updated by CAS
+    struct alignas(64) cache_slot {
+        std::atomic< uint64_t > range{0};
+    };
+    static constexpr uint64_t pack_range(const uint32_t next, const uint32_t end) {
+        return (static_cast< uint64_t >(end) << 32) | next;
+    }
+    static constexpr uint32_t range_next(const uint64_t range) { return static_cast< uint32_t >(range); }
+    static constexpr uint32_t range_end(const uint64_t range) { return static_cast< uint32_t >(range >> 32); }
+
+    static uint32_t thread_slot() {
+        static std::atomic< uint32_t > s_next_slot{0};
+        static thread_local const uint32_t slot{s_next_slot.fetch_add(1, std::memory_order_relaxed) % s_cache_slots};
+        return slot;
+    }
+
+    // Keep the ids held in the caches a small fraction of the total
+    uint32_t cache_batch() const {
+        return static_cast< uint32_t >(
+            std::clamp< uint64_t >(m_reserved_bits.size() / (4 * s_cache_slots), 1, max_cached_ids()));
+    }
+
+    // Claim a range of upto n free ids starting from the rotating hint, growing the bitset if all of them are taken
+    BitBlock claim_ids(const uint32_t n) {
+        const uint64_t hint{m_next_hint.load(std::memory_order_relaxed)};
+        BitBlock b{m_reserved_bits.claim_next_contiguous_n_reset_bits(hint, 1, n)};
+        if ((b.nbits == 0) && (hint > 0)) { b = m_reserved_bits.claim_next_contiguous_n_reset_bits(0, 1, n); }
+        if (b.nbits == 0) {
+            // We ran out of room to allocate bits, resize and allocate more. Someone else could have grown it or
+            // freed ids meanwhile, so look again under the lock.
+            std::unique_lock lg(m_grow_mutex);
+            uint64_t search_bit{0};
+            while ((b = m_reserved_bits.claim_next_contiguous_n_reset_bits(search_bit, 1, n)).nbits == 0) {
+                const auto cur_size{m_reserved_bits.size()};
+                assert(cur_size != 0);
+                m_reserved_bits.resize(cur_size * 2);
+                search_bit = cur_size;
+            }
+        }
+        m_next_hint.store(b.start_bit + b.nbits, std::memory_order_relaxed);
+        return b;
+    }
+
+    // If the id is pre-reserved in any of the caches, take it out of the cache and give the ids after it back, so
+    // that the id stays reserved
+    bool take_from_caches(const uint32_t id) {
+        for (auto& slot : m_caches) {
+            uint64_t range{slot.range.load(std::memory_order_acquire)};
+            while ((range_next(range) <= id) && (id < range_end(range))) {
+                const uint64_t new_range{(id == range_next(range)) ? (range + 1) : pack_range(range_next(range), id)};
+                if (slot.range.compare_exchange_weak(range, new_range, std::memory_order_acq_rel)) {
+                    if ((id != range_next(range)) && ((id + 1) < range_end(range))) {
+                        m_reserved_bits.reset_bits(id + 1, range_end(range) - id - 1);
+                    }
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool is_cached(const uint32_t id) const {
+        return std::any_of(std::begin(m_caches), std::end(m_caches), [id](const cache_slot& slot) {
+            const uint64_t range{slot.range.load(std::memory_order_acquire)};
+            return (range_next(range) <= id) && (id < range_end(range));
+        });
+    }
+
     bool find_next_reserved_id(bool first, uint32_t& last_found_id) {
-        std::unique_lock lg(m_mutex);
         size_t nbit = m_reserved_bits.get_next_set_bit(first ? 0 : last_found_id + 1);
+        while ((nbit != Bitset::npos) && is_cached(static_cast< uint32_t >(nbit))) {
+            nbit = m_reserved_bits.get_next_set_bit(nbit + 1);
+        }
         if (nbit == Bitset::npos) return false;
         last_found_id = (uint32_t)nbit;
         return true;
     }
 
 private:
-    std::mutex m_mutex;
-    sisl::Bitset m_reserved_bits;
+    std::mutex m_grow_mutex;
+    std::atomic< uint64_t > m_next_hint{0};
+    std::array< cache_slot, s_cache_slots > m_caches;
+    sisl::ThreadSafeBitset m_reserved_bits;
 };
 } // namespace sisl
@@ -0,0 +1,324 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <sisl/utility/urcu_helper.hpp>
+#include "bitset.hpp"
+#include "bitword.hpp"
+
+//
+// A growable thread safe bitset made of fixed size segments. The segments are listed in a directory which is
+// published through RCU, so growing only allocates the new segments and publishes a new directory with them
+// appended, while the existing segments (and thus the bits) never move. Bit operations run inside a RCU read side
+// section on whichever directory they see and update the words atomically, so they neither wait for a resize nor
+// block it. shrink_head drops the segments which are fully skipped, which get freed once the readers of the older
+// directories are done.
+//
+// Compared to ThreadSafeBitset, which takes its lock exclusively and copies the entire buffer on resize, this trades
+// an extra indirection per bit operation for resizes which don't stall the bit operations.
+//
+// NOTE: Like all RCU users, every thread accessing the bitset needs to be registered with RCU
+// (sisl::urcu_ctl::register_rcu() or a sisl::ThreadBuffer).
+//
+
+namespace sisl {
+class SegmentedBitset {
+public:
+    typedef Bitword< safe_bits< uint64_t > > bitword_type;
+    typedef bitword_type::word_t word_t;
+
+    static constexpr uint64_t npos{std::numeric_limits< uint64_t >::max()};
+    static constexpr uint8_t word_size() { return bitword_type::bits(); }
+    static constexpr uint64_t default_segment_bits() { return 1024 * 1024; }
+
+private:
+    struct segment {
+        std::unique_ptr< bitword_type[] > words;
+        explicit segment(const uint64_t nwords) : words{new bitword_type[nwords]} {}
+    };
+
+    // Segments are shared between the consecutive directories, a segment is freed when the last directory referring
+    // to it is freed after the RCU grace period.
+    struct directory {
+        uint64_t skip_bits{0}; // Bits of the first segment already shrunk off
+        uint64_t nbits{0};
+        std::vector< std::shared_ptr< segment > > segments;
+    };
+
+    urcu_scoped_ptr< directory > m_dir;
+    uint64_t m_segment_bits;
+    uint64_t m_segment_words;
+
+public:
+    /**
+     * @brief Construct a new segmented bitset
+     *
+     * @param nbits Initial number of bits, all reset
+     * @param segment_bits Bits per segment, rounded up to the multiple of word size. Resize works in units of
+     * segments and shrink_head frees memory only in units of segments.
+     */
+    explicit SegmentedBitset(const uint64_t nbits = 0, const uint64_t segment_bits = default_segment_bits()) :
+            m_segment_bits{std::max(round_up(segment_bits, word_size()), static_cast< uint64_t >(word_size()))},
+            m_segment_words{m_segment_bits / word_size()} {
+        if (nbits > 0) { resize(nbits); }
+    }
+
+    SegmentedBitset(const SegmentedBitset&) = delete;
+    SegmentedBitset& operator=(const SegmentedBitset&) = delete;
+    SegmentedBitset(SegmentedBitset&&) noexcept = delete;
+    SegmentedBitset& operator=(SegmentedBitset&&) noexcept = delete;
+    ~SegmentedBitset() = default;
+
+    uint64_t size() const {
+        uint64_t nbits{0};
+        m_dir.read([&nbits](const directory* const dir) { nbits = dir->nbits; });
+        return nbits;
+    }
+
+    uint64_t segment_bits() const { return m_segment_bits; }
+
+    uint64_t segment_count() const {
+        uint64_t count{0};
+        m_dir.read([&count](const directory* const dir) { count = dir->segments.size(); });
+        return count;
+    }
+
+    void set_bit(const uint64_t bit) { set_reset_bits(bit, 1, true); }
+    void reset_bit(const uint64_t bit) { set_reset_bits(bit, 1, false); }
+    void set_bits(const uint64_t start, const uint64_t nbits) { set_reset_bits(start, nbits, true); }
+    void reset_bits(const uint64_t start, const uint64_t nbits) { set_reset_bits(start, nbits, false); }
+
+    bool get_bitval(const uint64_t bit) const {
+        bool ret{false};
+        bool in_range{false};
+        m_dir.read([this, &ret, &in_range, bit](const directory* const dir) {
+            in_range = (bit < dir->nbits);
+            if (in_range) { ret = word_of(dir, bit)->get_bitval(offset_of(dir, bit)); }
+        });
+        if (!in_range) { throw std::out_of_range("Bit not in range"); }
+        return ret;
+    }
+
+    bool is_bits_set(const uint64_t start, const uint64_t nbits) const { return is_bits_set_reset(start, nbits, true); }
+    bool is_bits_reset(const uint64_t start, const uint64_t nbits) const {
+        return is_bits_set_reset(start, nbits, false);
+    }
+
+    /**
+     * @brief Get the count of set bits in the range [start, end] inclusive (till the last bit by default)
+     */
+    uint64_t get_set_count(const uint64_t start = 0, const uint64_t end = npos) const {
+        uint64_t count{0};
+        m_dir.read([this, &count, start, end](const directory* const dir) {
+            if (start >= dir->nbits) { return; }
+            const uint64_t last{std::min(end, dir->nbits - 1)};
+            for_each_word(dir, start, last - start + 1,
+                          [&count](const bitword_type* const word, const uint8_t offset, const uint8_t nbits) {
+                              const word_t mask{consecutive_bitmask[nbits - 1] << offset};
+                              count += get_set_bit_count(static_cast< word_t >(word->to_integer() & mask));
+                              return true;
+                          });
+        });
+        return count;
+    }
+
+    /**
+     * @brief Get the next set bit from start bit (inclusive), npos if there is none
+     */
+    uint64_t get_next_set_bit(const uint64_t start_bit) const { return get_next_bit(start_bit, true); }
+
+    /**
+     * @brief Get the next reset bit from start bit (inclusive), npos if there is none
+     */
+    uint64_t get_next_reset_bit(const uint64_t start_bit) const { return get_next_bit(start_bit, false); }
+
+    /**
+     * @brief Get the first run of at least n contiguous reset bits from start bit, which can span segments
+     *
+     * @return BitBlock Start bit and n if found, otherwise start bit npos and 0 bits
+     */
+    BitBlock get_next_contiguous_n_reset_bits(const uint64_t start_bit, const uint32_t n) const {
+        BitBlock retb{npos, 0};
+        m_dir.read([this, &retb, start_bit, n](const directory* const dir) {
+            uint64_t bit{start_bit};
+            while (bit < dir->nbits) {
+                const uint64_t reset_bit{next_bit(dir, bit, false)};
+                if (reset_bit == npos) { return; }
+                const uint64_t set_bit{next_bit(dir, reset_bit, true)};
+                const uint64_t run_end{(set_bit == npos) ? dir->nbits : set_bit};
+                if ((run_end - reset_bit) >= n) {
+                    retb = BitBlock{reset_bit, n};
+                    return;
+                }
+                bit = run_end;
+            }
+        });
+        return retb;
+    }
+
+    /**
+     * @brief Resize the bitset to nbits. Growing allocates only the new segments and sets the new bits to value,
+     * shrinking drops the segments beyond nbits. Bit operations in progress are not blocked.
+     */
+    void resize(const uint64_t nbits, const bool value = false) {
+        m_dir.update([this, nbits, value](directory* const dir) {
+            const uint64_t total_bits{dir->skip_bits + nbits};
+            const uint64_t nsegments{(total_bits + m_segment_bits - 1) / m_segment_bits};
+            const uint64_t old_nbits{dir->nbits};
+            dir->segments.resize(std::min< uint64_t >(dir->segments.size(), nsegments));
+            while (dir->segments.size() < nsegments) {
+                dir->segments.push_back(std::make_shared< segment >(m_segment_words));
+            }
+            dir->nbits = nbits;
+
+            // New bits are invisible to the bit operations until the directory is published, so there is no race
+            // in filling them
+            if (nbits > old_nbits) {
+                for_each_word(dir, old_nbits, nbits - old_nbits,
+                              [value](bitword_type* const word, const uint8_t offset, const uint8_t count) {
+                                  word->set_reset_bits(offset, count, value);
+                                  return true;
+                              });
+            }
+        });
+    }
+
+    /**
+     * @brief Drop nbits from the head, so that bit nbits becomes bit 0. Segments which are entirely dropped are freed
+     * (after the RCU grace period) instead of moving the rest of the bits.
+     *
+     * @param nbits Number of bits to drop, throws std::out_of_range if it is more than size()
+     */
+    void shrink_head(const uint64_t nbits) {
+        bool in_range{false};
+        m_dir.update([this, nbits, &in_range](directory* const dir) {
+            in_range = (nbits <= dir->nbits);
+            if (!in_range) { return; }
+            dir->skip_bits += nbits;
+            dir->nbits -= nbits;
+            const uint64_t drop_segments{std::min< uint64_t >(dir->skip_bits / m_segment_bits, dir->segments.size())};
+            dir->segments.erase(dir->segments.begin(), std::next(dir->segments.begin(), drop_segments));
+            dir->skip_bits -= drop_segments * m_segment_bits;
+        });
+        if (!in_range) { throw std::out_of_range("Right shift to out of range"); }
+    }
+
+private:
+    static uint64_t round_up(const uint64_t n, const uint64_t multiple) {
+        return ((n + multiple - 1) / multiple) * multiple;
+    }
+
+    // Exceptions are thrown only after leaving the RCU read side section
+    void set_reset_bits(const uint64_t start, const uint64_t nbits, const bool value) {
+        bool in_range{false};
+        m_dir.read([this, start, nbits, value, &in_range](const directory* const dir) {
+            in_range = (start < dir->nbits) && (nbits <= (dir->nbits - start));
+            if (!in_range) { return; }
+            for_each_word(dir, start, nbits,
+                          [value](bitword_type* const word, const uint8_t offset, const uint8_t count) {
+                              word->set_reset_bits(offset, count, value);
+                              return true;
+                          });
+        });
+        if (!in_range) { throw std::out_of_range("Set/Reset bits not in range"); }
+    }
+
+    bool is_bits_set_reset(const uint64_t start, const uint64_t nbits, const bool expected) const {
+        bool ret{true};
+        m_dir.read([this, &ret, start, nbits, expected](const directory* const dir) {
+            if ((start >= dir->nbits) || (nbits > (dir->nbits - start))) {
+                ret = false;
+                return;
+            }
+            for_each_word(dir, start, nbits,
+                          [&ret, expected](const bitword_type* const word, const uint8_t offset, const uint8_t count) {
+                              ret = word->is_bits_set_reset(offset, count, expected);
+                              return ret;
+                          });
+        });
+        return ret;
+    }
+
+    uint64_t get_next_bit(const uint64_t start_bit, const bool value) const {
+        uint64_t ret{npos};
+        m_dir.read(
+            [this, &ret, start_bit, value](const directory* const dir) { ret = next_bit(dir, start_bit, value); });
+        return ret;
+    }
+
+    // NOTE: must be called within RCU read side section
+    uint64_t next_bit(const directory* const dir, const uint64_t start_bit, const bool value) const {
+        if (start_bit >= dir->nbits) { return npos; }
+        uint64_t bit{start_bit};
+        uint64_t ret{npos};
+        for_each_word(dir, start_bit, dir->nbits - start_bit,
+                      [&bit, &ret, value](const bitword_type* const word, const uint8_t offset, const uint8_t count) {
+                          word_t val{static_cast< word_t >(word->to_integer() >> offset)};
+                          if (!value) { val = ~val; }
+                          val &= consecutive_bitmask[count - 1];
+                          if (val) {
+                              ret = bit + get_trailing_zeros(val);
+                              return false;
+                          }
+                          bit += count;
+                          return true;
+                      });
+        return ret;
+    }
+
+    // NOTE: must be called within RCU read side section. Calls fn(word, offset, count) for the bits of each word in
+    // [start, start + nbits), till fn returns false.
+    template < typename DirType, typename WordFn >
+    void for_each_word(DirType* const dir, const uint64_t start, uint64_t nbits, WordFn&& fn) const {
+        uint64_t pos{dir->skip_bits + start};
+        while (nbits > 0) {
+            bitword_type* const words{dir->segments[pos / m_segment_bits]->words.get()};
+            uint64_t word_num{(pos % m_segment_bits) / word_size()};
+            uint8_t offset{static_cast< uint8_t >(pos % word_size())};
+            // Within the segment
+            while ((nbits > 0) && (word_num < m_segment_words)) {
+                const uint8_t count{static_cast< uint8_t >(std::min< uint64_t >(word_size() - offset, nbits))};
+                if (!fn(&words[word_num], offset, count)) { return; }
+                nbits -= count;
+                pos += count;
+                offset = 0;
+                ++word_num;
+            }
+        }
+    }
+
+    // NOTE: must be called within RCU read side section
+    bitword_type* word_of(const directory* const dir, const uint64_t bit) const {
+        const uint64_t pos{dir->skip_bits + bit};
+        return &dir->segments[pos / m_segment_bits]->words[(pos % m_segment_bits) / word_size()];
+    }
+
+    // NOTE: must be called within RCU read side section
+    uint8_t offset_of(const directory* const dir, const uint64_t bit) const {
+        return static_cast< uint8_t >((dir->skip_bits + bit) % word_size());
+    }
+};
+} // namespace sisl
@@ -0,0 +1,690 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "bitset.hpp"
+#include "bitword.hpp"
+#include "buffer.hpp"
+
+//
+// A compressed bitset for large bit spaces which are mostly reset or mostly set (sparse ids, tracking windows with
+// rare holes etc). The bit space is split into chunks of 64K bits and only the chunks which have any bit set are
+// kept, each in one of the three containers, similar to Roaring bitmaps:
+//   array  - Sorted list of set bit positions, for chunks with upto 4096 bits set
+//   bitmap - Plain 64K bit bitmap, for chunks with more bits set and scattered around
+//   run    - Sorted list of [start, last] runs of set bits, for chunks made of long runs
+//
+// Bit ranges of at least run_optimize_threshold() bits pick the smallest container for the chunks they touch, while
+// single bit updates only switch between array and bitmap as the cardinality crosses 4096. run_optimize() can be
+// called to compact all chunks after a sequence of single bit updates.
+//
+// It provides the same query API as BitsetImpl, with the same thread safety as sisl::Bitset, i.e. none.
+//
+
+namespace sisl {
+class SparseBitset {
+public:
+    static constexpr uint64_t npos{std::numeric_limits< uint64_t >::max()};
+    static constexpr uint32_t chunk_bits() { return 65536; }
+    static constexpr uint32_t max_array_size() { return 4096; }
+    static constexpr uint32_t run_optimize_threshold() { return 64; }
+
+private:
+    enum class container_type : uint8_t { array = 0, bitmap = 1, run = 2 };
+
+    struct bit_run {
+        uint16_t start;
+        uint16_t last;
+    };
+
+#pragma pack(1)
+    struct sparse_bitset_serialized {
+        uint64_t m_id;
+        uint64_t m_nbits;
+        uint64_t m_nchunks;
+    };
+
+    struct container_serialized {
+        // NOTE: The array/bitmap/runs of the container follows directly in memory right after this structure
+        uint64_t m_key;
+        uint8_t m_type;
+        uint32_t m_card;
+        uint32_t m_nelems;
+    };
+#pragma pack()
+
+    class container {
+    public:
+        container_type type() const { return m_type; }
+        uint32_t cardinality() const { return m_card; }
+        bool empty() const { return (m_card == 0); }
+
+        bool contains(const uint32_t pos) const {
+            switch (m_type) {
+            case container_type::array:
+                return std::binary_search(m_values.cbegin(), m_values.cend(), static_cast< uint16_t >(pos));
+            case container_type::bitmap:
+                return ((m_words[pos / 64] & bit_mask[pos % 64]) != 0);
+            default: {
+                const size_t r{run_index(pos)};
+                return (r < m_runs.size()) && (m_runs[r].start <= pos);
+            }
+            }
+        }
+
+        // Count of set bits in the range [lo, hi] inclusive
+        uint32_t count(const uint32_t lo, const uint32_t hi) const {
+            switch (m_type) {
+            case container_type::array:
+                return static_cast< uint32_t >(
+                    std::upper_bound(m_values.cbegin(), m_values.cend(), static_cast< uint16_t >(hi)) -
+                    std::lower_bound(m_values.cbegin(), m_values.cend(), static_cast< uint16_t >(lo)));
+            case container_type::bitmap: {
+                uint32_t cnt{0};
+                for_each_word(lo, hi, [this, &cnt](const uint32_t w, const uint64_t mask) {
+                    cnt += get_set_bit_count(m_words[w] & mask);
+                });
+                return cnt;
+            }
+            default: {
+                uint32_t cnt{0};
+                for (size_t r{run_index(lo)}; (r < m_runs.size()) && (m_runs[r].start <= hi); ++r) {
+                    cnt += std::min< uint32_t >(m_runs[r].last, hi) - std::max< uint32_t >(m_runs[r].start, lo) + 1;
+                }
+                return cnt;
+            }
+            }
+        }
+
+        // Next set bit at or after pos, chunk_bits() if there is none
+        uint32_t next_set(const uint32_t pos) const {
+            if (pos >= chunk_bits()) { return chunk_bits(); }
+            switch (m_type) {
+            case container_type::array: {
+                const auto it{std::lower_bound(m_values.cbegin(), m_values.cend(), static_cast< uint16_t >(pos))};
+                return (it == m_values.cend()) ? chunk_bits() : *it;
+            }
+            case container_type::bitmap: {
+                uint32_t w{pos / 64};
+                uint64_t bits{m_words[w] & (~uint64_t{0} << (pos % 64))};
+                while (bits == 0) {
+                    if (++w == bitmap_words()) { return chunk_bits(); }
+                    bits = m_words[w];
+                }
+                return w * 64 + get_trailing_zeros(bits);
+            }
+            default: {
+                const size_t r{run_index(pos)};
+                return (r < m_runs.size()) ? std::max< uint32_t >(m_runs[r].start, pos) : chunk_bits();
+            }
+            }
+        }
+
+        // Next reset bit at or after pos, chunk_bits() if there is none
+        uint32_t next_reset(const uint32_t pos) const {
+            if (pos >= chunk_bits()) { return chunk_bits(); }
+            switch (m_type) {
+            case container_type::array: {
+                auto it{std::lower_bound(m_values.cbegin(), m_values.cend(), static_cast< uint16_t >(pos))};
+                uint32_t expected{pos};
+                for (; (it != m_values.cend()) && (*it == expected); ++it, ++expected) {}
+                return expected;
+            }
+            case container_type::bitmap: {
+                uint32_t w{pos / 64};
+                uint64_t bits{~m_words[w] & (~uint64_t{0} << (pos % 64))};
+                while (bits == 0) {
+                    if (++w == bitmap_words()) { return chunk_bits(); }
+                    bits = ~m_words[w];
+                }
+                return w * 64 + get_trailing_zeros(bits);
+            }
+            default: {
+                const size_t r{run_index(pos)};
+                return ((r < m_runs.size()) && (m_runs[r].start <= pos)) ? m_runs[r].last + 1 : pos;
+            }
+            }
+        }
+
+        void set_range(const uint32_t lo, const uint32_t hi) {
+            const uint32_t nbits{hi - lo + 1};
+            if (nbits == chunk_bits()) {
+                // Entire chunk, no matter what it was, it is now a single run
+                m_values = std::vector< uint16_t >{};
+                m_words = std::vector< uint64_t >{};
+                m_runs.assign(1, bit_run{0, static_cast< uint16_t >(chunk_bits() - 1)});
+                m_type = container_type::run;
+                m_card = chunk_bits();
+                return;
+            }
+
+            switch (m_type) {
+            case container_type::array: {
+                const auto lb{std::lower_bound(m_values.begin(), m_values.end(), static_cast< uint16_t >(lo))};
+                const auto ub{std::upper_bound(lb, m_values.end(), static_cast< uint16_t >(hi))};
+                const uint32_t new_card{m_card + nbits - static_cast< uint32_t >(ub - lb)};
+                if (new_card > max_array_size()) {
+                    convert_to(container_type::bitmap);
+                    set_range(lo, hi);
+                    return;
+                }
+                const auto idx{m_values.erase(lb, ub) - m_values.begin()};
+                m_values.insert(std::next(m_values.begin(), idx), nbits, uint16_t{0});
+                std::iota(std::next(m_values.begin(), idx), std::next(m_values.begin(), idx + nbits),
+                          static_cast< uint16_t >(lo));
+                m_card = new_card;
+                break;
+            }
+            case container_type::bitmap:
+                for_each_word(lo, hi, [this](const uint32_t w, const uint64_t mask) {
+                    m_card += get_set_bit_count(~m_words[w] & mask);
+                    m_words[w] |= mask;
+                });
+                break;
+            default: {
+                m_card += nbits - count(lo, hi);
+                // Merge with all the runs overlapping or adjacent to [lo, hi]
+                const size_t first{run_index((lo == 0) ? 0 : lo - 1)};
+                size_t last{first};
+                uint32_t start{lo};
+                uint32_t end{hi};
+                for (; (last < m_runs.size()) && (m_runs[last].start <= hi + 1); ++last) {
+                    start = std::min< uint32_t >(start, m_runs[last].start);
+                    end = std::max< uint32_t >(end, m_runs[last].last);
+                }
+                m_runs.erase(std::next(m_runs.begin(), first), std::next(m_runs.begin(), last));
+                m_runs.insert(std::next(m_runs.begin(), first),
+                              bit_run{static_cast< uint16_t >(start), static_cast< uint16_t >(end)});
+                if (m_runs.size() > max_runs()) { convert_to(container_type::bitmap); }
+                break;
+            }
+            }
+        }
+
+        void reset_range(const uint32_t lo, const uint32_t hi) {
+            switch (m_type) {
+            case container_type::array: {
+                const auto lb{std::lower_bound(m_values.begin(), m_values.end(), static_cast< uint16_t >(lo))};
+                const auto ub{std::upper_bound(lb, m_values.end(), static_cast< uint16_t >(hi))};
+                m_values.erase(lb, ub);
+                m_card = static_cast< uint32_t >(m_values.size());
+                break;
+            }
+            case container_type::bitmap:
+                for_each_word(lo, hi, [this](const uint32_t w, const uint64_t mask) {
+                    m_card -= get_set_bit_count(m_words[w] & mask);
+                    m_words[w] &= ~mask;
+                });
+                if (m_card <= max_array_size()) { convert_to(container_type::array); }
+                break;
+            default: {
+                m_card -= count(lo, hi);
+                // Trim all the runs overlapping [lo, hi], keeping the parts of the first and last outside of it
+                const size_t first{run_index(lo)};
+                size_t last{first};
+                std::optional< bit_run > head;
+                std::optional< bit_run > tail;
+                for (; (last < m_runs.size()) && (m_runs[last].start <= hi); ++last) {
+                    if (m_runs[last].start < lo) { head = bit_run{m_runs[last].start, static_cast< uint16_t >(lo - 1)}; }
+                    if (m_runs[last].last > hi) { tail = bit_run{static_cast< uint16_t >(hi + 1), m_runs[last].last}; }
+                }
+                m_runs.erase(std::next(m_runs.begin(), first), std::next(m_runs.begin(), last));
+                if (tail) { m_runs.insert(std::next(m_runs.begin(), first), *tail); }
+                if (head) { m_runs.insert(std::next(m_runs.begin(), first), *head); }
+                if (m_runs.size() > max_runs()) { convert_to(container_type::bitmap); }
+                break;
+            }
+            }
+        }
+
+        // Switch to whichever container type takes the least memory for the current bits
+        void optimize() {
+            const uint64_t run_bytes{num_runs() * sizeof(bit_run)};
+            const uint64_t array_bytes{(m_card <= max_array_size()) ? m_card * sizeof(uint16_t) : npos};
+            const uint64_t bitmap_bytes{bitmap_words() * sizeof(uint64_t)};
+            if ((run_bytes <= array_bytes) && (run_bytes < bitmap_bytes)) {
+                convert_to(container_type::run);
+            } else if (array_bytes < bitmap_bytes) {
+                convert_to(container_type::array);
+            } else {
+                convert_to(container_type::bitmap);
+            }
+        }
+
+        uint64_t memory_usage() const {
+            return m_values.capacity() * sizeof(uint16_t) + m_words.capacity() * sizeof(uint64_t) +
+                m_runs.capacity() * sizeof(bit_run);
+        }
+
+        uint64_t serialized_size() const { return sizeof(container_serialized) + payload_size(); }
+
+        uint8_t* serialize(const uint64_t key, uint8_t* const buf) const {
+            container_serialized* const hdr{new (buf) container_serialized{}};
+            hdr->m_key = key;
+            hdr->m_type = static_cast< uint8_t >(m_type);
+            hdr->m_card = m_card;
+            hdr->m_nelems = static_cast< uint32_t >(
+                (m_type == container_type::array) ? m_values.size()
+                                                  : ((m_type == container_type::bitmap) ? m_words.size() : m_runs.size()));
+            std::memcpy(buf + sizeof(container_serialized), payload(), payload_size());
+            return buf + serialized_size();
+        }
+
+        const uint8_t* deserialize(const uint8_t* const buf, uint64_t& key) {
+            container_serialized hdr;
+            std::memcpy(static_cast< void* >(&hdr), buf, sizeof(container_serialized));
+            key = hdr.m_key;
+            m_type = static_cast< container_type >(hdr.m_type);
+            m_card = hdr.m_card;
+            const uint8_t* const data{buf + sizeof(container_serialized)};
+            switch (m_type) {
+            case container_type::array:
+                m_values.resize(hdr.m_nelems);
+                break;
+            case container_type::bitmap:
+                assert(hdr.m_nelems == bitmap_words());
+                m_words.resize(hdr.m_nelems);
+                break;
+            default:
+                m_runs.resize(hdr.m_nelems);
+                break;
+            }
+            std::memcpy(payload(), data, payload_size());
+            return data + payload_size();
+        }
+
+    private:
+        static constexpr uint32_t bitmap_words() { return chunk_bits() / 64; }
+        static constexpr size_t max_runs() { return bitmap_words() * sizeof(uint64_t) / sizeof(bit_run); }
+
+        template < typename FnT >
+        static void for_each_word(const uint32_t lo, const uint32_t hi, FnT&& fn) {
+            for (uint32_t w{lo / 64}; w <= hi / 64; ++w) {
+                uint64_t mask{~uint64_t{0}};
+                if (w == lo / 64) { mask &= (~uint64_t{0} << (lo % 64)); }
+                if (w == hi / 64) { mask &= (~uint64_t{0} >> (63 - (hi % 64))); }
+                fn(w, mask);
+            }
+        }
+
+        // Index of the first run which ends at or after pos
+        size_t run_index(const uint32_t pos) const {
+            return static_cast< size_t >(std::lower_bound(m_runs.cbegin(), m_runs.cend(), pos,
+                                                          [](const bit_run& r, const uint32_t p) {
+                                                              return r.last < p;
+                                                          }) -
+                                         m_runs.cbegin());
+        }
+
+        uint64_t num_runs() const {
+            switch (m_type) {
+            case container_type::array: {
+                uint64_t n{m_values.empty() ? 0u : 1u};
+                for (size_t i{1}; i < m_values.size(); ++i) {
+                    if (m_values[i] != (m_values[i - 1] + 1)) { ++n; }
+                }
+                return n;
+            }
+            case container_type::bitmap: {
+                // A run starts at every set bit whose previous bit is reset
+                uint64_t n{0};
+                uint64_t carry{0};
+                for (const uint64_t w : m_words) {
+                    n += get_set_bit_count(w & ~((w << 1) | carry));
+                    carry = w >> 63;
+                }
+                return n;
+            }
+            default:
+                return m_runs.size();
+            }
+        }
+
+        void convert_to(const container_type type) {
+            if (type == m_type) { return; }
+            std::vector< uint16_t > values;
+            std::vector< uint64_t > words;
+            std::vector< bit_run > runs;
+            switch (type) {
+            case container_type::array:
+                values.reserve(m_card);
+                for (uint32_t pos{next_set(0)}; pos < chunk_bits(); pos = next_set(pos + 1)) {
+                    values.push_back(static_cast< uint16_t >(pos));
+                }
+                break;
+            case container_type::bitmap:
+                words.resize(bitmap_words(), 0);
+                for (uint32_t pos{next_set(0)}; pos < chunk_bits();) {
+                    const uint32_t end{next_reset(pos)};
+                    for_each_word(pos, end - 1, [&words](const uint32_t w, const uint64_t mask) { words[w] |= mask; });
+                    pos = next_set(end);
+                }
+                break;
+            default:
+                for (uint32_t pos{next_set(0)}; pos < chunk_bits();) {
+                    const uint32_t end{next_reset(pos)};
+                    runs.push_back(bit_run{static_cast< uint16_t >(pos), static_cast< uint16_t >(end - 1)});
+                    pos = next_set(end);
+                }
+                break;
+            }
+            m_values = std::move(values);
+            m_words = std::move(words);
+            m_runs = std::move(runs);
+            m_type = type;
+        }
+
+        const void* payload() const {
+            return (m_type == container_type::array)
+                ? static_cast< const void* >(m_values.data())
+                : ((m_type == container_type::bitmap) ? static_cast< const void* >(m_words.data())
+                                                      : static_cast< const void* >(m_runs.data()));
+        }
+        void* payload() { return const_cast< void* >(std::as_const(*this).payload()); }
+
+        uint64_t payload_size() const {
+            return m_values.size() * sizeof(uint16_t) + m_words.size() * sizeof(uint64_t) +
+                m_runs.size() * sizeof(bit_run);
+        }
+
+    private:
+        container_type m_type{container_type::array};
+        uint32_t m_card{0};
+        std::vector< uint16_t > m_values; // array container
+        std::vector< uint64_t > m_words;  // bitmap container
+        std::vector< bit_run > m_runs;    // run container
+    };
+
+    struct chunk {
+        uint64_t key; // bits [key * chunk_bits(), (key + 1) * chunk_bits())
+        container c;
+    };
+
+public:
+    explicit SparseBitset(const uint64_t nbits = 0, const uint64_t id = 0) : m_nbits{nbits}, m_id{id} {}
+
+    explicit SparseBitset(const sisl::byte_array& b) {
+        assert(b->size() >= sizeof(sparse_bitset_serialized));
+        sparse_bitset_serialized hdr;
+        std::memcpy(static_cast< void* >(&hdr), b->cbytes(), sizeof(sparse_bitset_serialized));
+        m_id = hdr.m_id;
+        m_nbits = hdr.m_nbits;
+        m_chunks.resize(hdr.m_nchunks);
+
+        const uint8_t* ptr{b->cbytes() + sizeof(sparse_bitset_serialized)};
+        for (auto& ch : m_chunks) {
+            ptr = ch.c.deserialize(ptr, ch.key);
+        }
+        assert(ptr <= b->cbytes() + b->size());
+    }
+
+    SparseBitset(const SparseBitset&) = default;
+    SparseBitset(SparseBitset&&) noexcept = default;
+    SparseBitset& operator=(const SparseBitset&) = default;
+    SparseBitset& operator=(SparseBitset&&) noexcept = default;
+    ~SparseBitset() = default;
+
+    uint64_t get_id() const { return m_id; }
+    void set_id(const uint64_t id) { m_id = id; }
+
+    /**
+     * @brief Get total bits available in this bitset
+     */
+    uint64_t size() const { return m_nbits; }
+
+    void set_bit(const uint64_t bit) { set_reset_bits(bit, 1, true); }
+    void reset_bit(const uint64_t bit) { set_reset_bits(bit, 1, false); }
+
+    /**
+     * @brief Set/Reset multiple bits. If the bits are outside the available range throws std::out_of_range exception
+     *
+     * @param start Starting bit of the sequence to set/reset
+     * @param nbits Total number of bits from starting bit
+     */
+    void set_bits(const uint64_t start, const uint64_t nbits) { set_reset_bits(start, nbits, true); }
+    void reset_bits(const uint64_t start, const uint64_t nbits) { set_reset_bits(start, nbits, false); }
+
+    bool get_bitval(const uint64_t bit) const {
+        assert(bit < m_nbits);
+        const chunk* const ch{find_chunk(bit / chunk_bits())};
+        return ch && ch->c.contains(bit % chunk_bits());
+    }
+
+    bool is_bits_set(const uint64_t start, const uint64_t nbits) const {
+        const uint64_t n{std::min(nbits, m_nbits - start)};
+        return (n == 0) || (get_set_count(start, start + n - 1) == n);
+    }
+    bool is_bits_reset(const uint64_t start, const uint64_t nbits) const {
+        const uint64_t n{std::min(nbits, m_nbits - start)};
+        return (n == 0) || (get_set_count(start, start + n - 1) == 0);
+    }
+
+    /**
+     * @brief Get the number of bits set in the range [start_bit, end_bit] inclusive
+     */
+    uint64_t get_set_count(const uint64_t start_bit = 0,
+                           const uint64_t end_bit = std::numeric_limits< uint64_t >::max()) const {
+        assert(end_bit >= start_bit);
+        if (start_bit >= m_nbits) { return 0; }
+        const uint64_t last_bit{std::min(m_nbits - 1, end_bit)};
+        uint64_t set_cnt{0};
+        for (auto it{lower_bound_chunk(start_bit / chunk_bits())};
+             (it != m_chunks.cend()) && (it->key <= last_bit / chunk_bits()); ++it) {
+            const uint32_t lo{(it->key == start_bit / chunk_bits()) ? static_cast< uint32_t >(start_bit % chunk_bits())
+                                                                    : 0};
+            const uint32_t hi{(it->key == last_bit / chunk_bits()) ? static_cast< uint32_t >(last_bit % chunk_bits())
+                                                                   : chunk_bits() - 1};
+            set_cnt += it->c.count(lo, hi);
+        }
+        return set_cnt;
+    }
+
+    /**
+     * @brief Get the next set bit from given bit
+     *
+     * @return uint64_t Returns the next set bit, if one available, else SparseBitset::npos is returned
+     */
+    uint64_t get_next_set_bit(const uint64_t start_bit) const {
+        if (start_bit >= m_nbits) { return npos; }
+        const uint64_t start_key{start_bit / chunk_bits()};
+        for (auto it{lower_bound_chunk(start_key)}; it != m_chunks.cend(); ++it) {
+            const uint32_t pos{it->c.next_set((it->key == start_key) ? start_bit % chunk_bits() : 0)};
+            if (pos < chunk_bits()) {
+                const uint64_t ret{it->key * chunk_bits() + pos};
+                return (ret < m_nbits) ? ret : npos;
+            }
+        }
+        return npos;
+    }
+
+    /**
+     * @brief Get the next reset bit from given bit
+     *
+     * @return uint64_t Returns the next reset bit, if one available, else SparseBitset::npos is returned
+     */
+    uint64_t get_next_reset_bit(const uint64_t start_bit) const {
+        uint64_t bit{start_bit};
+        for (auto it{lower_bound_chunk(bit / chunk_bits())}; bit < m_nbits; ++it) {
+            const uint64_t key{bit / chunk_bits()};
+            if ((it == m_chunks.cend()) || (it->key != key)) { return bit; } // Missing chunk is all reset
+            const uint32_t pos{it->c.next_reset(bit % chunk_bits())};
+            if (pos < chunk_bits()) {
+                bit = key * chunk_bits() + pos;
+                break;
+            }
+            bit = (key + 1) * chunk_bits();
+        }
+        return (bit < m_nbits) ? bit : npos;
+    }
+
+    BitBlock get_next_contiguous_n_reset_bits(const uint64_t start_bit, const uint32_t n) const {
+        return get_next_contiguous_n_reset_bits(start_bit, std::nullopt, n, n);
+    }
+
+    /**
+     * @brief Get the first run of atleast min_needed contiguous reset bits in the range [start_bit, end_bit]
+     * inclusive. The run is truncated to max_needed bits.
+     *
+     * @return BitBlock Returns a BitBlock with the start bit and number of bits found. If there is no such run, the
+     * start bit is npos and number of bits 0.
+     */
+    BitBlock get_next_contiguous_n_reset_bits(const uint64_t start_bit, const std::optional< uint64_t > end_bit,
+                                              const uint32_t min_needed, const uint32_t max_needed) const {
+        const uint64_t final_bit{end_bit ? std::min(*end_bit + 1, m_nbits) : m_nbits};
+        uint64_t bit{start_bit};
+        while (bit < final_bit) {
+            const uint64_t run_start{get_next_reset_bit(bit)};
+            if (run_start >= final_bit) { break; }
+            const uint64_t run_end{std::min(get_next_set_bit(run_start), final_bit)};
+            if ((run_end - run_start) >= min_needed) {
+                return BitBlock{run_start, static_cast< uint32_t >(std::min< uint64_t >(run_end - run_start, max_needed))};
+            }
+            bit = run_end;
+        }
+        return BitBlock{npos, 0};
+    }
+
+    /**
+     * @brief resize the bitset to number of bits. If nbits is more than existing bits, the new bits are set to the
+     * value specified, otherwise the bits beyond nbits are discarded.
+     */
+    void resize(const uint64_t nbits, const bool value = false) {
+        if (nbits < m_nbits) {
+            reset_bits(nbits, m_nbits - nbits);
+            m_nbits = nbits;
+        } else {
+            const uint64_t old_nbits{m_nbits};
+            m_nbits = nbits;
+            if (value && (nbits > old_nbits)) { set_bits(old_nbits, nbits - old_nbits); }
+        }
+    }
+
+    /**
+     * @brief Convert every chunk to its smallest container type. Useful after lots of single bit updates, which do not
+     * consider run containers on their own.
+     */
+    void run_optimize() {
+        for (auto& ch : m_chunks) {
+            ch.c.optimize();
+        }
+    }
+
+    /**
+     * @brief Approximate number of bytes of memory used by this bitset
+     */
+    uint64_t memory_usage() const {
+        uint64_t bytes{sizeof(SparseBitset) + m_chunks.capacity() * sizeof(chunk)};
+        for (const auto& ch : m_chunks) {
+            bytes += ch.c.memory_usage();
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Serialize the bitset into a buffer, which can be loaded later using the byte_array constructor
+     */
+    sisl::byte_array serialize(const uint32_t alignment_size = 0) const {
+        const uint64_t size{serialized_size()};
+        auto buf{sisl::make_byte_array(static_cast< uint32_t >(
+                                           (alignment_size > 0) ? round_up(size, alignment_size) : size),
+                                       alignment_size, buftag::bitset)};
+        sparse_bitset_serialized* const hdr{new (buf->bytes()) sparse_bitset_serialized{}};
+        hdr->m_id = m_id;
+        hdr->m_nbits = m_nbits;
+        hdr->m_nchunks = m_chunks.size();
+
+        uint8_t* ptr{buf->bytes() + sizeof(sparse_bitset_serialized)};
+        for (const auto& ch : m_chunks) {
+            ptr = ch.c.serialize(ch.key, ptr);
+        }
+        return buf;
+    }
+
+    uint64_t serialized_size() const {
+        uint64_t size{sizeof(sparse_bitset_serialized)};
+        for (const auto& ch : m_chunks) {
+            size += ch.c.serialized_size();
+        }
+        return size;
+    }
+
+private:
+    std::vector< chunk >::const_iterator lower_bound_chunk(const uint64_t key) const {
+        return std::lower_bound(m_chunks.cbegin(), m_chunks.cend(), key,
+                                [](const chunk& ch, const uint64_t k) { return ch.key < k; });
+    }
+
+    const chunk* find_chunk(const uint64_t key) const {
+        const auto it{lower_bound_chunk(key)};
+        return ((it != m_chunks.cend()) && (it->key == key)) ? &(*it) : nullptr;
+    }
+
+    void set_reset_bits(const uint64_t start, const uint64_t nbits, const bool value) {
+        if ((start >= m_nbits) || (nbits > m_nbits - start)) { throw std::out_of_range("Set/Reset bits not in range"); }
+        if (nbits == 0) { return; }
+
+        const uint64_t last_bit{start + nbits - 1};
+        auto it{std::next(m_chunks.begin(), lower_bound_chunk(start / chunk_bits()) - m_chunks.cbegin())};
+        uint64_t bit{start};
+        while (bit <= last_bit) {
+            const uint64_t key{bit / chunk_bits()};
+            if ((it == m_chunks.end()) || (it->key != key)) {
+                if (value) {
+                    it = m_chunks.insert(it, chunk{key, container{}});
+                } else {
+                    // Nothing to reset till the next chunk
+                    if ((it == m_chunks.end()) || (it->key > last_bit / chunk_bits())) { break; }
+                    bit = it->key * chunk_bits();
+                    continue;
+                }
+            }
+
+            const uint32_t lo{static_cast< uint32_t >(bit % chunk_bits())};
+            const uint32_t hi{static_cast< uint32_t >(std::min< uint64_t >(last_bit - key * chunk_bits(), chunk_bits() - 1))};
+            if (value) {
+                it->c.set_range(lo, hi);
+            } else {
+                it->c.reset_range(lo, hi);
+            }
+
+            if (it->c.empty()) {
+                it = m_chunks.erase(it);
+            } else {
+                if ((hi - lo + 1) >= run_optimize_threshold()) { it->c.optimize(); }
+                ++it;
+            }
+            bit = (key + 1) * chunk_bits();
+        }
+    }
+
+private:
+    uint64_t m_nbits{0};
+    uint64_t m_id{0};
+    std::vector< chunk > m_chunks; // Sorted by key, only the chunks with atleast one bit set
+};
+} // namespace sisl
@@ -0,0 +1,163 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ *distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *License for the specific language governing permissions and limitations under
+ *the License.
+ *
+ *********************************************************************************/
+#include <sisl/cache/clock_evictor.hpp>
+
+namespace sisl {
+
+ClockEvictor::ClockEvictor(const int64_t max_size, const uint32_t num_partitions)
+    : Evictor(max_size, num_partitions) {
+  m_partitions = std::make_unique<ClockPartition[]>(num_partitions);
+  for (uint32_t i{0}; i < num_partitions; ++i) {
+    m_partitions[i].init(this, i, uint64_cast(max_size / num_partitions));
+  }
+}
+
+bool ClockEvictor::add_record(uint64_t hash_code, CacheRecord &record) {
+  return get_partition(hash_code).add_record(record);
+}
+
+void ClockEvictor::remove_record(uint64_t hash_code, CacheRecord &record) {
+  get_partition(hash_code).remove_record(record);
+}
+
+void ClockEvictor::record_accessed(uint64_t, CacheRecord &record) {
+  record.record_access();
+}
+
+void ClockEvictor::record_resized(uint64_t hash_code, const CacheRecord &record,
+                                  uint32_t old_size) {
+  get_partition(hash_code).record_resized(record, old_size);
+}
+
+bool ClockEvictor::record_replaced(uint64_t hash_code, CacheRecord &record,
+                                   CacheRecord &new_record) {
+  get_partition(hash_code).record_replaced(record, new_record);
+  return true;
+}
+
+bool ClockEvictor::ClockPartition::add_record(CacheRecord &record) {
+  std::unique_lock guard{m_list_guard};
+  if (will_fill(record.size())) {
+    if (!do_evict(record.record_family_id(), record.size())) {
+      return false;
+    }
+  }
+  // New record is placed right behind the hand, so it is the last one the hand reaches
+  record.reset_access_count();
+  m_list.push_back(record);
+  m_filled_size += record.size();
+  ++m_count;
+  if (m_evictor->metrics_ptr()) {
+    COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_object_count, 1);
+    COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_size, record.size());
+  }
+  return true;
+}
+
+void ClockEvictor::ClockPartition::remove_record(CacheRecord &record) {
+  std::unique_lock guard{m_list_guard};
+
+  // accessing the iterator to the record crashes if the record is not present in the list.
+  if (!record.m_member_hook.is_linked()) {
+    LOGERROR("Not expected! Record not found in partition {}", m_partition_num);
+    DEBUG_ASSERT(false, "Not expected! Record not found");
+    return;
+  }
+  m_filled_size -= record.size();
+  --m_count;
+  m_list.erase(m_list.iterator_to(record));
+  if (m_evictor->metrics_ptr()) {
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_object_count, 1);
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_size, record.size());
+  }
+}
+
+void ClockEvictor::ClockPartition::record_resized(const CacheRecord &record,
+                                                  const uint32_t old_size) {
+  std::unique_lock guard{m_list_guard};
+  m_filled_size += (int64_cast(record.size()) - int64_cast(old_size));
+}
+
+void ClockEvictor::ClockPartition::record_replaced(CacheRecord &record,
+                                                   CacheRecord &new_record) {
+  std::unique_lock guard{m_list_guard};
+  new_record = std::move(record);
+}
+
+bool ClockEvictor::ClockPartition::do_evict(const uint32_t record_fid,
+                                            const uint32_t needed_size) {
+  size_t eviction_punt_count{0};
+  size_t evictions_count{0};
+  size_t evicted_size{0};
+
+  // Every record is visited at most twice, once to clear its reference bit and once more to evict it. Records which
+  // are pinned or refused eviction are also moved behind the hand, so that the next sweep starts with fresh ones.
+  uint64_t budget{2 * m_count};
+  while (will_fill(needed_size) && !m_list.empty() && (budget-- > 0)) {
+    CacheRecord &rec = m_list.front();
+    if (rec.reset_access_count() > 0) {
+      m_list.pop_front();
+      m_list.push_back(rec);
+      continue;
+    }
+
+    bool eviction_failed{true};
+    if (!rec.is_pinned() && (!m_evictor->can_evict_cb(record_fid) || m_evictor->can_evict_cb(record_fid)(rec))) {
+      auto const rec_size = rec.size();
+      m_list.pop_front();
+      if (m_evictor->post_eviction_cb(record_fid) && !m_evictor->post_eviction_cb(record_fid)(rec)) {
+        // If the post eviction callback fails, we need to reinsert the record back into the list.
+        m_list.push_back(rec);
+      } else {
+        eviction_failed = false;
+        m_filled_size -= rec_size;
+        --m_count;
+        evictions_count++;
+        evicted_size += rec_size;
+      }
+    } else {
+      m_list.pop_front();
+      m_list.push_back(rec);
+    }
+
+    if (eviction_failed) { ++eviction_punt_count; }
+  }
+
+  if (eviction_punt_count > 0) {
+    LOGDEBUG("CLOCK ejection had to skip {} entries", eviction_punt_count);
+    if (m_evictor->metrics_ptr()) {
+      COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_num_evictions_punt, eviction_punt_count);
+    }
+  }
+  if (is_full()) {
+    // No available candidate to evict
+    LOGERROR("No cache space available: Eviction partition={} as "
+             "total_entries={} rejected eviction request to add "
+             "size={}, already filled={}, num evictions punt={}",
+             m_partition_num, m_count, needed_size, m_filled_size, eviction_punt_count);
+    return false;
+  }
+
+  if (m_evictor->metrics_ptr()) {
+    COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_num_evictions, evictions_count);
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_object_count, evictions_count);
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_size, evicted_size);
+  }
+  return true;
+}
+} // namespace sisl
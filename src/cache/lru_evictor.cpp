@@ -15,15 +15,26 @@
  *the License.
  *
  *********************************************************************************/
+#include <thread>
 #include <sisl/cache/lru_evictor.hpp>
 
 namespace sisl {
 
-LRUEvictor::LRUEvictor(const int64_t max_size, const uint32_t num_partitions)
+// Read buffer stripe of the calling thread, so that the threads hitting the same partition mostly use different ones
+static uint32_t read_buffer_stripe() {
+  static thread_local const uint32_t t_stripe{static_cast<uint32_t>(
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+      LRUEvictor::s_read_buffer_stripes)};
+  return t_stripe;
+}
+
+LRUEvictor::LRUEvictor(const int64_t max_size, const uint32_t num_partitions,
+                       const bool buffered_access)
     : Evictor(max_size, num_partitions) {
   m_partitions = std::make_unique<LRUPartition[]>(num_partitions);
   for (uint32_t i{0}; i < num_partitions; ++i) {
-    m_partitions[i].init(this, i, uint64_cast(max_size / num_partitions));
+    m_partitions[i].init(this, i, uint64_cast(max_size / num_partitions),
+                         buffered_access);
   }
 }
 
@@ -44,8 +55,27 @@ void LRUEvictor::record_resized(uint64_t hash_code, const CacheRecord &record,
   get_partition(hash_code).record_resized(record, old_size);
 }
 
+bool LRUEvictor::record_replaced(uint64_t hash_code, CacheRecord &record,
+                                 CacheRecord &new_record) {
+  get_partition(hash_code).record_replaced(record, new_record);
+  return true;
+}
+
+void LRUEvictor::record_family_unregistered(const uint32_t) {
+  // Records of the family are about to be freed, buffered accesses of other families are lost too, which is harmless
+  for (uint32_t i{0}; i < num_partitions(); ++i) {
+    m_partitions[i].discard_read_buffers();
+  }
+}
+
+void LRUEvictor::record_add_failed(uint64_t hash_code,
+                                   const CacheRecord &record) {
+  get_partition(hash_code).discard_read_buffers(record);
+}
+
 bool LRUEvictor::LRUPartition::add_record(CacheRecord &record) {
   std::unique_lock guard{m_list_guard};
+  drain_read_buffers();
   if (will_fill(record.size())) {
     if (!do_evict(record.record_family_id(), record.size())) {
       return false;
@@ -62,6 +92,7 @@ bool LRUEvictor::LRUPartition::add_record(CacheRecord &record) {
 
 void LRUEvictor::LRUPartition::remove_record(CacheRecord &record) {
   std::unique_lock guard{m_list_guard};
+  unbuffer(record);
 
   // accessing the iterator to the record crashes if the record is not present in the list.
   if (!record.m_member_hook.is_linked()) {
@@ -79,6 +110,10 @@ void LRUEvictor::LRUPartition::remove_record(CacheRecord &record) {
 }
 
 void LRUEvictor::LRUPartition::record_accessed(CacheRecord &record) {
+  if (m_read_buffers) {
+    buffer_access(record);
+    return;
+  }
   std::unique_lock guard{m_list_guard};
 
   // accessing the iterator to the record crashes if the record is not present in the list.
@@ -87,14 +122,104 @@ void LRUEvictor::LRUPartition::record_accessed(CacheRecord &record) {
     DEBUG_ASSERT(false, "Not expected! Record not found");
     return;
   }
+  promote(record);
+}
+
+void LRUEvictor::LRUPartition::promote(CacheRecord &record) {
   m_list.erase(m_list.iterator_to(record));
   m_list.push_back(record);
 }
 
+// A record is put in at most one slot, whose number it keeps in its evictor data, with its access count marking it as
+// buffered. Further hits until it is drained are dropped, since promoting it once covers them.
+void LRUEvictor::LRUPartition::buffer_access(CacheRecord &record) {
+  if (record.m_access_count.exchange(1, std::memory_order_acquire) != 0) { return; }
+  const uint32_t stripe{read_buffer_stripe()};
+  ReadBuffer &buf = m_read_buffers[stripe];
+  const uint32_t idx{buf.m_write_idx.fetch_add(1, std::memory_order_relaxed) % s_read_buffer_size};
+  record.set_evictor_data(stripe * s_read_buffer_size + idx);
+  CacheRecord *expected{nullptr};
+  if (buf.m_slots[idx].compare_exchange_strong(expected, &record, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+    return;
+  }
+  record.m_access_count.store(0, std::memory_order_release);
+
+  // Slot is not drained yet, so the buffer is about full. Drain it now unless someone else holds the lock, in which
+  // case this access is dropped.
+  std::unique_lock guard{m_list_guard, std::try_to_lock};
+  if (!guard.owns_lock()) { return; }
+  drain_read_buffers();
+  if (record.m_member_hook.is_linked()) { promote(record); }
+}
+
+// NOTE: must be called under lock
+void LRUEvictor::LRUPartition::drain_read_buffers() {
+  if (!m_read_buffers) { return; }
+  for (uint32_t b{0}; b < s_read_buffer_stripes; ++b) {
+    for (auto &slot : m_read_buffers[b].m_slots) {
+      if (slot.load(std::memory_order_relaxed) == nullptr) { continue; }
+      CacheRecord *const rec{slot.exchange(nullptr, std::memory_order_acquire)};
+      if (rec == nullptr) { continue; }
+      rec->m_access_count.store(0, std::memory_order_release);
+      // Not linked if adding it to the evictor has failed and it is yet to be erased
+      if (rec->m_member_hook.is_linked()) { promote(*rec); }
+    }
+  }
+}
+
+// NOTE: must be called under lock. Takes out the evicted record, which may have been buffered after the last drain
+// by the hits which were holding the hash bucket lock the eviction waited for. Only the address is compared, as the
+// record is freed already.
+void LRUEvictor::LRUPartition::scrub_read_buffers(const CacheRecord *record) {
+  if (!m_read_buffers) { return; }
+  for (uint32_t b{0}; b < s_read_buffer_stripes; ++b) {
+    for (auto &slot : m_read_buffers[b].m_slots) {
+      CacheRecord *expected{const_cast<CacheRecord *>(record)};
+      slot.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+// NOTE: must be called under lock, with the hash bucket of the record locked exclusively, so that all the hits on it
+// have buffered it by now. Takes the record out of the slot it is buffered in, if any, before it is freed or moved.
+void LRUEvictor::LRUPartition::unbuffer(const CacheRecord &record) {
+  if (!m_read_buffers || (record.m_access_count.load(std::memory_order_relaxed) == 0)) { return; }
+  const uint32_t slot_num{record.evictor_data()};
+  CacheRecord *expected{const_cast<CacheRecord *>(&record)};
+  m_read_buffers[slot_num / s_read_buffer_size].m_slots[slot_num % s_read_buffer_size].compare_exchange_strong(
+      expected, nullptr, std::memory_order_relaxed);
+  record.m_access_count.store(0, std::memory_order_relaxed);
+}
+
+void LRUEvictor::LRUPartition::discard_read_buffers() {
+  if (!m_read_buffers) { return; }
+  std::unique_lock guard{m_list_guard};
+  for (uint32_t b{0}; b < s_read_buffer_stripes; ++b) {
+    for (auto &slot : m_read_buffers[b].m_slots) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+// Takes out a record which failed to be added
+void LRUEvictor::LRUPartition::discard_read_buffers(const CacheRecord &record) {
+  if (!m_read_buffers) { return; }
+  std::unique_lock guard{m_list_guard};
+  unbuffer(record);
+}
+
 void LRUEvictor::LRUPartition::record_resized(const CacheRecord &record,
                                               const uint32_t old_size) {
   std::unique_lock guard{m_list_guard};
-  m_filled_size -= (record.size() - old_size);
+  m_filled_size += (int64_cast(record.size()) - int64_cast(old_size));
+}
+
+void LRUEvictor::LRUPartition::record_replaced(CacheRecord &record,
+                                               CacheRecord &new_record) {
+  std::unique_lock guard{m_list_guard};
+  unbuffer(record);
+  new_record = std::move(record);
 }
 
 bool LRUEvictor::LRUPartition::do_evict(const uint32_t record_fid,
@@ -117,6 +242,7 @@ bool LRUEvictor::LRUPartition::do_evict(const uint32_t record_fid,
           it = m_list.insert(it, rec);
       } else {
         eviction_failed = false;
+        scrub_read_buffers(&rec);
         m_filled_size -= rec_size;
         evictions_count++;
         evicted_size += rec_size;
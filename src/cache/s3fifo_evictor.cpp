@@ -0,0 +1,240 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ *distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *License for the specific language governing permissions and limitations under
+ *the License.
+ *
+ *********************************************************************************/
+#include <algorithm>
+#include <sisl/cache/s3fifo_evictor.hpp>
+
+namespace sisl {
+
+S3FIFOEvictor::S3FIFOEvictor(const int64_t max_size, const uint32_t num_partitions)
+    : Evictor(max_size, num_partitions) {
+  m_partitions = std::make_unique<S3FIFOPartition[]>(num_partitions);
+  for (uint32_t i{0}; i < num_partitions; ++i) {
+    m_partitions[i].init(this, i, uint64_cast(max_size / num_partitions));
+  }
+}
+
+bool S3FIFOEvictor::add_record(uint64_t hash_code, CacheRecord &record) {
+  return get_partition(hash_code).add_record(record, ghost_tag(hash_code));
+}
+
+void S3FIFOEvictor::remove_record(uint64_t hash_code, CacheRecord &record) {
+  get_partition(hash_code).remove_record(record);
+}
+
+void S3FIFOEvictor::record_accessed(uint64_t, CacheRecord &record) {
+  record.record_access();
+}
+
+void S3FIFOEvictor::record_resized(uint64_t hash_code, const CacheRecord &record,
+                                   uint32_t old_size) {
+  get_partition(hash_code).record_resized(record, old_size);
+}
+
+bool S3FIFOEvictor::record_replaced(uint64_t hash_code, CacheRecord &record,
+                                    CacheRecord &new_record) {
+  get_partition(hash_code).record_replaced(record, new_record);
+  return true;
+}
+
+bool S3FIFOEvictor::S3FIFOPartition::add_record(CacheRecord &record,
+                                                const uint32_t tag) {
+  std::unique_lock guard{m_list_guard};
+  if (will_fill(record.size())) {
+    if (!do_evict(record.record_family_id(), record.size())) {
+      return false;
+    }
+  }
+  record.reset_access_count();
+  if (remove_ghost(tag)) {
+    // Evicted from the small queue recently, so it is not a one time access
+    record.set_evictor_data(tag | main_queue_bit());
+    m_main.push_back(record);
+  } else {
+    record.set_evictor_data(tag);
+    m_small.push_back(record);
+    m_small_size += record.size();
+  }
+  m_filled_size += record.size();
+  ++m_count;
+  if (m_evictor->metrics_ptr()) {
+    COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_object_count, 1);
+    COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_size, record.size());
+  }
+  return true;
+}
+
+void S3FIFOEvictor::S3FIFOPartition::remove_record(CacheRecord &record) {
+  std::unique_lock guard{m_list_guard};
+
+  // accessing the iterator to the record crashes if the record is not present in the list.
+  if (!record.m_member_hook.is_linked()) {
+    LOGERROR("Not expected! Record not found in partition {}", m_partition_num);
+    DEBUG_ASSERT(false, "Not expected! Record not found");
+    return;
+  }
+  if (in_main(record)) {
+    m_main.erase(m_main.iterator_to(record));
+  } else {
+    m_small_size -= record.size();
+    m_small.erase(m_small.iterator_to(record));
+  }
+  m_filled_size -= record.size();
+  --m_count;
+  if (m_evictor->metrics_ptr()) {
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_object_count, 1);
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_size, record.size());
+  }
+}
+
+void S3FIFOEvictor::S3FIFOPartition::record_resized(const CacheRecord &record,
+                                                    const uint32_t old_size) {
+  std::unique_lock guard{m_list_guard};
+  const int64_t delta{int64_cast(record.size()) - int64_cast(old_size)};
+  m_filled_size += delta;
+  if (record.m_member_hook.is_linked() && !in_main(record)) { m_small_size += delta; }
+}
+
+// The new record stays in the same queue, as the evictor data tells which one it is in
+void S3FIFOEvictor::S3FIFOPartition::record_replaced(CacheRecord &record,
+                                                     CacheRecord &new_record) {
+  std::unique_lock guard{m_list_guard};
+  new_record = std::move(record);
+}
+
+bool S3FIFOEvictor::S3FIFOPartition::do_evict(const uint32_t record_fid,
+                                              const uint32_t needed_size) {
+  size_t eviction_punt_count{0};
+  size_t evictions_count{0};
+  size_t evicted_size{0};
+
+  // Every record can move from the small to the main queue once and then survive upto max_access_count() sweeps of
+  // the main queue, which bounds the number of records to look at before giving up.
+  const int64_t small_target{m_max_size * small_queue_pct() / 100};
+  uint64_t budget{(CacheRecord::max_access_count() + 2) * m_count};
+  while (will_fill(needed_size) && (!m_small.empty() || !m_main.empty()) && (budget-- > 0)) {
+    if (!m_small.empty() && ((m_small_size >= small_target) || m_main.empty())) {
+      evict_small(record_fid, evictions_count, evicted_size, eviction_punt_count);
+    } else {
+      evict_main(record_fid, evictions_count, evicted_size, eviction_punt_count);
+    }
+  }
+
+  if (eviction_punt_count > 0) {
+    LOGDEBUG("S3FIFO ejection had to skip {} entries", eviction_punt_count);
+    if (m_evictor->metrics_ptr()) {
+      COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_num_evictions_punt, eviction_punt_count);
+    }
+  }
+  if (is_full()) {
+    // No available candidate to evict
+    LOGERROR("No cache space available: Eviction partition={} as "
+             "total_entries={} rejected eviction request to add "
+             "size={}, already filled={}, num evictions punt={}",
+             m_partition_num, m_count, needed_size, m_filled_size, eviction_punt_count);
+    return false;
+  }
+
+  if (m_evictor->metrics_ptr()) {
+    COUNTER_INCREMENT(*(m_evictor->metrics_ptr()), cache_num_evictions, evictions_count);
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_object_count, evictions_count);
+    COUNTER_DECREMENT(*(m_evictor->metrics_ptr()), cache_size, evicted_size);
+  }
+  return true;
+}
+
+void S3FIFOEvictor::S3FIFOPartition::evict_small(const uint32_t record_fid, size_t &evictions_count,
+                                                 size_t &evicted_size, size_t &eviction_punt_count) {
+  CacheRecord &rec = m_small.front();
+  auto const rec_size = rec.size();
+  auto const tag = rec.evictor_data();
+  m_small.pop_front();
+  m_small_size -= rec_size;
+
+  // Accessed again while in the small queue, or could not be evicted, either way it gets a place in the main queue
+  auto const move_to_main = [this, &rec, tag]() {
+    rec.set_evictor_data(tag | main_queue_bit());
+    m_main.push_back(rec);
+  };
+  if (rec.reset_access_count() > 0) {
+    move_to_main();
+  } else if (try_evict(record_fid, rec)) {
+    add_ghost(tag);
+    evictions_count++;
+    evicted_size += rec_size;
+  } else {
+    move_to_main();
+    ++eviction_punt_count;
+  }
+}
+
+void S3FIFOEvictor::S3FIFOPartition::evict_main(const uint32_t record_fid, size_t &evictions_count,
+                                                size_t &evicted_size, size_t &eviction_punt_count) {
+  CacheRecord &rec = m_main.front();
+  auto const rec_size = rec.size();
+  m_main.pop_front();
+
+  if (rec.access_count() > 0) {
+    rec.decrement_access_count();
+    m_main.push_back(rec);
+  } else if (try_evict(record_fid, rec)) {
+    evictions_count++;
+    evicted_size += rec_size;
+  } else {
+    m_main.push_back(rec);
+    ++eviction_punt_count;
+  }
+}
+
+// Record is already unlinked from its queue. Returns true if it is evicted, in which case the record is freed already.
+bool S3FIFOEvictor::S3FIFOPartition::try_evict(const uint32_t record_fid, CacheRecord &rec) {
+  if (rec.is_pinned() || (m_evictor->can_evict_cb(record_fid) && !m_evictor->can_evict_cb(record_fid)(rec))) {
+    return false;
+  }
+  auto const rec_size = rec.size();
+  if (m_evictor->post_eviction_cb(record_fid) && !m_evictor->post_eviction_cb(record_fid)(rec)) {
+    return false;
+  }
+  m_filled_size -= rec_size;
+  --m_count;
+  return true;
+}
+
+void S3FIFOEvictor::S3FIFOPartition::add_ghost(const uint32_t tag) {
+  m_ghost.push_back(tag);
+  ++m_ghost_tags[tag];
+
+  // Ghost queue remembers about as many records as the partition holds
+  while (m_ghost.size() > std::max<uint64_t>(m_count, 1)) {
+    remove_ghost(m_ghost.front());
+    m_ghost.pop_front();
+  }
+}
+
+// A hit removes the tag only from m_ghost_tags and leaves it in m_ghost, so aging it out later may find it gone or drop
+// a newer copy of the same tag early, which only makes the ghost queue a little shorter
+bool S3FIFOEvictor::S3FIFOPartition::remove_ghost(const uint32_t tag) {
+  auto const it = m_ghost_tags.find(tag);
+  if (it == m_ghost_tags.end()) {
+    return false;
+  }
+  if (--(it->second) == 0) {
+    m_ghost_tags.erase(it);
+  }
+  return true;
+}
+} // namespace sisl
@@ -0,0 +1,121 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <cstdint>
+#include <memory>
+#include <random>
+
+#include <benchmark/benchmark.h>
+#include <sisl/logging/logging.h>
+
+#include "sisl/cache/simple_hashmap.hpp"
+#include "sisl/utility/urcu_helper.hpp"
+
+SISL_LOGGING_INIT(hashmap_benchmark)
+
+namespace {
+constexpr uint64_t PREFILL_KEYS{1024 * 1024};
+constexpr uint32_t SMALL_BUCKETS{16};
+
+using map_t = sisl::SimpleHashMap< uint64_t, uint64_t >;
+using rcu_map_t = sisl::RCUSimpleHashMap< uint64_t, uint64_t >;
+std::unique_ptr< map_t > g_map;
+
+template < typename MapT = map_t >
+std::unique_ptr< MapT > make_map(const uint32_t nbuckets) {
+    return std::make_unique< MapT >(nbuckets, [](const uint64_t& v) { return v; });
+}
+
+void report_chains(benchmark::State& state) {
+    state.counters["buckets"] = double(g_map->num_buckets());
+    state.counters["max_chain"] = double(g_map->max_chain_length());
+}
+
+// Every thread keeps inserting its own keys into a map which starts with arg buckets. With SMALL_BUCKETS the map has
+// to grow all along, the max_chain counter shows that the chains stay as short as with a map sized upfront.
+void test_insert_growth(benchmark::State& state) {
+    if (state.thread_index() == 0) { g_map = make_map(uint32_t(state.range(0))); }
+
+    uint64_t key{uint64_t(state.thread_index())};
+    for ([[maybe_unused]] auto si : state) { // Loops up to iteration count
+        benchmark::DoNotOptimize(g_map->insert(key, key));
+        key += uint64_t(state.threads());
+    }
+
+    if (state.thread_index() == 0) {
+        report_chains(state);
+        g_map.reset();
+    }
+}
+
+// Lookups on a map which either grew from SMALL_BUCKETS to PREFILL_KEYS entries or was sized for them upfront
+void test_get_after_growth(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_map = make_map(uint32_t(state.range(0)));
+        for (uint64_t k{0}; k < PREFILL_KEYS; ++k) {
+            g_map->insert(k, k);
+        }
+    }
+
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > key_rand{0, PREFILL_KEYS - 1};
+    uint64_t val;
+    for ([[maybe_unused]] auto si : state) { // Loops up to iteration count
+        benchmark::DoNotOptimize(g_map->get(key_rand(re), val));
+    }
+
+    if (state.thread_index() == 0) {
+        report_chains(state);
+        g_map.reset();
+    }
+}
+
+// Lookups on a map sized upfront, which takes the bucket lock shared on get (map_t) or reads under RCU (rcu_map_t)
+template < typename MapT >
+void test_get_read_mode(benchmark::State& state) {
+    static std::unique_ptr< MapT > s_map;
+    sisl::urcu_ctl::register_rcu();
+    if (state.thread_index() == 0) {
+        s_map = make_map< MapT >(uint32_t(PREFILL_KEYS));
+        for (uint64_t k{0}; k < PREFILL_KEYS; ++k) {
+            s_map->insert(k, k);
+        }
+    }
+
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > key_rand{0, PREFILL_KEYS - 1};
+    uint64_t val;
+    for ([[maybe_unused]] auto si : state) { // Loops up to iteration count
+        benchmark::DoNotOptimize(s_map->get(key_rand(re), val));
+    }
+
+    if (state.thread_index() == 0) { s_map.reset(); }
+    sisl::urcu_ctl::unregister_rcu();
+}
+} // namespace
+
+BENCHMARK(test_insert_growth)->Arg(SMALL_BUCKETS)->Arg(PREFILL_KEYS)->Iterations(PREFILL_KEYS)->ThreadRange(1, 8);
+BENCHMARK(test_get_after_growth)->Arg(SMALL_BUCKETS)->Arg(PREFILL_KEYS)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(test_get_read_mode, map_t)->Threads(8)->Threads(32)->Threads(64)->UseRealTime();
+BENCHMARK_TEMPLATE(test_get_read_mode, rcu_map_t)->Threads(8)->Threads(32)->Threads(64)->UseRealTime();
+
+int main(int argc, char** argv) {
+    int parsed_argc{argc};
+    ::benchmark::Initialize(&parsed_argc, argv);
+    ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -31,6 +31,8 @@
 #include <sisl/utility/enum.hpp>
 #include <sisl/cache/range_cache.hpp>
 #include <sisl/cache/lru_evictor.hpp>
+#include <sisl/cache/clock_evictor.hpp>
+#include <sisl/cache/s3fifo_evictor.hpp>
 
 using namespace sisl;
 SISL_LOGGING_INIT(test_rangecache)
@@ -232,6 +234,88 @@ TEST_F(RangeCacheTest, RandomData) {
             m_cache_hit_nblks / m_cache_pieces);
 }
 
+// Each cache registers its own record family with the evictor, which it has to give back when it is destroyed, without
+// touching the family of another cache sharing the evictor
+TEST(RangeCacheRecordFamily, ReregisterAfterDestroy) {
+    std::shared_ptr< Evictor > evictor = std::make_unique< LRUEvictor >(g_blk_size * 64, 1);
+    RangeCache< uint32_t > long_lived_cache{evictor, 16, g_blk_size};
+    for (uint32_t i{0}; i < 2 * CacheRecord::max_record_families(); ++i) {
+        RangeCache< uint32_t > cache{evictor, 16, g_blk_size};
+        sisl::io_blob b{g_blk_size, 0};
+        ASSERT_EQ(cache.insert(0, i, 1, std::move(b)), 0u);
+        b.buf_free();
+        ASSERT_EQ(cache.get(0, i, 1).size(), 1u);
+    }
+}
+
+// Overlapping inserts and removes split and shrink the cached ranges, which creates, moves and resizes the records
+// within their node. The cache is large enough that nothing is evicted, so the evictor has to account for exactly
+// the blocks cached, until they are all removed.
+template < typename EvictorT >
+static void split_and_resize_test() {
+    static constexpr uint32_t num_blks{4096};
+    static constexpr uint32_t max_nblks{64};
+    auto evictor = std::make_shared< EvictorT >(int64_cast(g_blk_size) * num_blks * 4, 4);
+    RangeCache< uint32_t > cache{evictor, 256, g_blk_size};
+
+    // Version of the data cached for each block, 0 if it is not cached
+    std::vector< uint32_t > shadow(num_blks, 0);
+    uint64_t cached_nblks{0};
+    const auto fill_blk{[](uint8_t* const bytes, const uint32_t blk, const uint32_t version) {
+        auto* const words{r_cast< uint32_t* >(bytes)};
+        words[0] = blk;
+        words[1] = version;
+    }};
+
+    std::default_random_engine re{1234};
+    std::uniform_int_distribution< uint32_t > op_rand{0, 9};
+    std::uniform_int_distribution< uint32_t > blk_rand{0, num_blks - max_nblks};
+    std::uniform_int_distribution< uint32_t > nblks_rand{1, max_nblks};
+    for (uint32_t version{1}; version <= 20000; ++version) {
+        const uint32_t start{blk_rand(re)};
+        const uint32_t nblks{nblks_rand(re)};
+        const uint32_t op{op_rand(re)};
+        if (op < 5) {
+            sisl::io_blob b{nblks * g_blk_size, 0};
+            for (uint32_t blk{start}; blk < start + nblks; ++blk) {
+                fill_blk(b.bytes() + (blk - start) * g_blk_size, blk, version);
+                if (shadow[blk] == 0) { ++cached_nblks; }
+                shadow[blk] = version;
+            }
+            ASSERT_EQ(cache.insert(0, start, nblks, std::move(b)), 0u) << "Insert failed to add to the evictor";
+            b.buf_free(); // Cache keeps its own copy of the data
+        } else if (op < 9) {
+            uint32_t found_nblks{0};
+            for (auto& [key, val] : cache.get(0, start, nblks)) {
+                ASSERT_EQ(val.size(), key.m_count * g_blk_size);
+                for (uint32_t blk{key.m_nth}; blk <= key.end_nth(); ++blk) {
+                    const auto* const words{r_cast< const uint32_t* >(val.bytes() + (blk - key.m_nth) * g_blk_size)};
+                    ASSERT_EQ(words[0], blk);
+                    ASSERT_EQ(words[1], shadow[blk]) << "Stale data for blk=" << blk;
+                }
+                found_nblks += key.m_count;
+            }
+            ASSERT_EQ(found_nblks, std::count_if(std::next(shadow.begin(), start),
+                                                 std::next(shadow.begin(), start + nblks),
+                                                 [](const uint32_t v) { return v != 0; }));
+        } else {
+            cache.remove(0, start, nblks);
+            for (uint32_t blk{start}; blk < start + nblks; ++blk) {
+                if (shadow[blk] != 0) { --cached_nblks; }
+                shadow[blk] = 0;
+            }
+        }
+        ASSERT_EQ(evictor->filled_size(), int64_cast(cached_nblks * g_blk_size)) << "after version=" << version;
+    }
+
+    cache.remove(0, 0, num_blks);
+    ASSERT_EQ(evictor->filled_size(), 0);
+}
+
+TEST(RangeCacheEvictors, ClockSplitAndResize) { split_and_resize_test< ClockEvictor >(); }
+
+TEST(RangeCacheEvictors, S3FIFOSplitAndResize) { split_and_resize_test< S3FIFOEvictor >(); }
+
 SISL_OPTIONS_ENABLE(logging, test_rangecache)
 SISL_OPTION_GROUP(test_rangecache,
                   (cache_size_mb, "", "cache_size_mb", "cache size in mb",
@@ -142,6 +142,47 @@ TEST_F(RangeHashMapTest, SequentialTest) {
     validate_all();
 }
 
+TEST_F(RangeHashMapTest, InsertCopiesValue) {
+    LOGINFO("INFO: Insert a range and overwrite the inserted blob, the map is expected to have its own copy");
+    auto blob = create_data(100, 163);
+    m_map->insert(RangeKey{1u, 100u, 64u}, blob);
+    std::memset(blob.bytes(), 0, blob.size());
+    blob.buf_free();
+
+    const auto entries = m_map->get(RangeKey{1u, 100u, 64u});
+    ASSERT_EQ(entries.size(), 1u);
+    const auto& [key, val] = entries[0];
+    ASSERT_EQ(key.m_count, 64u);
+    uint8_t const* got_bytes = val.bytes();
+    for (auto o{key.m_nth}; o < key.m_nth + key.m_count; ++o) {
+        const auto expected = create_data(o, o);
+        compare_data(o, got_bytes, expected.cbytes());
+        expected.buf_free();
+        got_bytes += per_val_size;
+    }
+}
+
+TEST_F(RangeHashMapTest, InsertEraseBetweenEntries) {
+    const auto nfound = [this](const uint32_t start, const uint32_t end) {
+        big_count_t n{0};
+        for (const auto& [key, val] : m_map->get(RangeKey{1u, start, end - start + 1})) {
+            n += key.m_count;
+        }
+        return n;
+    };
+
+    LOGINFO("INFO: Insert and erase ranges which fall in the gap between the entries of a node");
+    insert_range(10, 14);
+    insert_range(100, 104);
+    insert_range(50, 54);
+    ASSERT_EQ(nfound(0, 255), 15u) << "Insert between entries is not expected to drop the entry after it";
+    erase_range(20, 24);
+    ASSERT_EQ(nfound(0, 255), 15u) << "Erase between entries is not expected to drop the entry after it";
+    erase_range(40, 60);
+    ASSERT_EQ(nfound(0, 255), 10u);
+    validate_range(0, 255);
+}
+
 VENUM(op_t, uint8_t, GET = 0, INSERT = 1, ERASE = 2)
 
 TEST_F(RangeHashMapTest, RandomEverythingTest) {
@@ -185,6 +226,71 @@ TEST_F(RangeHashMapTest, RandomEverythingTest) {
             nblks_read, ninsert_ops, nblks_inserted, nerase_ops, nblks_erased);
 }
 
+TEST_F(RangeHashMapTest, GrowWithNodes) {
+    static constexpr uint32_t nkeys{4096};
+    m_map = std::make_unique< RangeHashMap< uint32_t > >(2, extract_value, nullptr);
+
+    LOGINFO("INFO: Insert 2 nodes worth of range for each of {} base keys into a map with 2 buckets", nkeys);
+    const uint32_t end{max_n_per_node + 3};
+    auto blob = create_data(0, end);
+    for (uint32_t k{0}; k < nkeys; ++k) {
+        m_map->insert(RangeKey{k, 0u, end + 1}, blob);
+    }
+    blob.buf_free();
+    LOGINFO("INFO: Map has {} buckets now with max chain length={}", m_map->num_buckets(), m_map->max_chain_length());
+    ASSERT_GE(m_map->num_buckets(), 2 * nkeys / LinearHashBuckets< HashBucket< uint32_t > >::max_load());
+    ASSERT_LE(m_map->max_chain_length(), 32u) << "Chains are expected to stay short while the map grows";
+
+    for (uint32_t k{0}; k < nkeys; ++k) {
+        const auto entries = m_map->get(RangeKey{k, 0u, end + 1});
+        ASSERT_EQ(entries.size(), 2u) << "Expected one entry per node for base key " << k;
+        big_count_t nfound{0};
+        for (const auto& [key, val] : entries) {
+            ASSERT_EQ(key.m_base_key, k);
+            ASSERT_EQ(val.size(), key.m_count * per_val_size);
+            nfound += key.m_count;
+        }
+        ASSERT_EQ(nfound, end + 1);
+        m_map->erase(RangeKey{k, 0u, end + 1});
+        ASSERT_EQ(m_map->get(RangeKey{k, 0u, end + 1}).size(), 0u);
+    }
+}
+
+TEST_F(RangeHashMapTest, MultiGet) {
+    LOGINFO("INFO: Insert ranges of 4 with holes of 4 in between");
+    for (uint32_t k{0}; k < g_max_offset - 8; k += 8) {
+        insert_range(k, k + 3);
+    }
+
+    LOGINFO("INFO: Read them back in batches of ranges which span the holes and several nodes");
+    std::uniform_int_distribution< uint32_t > start_rand{0, g_max_offset - 1000};
+    for (uint32_t iter{0}; iter < 100; ++iter) {
+        std::vector< RangeKey< uint32_t > > keys;
+        big_count_t nexpected{0};
+        for (uint32_t i{0}; i < 16; ++i) {
+            const uint32_t start{start_rand(g_re)};
+            const uint32_t count{s_cast< uint32_t >(g_size_generator(g_re) % 1000) + 1};
+            keys.emplace_back(1u, start, count);
+            for (const auto& [key, val] : m_map->get(keys.back())) {
+                nexpected += key.m_count;
+            }
+        }
+
+        big_count_t nfound{0};
+        for (const auto& [key, val] : m_map->multi_get(keys)) {
+            ASSERT_EQ(key.m_base_key, 1u);
+            uint8_t const* got_bytes = val.bytes();
+            for (auto o{key.m_nth}; o < key.m_nth + key.m_count; ++o) {
+                ASSERT_EQ(m_inserted_slots.is_bits_set(o, 1), true) << "Found a key " << o << " which was not inserted";
+                compare_data(o, got_bytes, m_shadow_map.find(o)->second.cbytes());
+                got_bytes += per_val_size;
+            }
+            nfound += key.m_count;
+        }
+        ASSERT_EQ(nfound, nexpected) << "Batched get is expected to find the same entries as one get per range";
+    }
+}
+
 SISL_OPTIONS_ENABLE(logging, test_hashmap)
 SISL_OPTION_GROUP(test_hashmap,
                   (max_offset, "", "max_offset", "max number of offset",
@@ -30,7 +30,10 @@
 #include <sisl/options/options.h>
 #include <sisl/utility/enum.hpp>
 #include <sisl/cache/simple_cache.hpp>
+#include <sisl/cache/swiss_hashmap.hpp>
 #include <sisl/cache/lru_evictor.hpp>
+#include <sisl/cache/clock_evictor.hpp>
+#include <sisl/cache/s3fifo_evictor.hpp>
 
 using namespace sisl;
 SISL_LOGGING_INIT(test_simplecache)
@@ -269,6 +272,468 @@ TEST(SimpleCacheSize, MultithreadedEviction) {
     for (auto& t : threads) { t.join(); }
 }
 
+TEST(SimpleCacheSize, ClockEvictorKeepsReferenced) {
+    uint32_t num_partitions = 1;
+    uint32_t max_nodes_per_partition = 8;
+    uint32_t cache_size = g_val_size * num_partitions * max_nodes_per_partition;
+    std::shared_ptr< Evictor > evictor = std::make_unique< ClockEvictor >(cache_size, num_partitions);
+    auto simple_cache = std::make_unique< SimpleCache< uint32_t, std::shared_ptr< Entry > > >(
+        evictor,                                                               // Evictor to evict used entries
+        10000,                                                                 // Total number of buckets
+        g_val_size,                                                            // Value size
+        [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }, // Method to extract key
+        nullptr                                                                // Method to prevent eviction
+    );
+    auto* evictor_ptr = dynamic_cast< ClockEvictor* >(evictor.get());
+
+    // Key 0 is read before every insert, so it always has its reference bit set when the hand reaches it
+    ASSERT_TRUE(simple_cache->insert(std::make_shared< Entry >(0, "hot")));
+    for (uint32_t i = 1; i < 1000; i++) {
+        std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+        ASSERT_TRUE(simple_cache->get(0, e)) << "Referenced key evicted after " << i << " inserts";
+        ASSERT_EQ(e->m_contents, "hot");
+        ASSERT_TRUE(simple_cache->insert(std::make_shared< Entry >(i, fmt::format("test{}", i))));
+        ASSERT_LE(evictor_ptr->filled_size(), cache_size);
+    }
+
+    // Cold keys are evicted in the order of insertion, so only the latest ones remain
+    uint32_t cache_hits{0};
+    for (uint32_t i = 1; i < 1000; i++) {
+        std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+        if (simple_cache->get(i, e)) {
+            ASSERT_GE(i, 1000 - max_nodes_per_partition);
+            ++cache_hits;
+        }
+    }
+    ASSERT_EQ(cache_hits, max_nodes_per_partition - 1);
+}
+
+// Writers insert the keys [0, num_keys) while the readers get and validate them, the evictor has to keep the cache
+// within its size. With rcu_reads, the writers upsert as well
+template < typename EvictorT, typename MapT = SimpleHashMap< uint32_t, std::shared_ptr< Entry > > >
+static void multithreaded_eviction_test(const std::shared_ptr< EvictorT >& evictor, const uint32_t num_buckets,
+                                        const uint32_t num_iters, const uint32_t num_keys) {
+    static constexpr bool rcu_reads{std::is_same_v< MapT, RCUSimpleHashMap< uint32_t, std::shared_ptr< Entry > > >};
+    SimpleCache< uint32_t, std::shared_ptr< Entry >, MapT > cache{
+        evictor,                                                               // Evictor to evict used entries
+        num_buckets,                                                           // Initial number of buckets
+        g_val_size,                                                            // Value size
+        [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }, // Method to extract key
+        nullptr                                                                // Method to prevent eviction
+    };
+    std::vector< std::thread > threads;
+    for (uint32_t i{0}; i < 10; ++i) {
+        threads.emplace_back([&cache, &evictor, num_iters, num_keys, i]() {
+            if constexpr (rcu_reads) { sisl::urcu_ctl::register_rcu(); }
+            for (uint32_t j{0}; j < num_iters; ++j) {
+                // Upserts of the existing keys replace the nodes under the lock-free readers
+                auto e = std::make_shared< Entry >(j % num_keys, fmt::format("test{}-{}", j % num_keys, i));
+                if (!rcu_reads || ((j % 2) == 0)) {
+                    cache.insert(e);
+                } else {
+                    cache.upsert(e);
+                }
+                ASSERT_LE(evictor->filled_size(), evictor->max_size());
+            }
+            if constexpr (rcu_reads) { sisl::urcu_ctl::unregister_rcu(); }
+        });
+    }
+    for (uint32_t i{0}; i < 10; ++i) {
+        threads.emplace_back([&cache, num_iters, num_keys]() {
+            if constexpr (rcu_reads) { sisl::urcu_ctl::register_rcu(); }
+            for (uint32_t j{0}; j < num_iters; ++j) {
+                std::shared_ptr< Entry > e;
+                if (cache.get(j % num_keys, e)) {
+                    ASSERT_EQ(e->m_id, j % num_keys);
+                    ASSERT_EQ(e->m_contents.rfind(fmt::format("test{}-", j % num_keys), 0), 0u);
+                }
+            }
+            if constexpr (rcu_reads) { sisl::urcu_ctl::unregister_rcu(); }
+        });
+    }
+    for (auto& t : threads) { t.join(); }
+
+    if constexpr (rcu_reads) {
+        sisl::urcu_ctl::register_rcu();
+        rcu_barrier(); // Runs the pending frees of the replaced and evicted nodes
+        sisl::urcu_ctl::unregister_rcu();
+    }
+}
+
+TEST(SimpleCacheSize, ClockEvictorMultithreaded) {
+    const uint32_t num_iters{10 * 3 * 1000};
+    multithreaded_eviction_test(std::make_shared< ClockEvictor >(g_val_size * 10 * 3, 10), 10000, num_iters,
+                                num_iters);
+}
+
+TEST(SimpleCacheSize, BufferedLRUKeepsAccessed) {
+    uint32_t num_partitions = 1;
+    uint32_t max_nodes_per_partition = 8;
+    uint32_t cache_size = g_val_size * num_partitions * max_nodes_per_partition;
+    std::shared_ptr< Evictor > evictor =
+        std::make_unique< LRUEvictor >(cache_size, num_partitions, true /* buffered_access */);
+    auto simple_cache = std::make_unique< SimpleCache< uint32_t, std::shared_ptr< Entry > > >(
+        evictor,                                                               // Evictor to evict used entries
+        10000,                                                                 // Total number of buckets
+        g_val_size,                                                            // Value size
+        [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }, // Method to extract key
+        nullptr                                                                // Method to prevent eviction
+    );
+    auto* evictor_ptr = dynamic_cast< LRUEvictor* >(evictor.get());
+
+    // Hits on key 0 are buffered and applied by the next insert, before it evicts anything
+    ASSERT_TRUE(simple_cache->insert(std::make_shared< Entry >(0, "hot")));
+    for (uint32_t i = 1; i < 1000; i++) {
+        std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+        ASSERT_TRUE(simple_cache->get(0, e)) << "Accessed key evicted after " << i << " inserts";
+        ASSERT_EQ(e->m_contents, "hot");
+        ASSERT_TRUE(simple_cache->insert(std::make_shared< Entry >(i, fmt::format("test{}", i))));
+        ASSERT_LE(evictor_ptr->filled_size(), cache_size);
+    }
+
+    // More hits than the buffers can hold between two inserts drop some of them, but never lose the record
+    for (uint32_t i = 0; i < 10 * LRUEvictor::s_read_buffer_size; i++) {
+        std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+        ASSERT_TRUE(simple_cache->get(0, e));
+    }
+    ASSERT_TRUE(simple_cache->insert(std::make_shared< Entry >(1000, "test1000")));
+    std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+    ASSERT_TRUE(simple_cache->get(0, e));
+}
+
+TEST(SimpleCacheSize, BufferedLRUMultithreaded) {
+    // The readers keep accessing a few hot keys, which fills the read buffers
+    multithreaded_eviction_test(
+        std::make_shared< LRUEvictor >(g_val_size * 10 * 3, 10, true /* buffered_access */), 10000, 10 * 3 * 1000, 64);
+}
+
+TEST(SimpleCacheSize, BufferedLRUFailedInserts) {
+    uint32_t num_partitions = 1;
+    uint32_t max_nodes_per_partition = 8;
+    uint32_t cache_size = g_val_size * num_partitions * max_nodes_per_partition;
+    std::shared_ptr< Evictor > evictor =
+        std::make_unique< LRUEvictor >(cache_size, num_partitions, true /* buffered_access */);
+    auto simple_cache = std::make_unique< SimpleCache< uint32_t, std::shared_ptr< Entry > > >(
+        evictor,                                                               // Evictor to evict used entries
+        10000,                                                                 // Total number of buckets
+        g_val_size,                                                            // Value size
+        [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }, // Method to extract key
+        [](const CacheRecord&) { return false; }                               // Method to prevent eviction
+    );
+    for (uint32_t i = 0; i < max_nodes_per_partition; i++) {
+        ASSERT_TRUE(simple_cache->insert(std::make_shared< Entry >(i, fmt::format("test{}", i))));
+    }
+
+    // Nothing can be evicted, so every insert fails. The readers hit the records of the failed inserts before they
+    // are erased, which must not leave them in the read buffers once they are freed.
+    std::vector< std::thread > threads;
+    for (uint32_t i{0}; i < 4; ++i) {
+        threads.emplace_back([&simple_cache, max_nodes_per_partition]() {
+            for (uint32_t j{0}; j < 20000; ++j) {
+                const uint32_t key{max_nodes_per_partition + j % 16};
+                ASSERT_FALSE(simple_cache->insert(std::make_shared< Entry >(key, fmt::format("test{}", key))));
+            }
+        });
+    }
+    for (uint32_t i{0}; i < 4; ++i) {
+        threads.emplace_back([&simple_cache, max_nodes_per_partition]() {
+            for (uint32_t j{0}; j < 100000; ++j) {
+                const uint32_t key{max_nodes_per_partition + j % 16};
+                std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+                if (simple_cache->get(key, e)) { ASSERT_EQ(e->m_contents, fmt::format("test{}", key)); }
+            }
+        });
+    }
+    for (auto& t : threads) { t.join(); }
+    for (uint32_t i = 0; i < max_nodes_per_partition; i++) {
+        std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+        ASSERT_TRUE(simple_cache->get(i, e));
+    }
+}
+
+// Replays a trace of reads, inserting on every miss, and returns the hit ratio of the reads of hot keys. The trace
+// alternates between skewed reads of a hot set which fits in the cache and a scan of keys never read again, which is
+// larger than the cache.
+static double hot_hit_ratio(const std::shared_ptr< Evictor >& evictor) {
+    static constexpr uint32_t num_hot_keys{1000};
+    static constexpr uint32_t hot_reads_per_round{20000};
+    static constexpr uint32_t scan_keys_per_round{5000};
+    auto simple_cache = std::make_unique< SimpleCache< uint32_t, std::shared_ptr< Entry > > >(
+        evictor,                                                               // Evictor to evict used entries
+        10000,                                                                 // Total number of buckets
+        g_val_size,                                                            // Value size
+        [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }, // Method to extract key
+        nullptr                                                                // Method to prevent eviction
+    );
+
+    std::default_random_engine re{1234};
+    std::geometric_distribution< uint32_t > hot_key_rand{4.0 / num_hot_keys};
+    const auto read{[&simple_cache](const uint32_t key) {
+        std::shared_ptr< Entry > e = std::make_shared< Entry >(0);
+        if (simple_cache->get(key, e)) { return true; }
+        simple_cache->insert(std::make_shared< Entry >(key));
+        return false;
+    }};
+
+    uint64_t hits{0};
+    uint64_t reads{0};
+    uint32_t scan_key{num_hot_keys};
+    for (uint32_t round{0}; round < 10; ++round) {
+        for (uint32_t i{0}; i < hot_reads_per_round; ++i) {
+            const bool hit{read(hot_key_rand(re) % num_hot_keys)};
+            if (round > 0) {
+                // First round only warms up the cache
+                hits += hit ? 1 : 0;
+                ++reads;
+            }
+        }
+        for (uint32_t i{0}; i < scan_keys_per_round; ++i) {
+            read(scan_key++);
+        }
+    }
+    return static_cast< double >(hits) / reads;
+}
+
+TEST(SimpleCacheSize, ScanResistantHitRatio) {
+    uint32_t num_partitions = 4;
+    uint32_t cache_size = g_val_size * 2000;
+    const double lru_ratio{hot_hit_ratio(std::make_shared< LRUEvictor >(cache_size, num_partitions))};
+    const double buffered_lru_ratio{hot_hit_ratio(std::make_shared< LRUEvictor >(cache_size, num_partitions, true))};
+    const double clock_ratio{hot_hit_ratio(std::make_shared< ClockEvictor >(cache_size, num_partitions))};
+    const double s3fifo_ratio{hot_hit_ratio(std::make_shared< S3FIFOEvictor >(cache_size, num_partitions))};
+    LOGINFO("Hit ratio of the hot keys with scans in between: LRU={:.3f} buffered LRU={:.3f} CLOCK={:.3f} S3FIFO={:.3f}",
+            lru_ratio, buffered_lru_ratio, clock_ratio, s3fifo_ratio);
+    ASSERT_GT(s3fifo_ratio, lru_ratio) << "S3FIFO is expected to keep the hot keys across the scans";
+}
+
+TEST(SimpleCacheSize, S3FIFOEvictorMultithreaded) {
+    multithreaded_eviction_test(std::make_shared< S3FIFOEvictor >(g_val_size * 10 * 20, 10), 10000, 10 * 20 * 100,
+                                100);
+}
+
+TEST(SimpleHashMap, GrowWhileInUse) {
+    // Starts with 4 buckets, so that every thread keeps finding its keys while their buckets are split under them
+    static constexpr uint32_t nthreads{4};
+    static constexpr uint32_t keys_per_thread{20000};
+    SimpleHashMap< uint32_t, std::shared_ptr< Entry > > map{
+        4, [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }};
+
+    std::vector< std::thread > threads;
+    for (uint32_t t{0}; t < nthreads; ++t) {
+        threads.emplace_back([&map, t]() {
+            std::shared_ptr< Entry > e;
+            for (uint32_t i{0}; i < keys_per_thread; ++i) {
+                const uint32_t key{i * nthreads + t};
+                ASSERT_TRUE(map.insert(key, std::make_shared< Entry >(key, fmt::format("v{}", key))));
+                if ((i % 3) == 2) { ASSERT_TRUE(map.erase(key, e)); }
+
+                const uint32_t old_key{(i / 2) * nthreads + t};
+                ASSERT_EQ(map.get(old_key, e), ((i / 2) % 3) != 2) << "key=" << old_key;
+            }
+        });
+    }
+    for (auto& thr : threads) {
+        thr.join();
+    }
+
+    LOGINFO("Map grew to {} buckets with max chain length={}", map.num_buckets(), map.max_chain_length());
+    const uint64_t nkeys{nthreads * (keys_per_thread - keys_per_thread / 3)};
+    using buckets_t = LinearHashBuckets< SimpleHashBucket< uint32_t, std::shared_ptr< Entry > > >;
+    ASSERT_GE(map.num_buckets(), nkeys / buckets_t::max_load());
+    ASSERT_LE(map.max_chain_length(), 32u) << "Chains are expected to stay short while the map grows";
+    for (uint32_t key{0}; key < nthreads * keys_per_thread; ++key) {
+        std::shared_ptr< Entry > e;
+        ASSERT_EQ(map.get(key, e), ((key / nthreads) % 3) != 2) << "key=" << key;
+    }
+}
+
+TEST(SwissHashMap, RandomOps) {
+    // Starts small, so that the shards grow and get cleaned up of deleted slots many times
+    std::unordered_map< uint32_t, std::string > shadow;
+    int64_t live_records{0};
+    SwissHashMap< uint32_t, std::shared_ptr< Entry > > map{
+        64, [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; },
+        [&live_records](const ValueEntryBase&, const uint32_t&, const hash_op_t op) {
+            if (op == hash_op_t::CREATE) {
+                ++live_records;
+            } else if (op == hash_op_t::DELETE) {
+                --live_records;
+            }
+        }};
+
+    std::default_random_engine re{1234};
+    std::uniform_int_distribution< uint32_t > key_rand{0, 20000};
+    std::uniform_int_distribution< uint32_t > op_rand{0, 3};
+    for (uint32_t i{0}; i < 200000; ++i) {
+        const uint32_t key{key_rand(re)};
+        std::shared_ptr< Entry > e;
+        switch (op_rand(re)) {
+        case 0: {
+            const bool expected{shadow.find(key) == shadow.end()};
+            ASSERT_EQ(map.insert(key, std::make_shared< Entry >(key, fmt::format("v{}", i))), expected);
+            if (expected) { shadow[key] = fmt::format("v{}", i); }
+            break;
+        }
+        case 1: {
+            const bool expected{shadow.find(key) == shadow.end()};
+            ASSERT_EQ(map.upsert(key, std::make_shared< Entry >(key, fmt::format("u{}", i))), expected);
+            shadow[key] = fmt::format("u{}", i);
+            break;
+        }
+        case 2: {
+            const auto it{shadow.find(key)};
+            ASSERT_EQ(map.get(key, e), it != shadow.end()) << "key=" << key;
+            if (it != shadow.end()) { ASSERT_EQ(e->m_contents, it->second); }
+            break;
+        }
+        default: {
+            const auto it{shadow.find(key)};
+            ASSERT_EQ(map.erase(key, e), it != shadow.end()) << "key=" << key;
+            if (it != shadow.end()) {
+                ASSERT_EQ(e->m_contents, it->second);
+                shadow.erase(it);
+            }
+            break;
+        }
+        }
+    }
+    ASSERT_EQ(live_records, static_cast< int64_t >(shadow.size()));
+    for (const auto& [key, contents] : shadow) {
+        std::shared_ptr< Entry > e;
+        ASSERT_TRUE(map.get(key, e));
+        ASSERT_EQ(e->m_contents, contents);
+    }
+}
+
+TEST(SimpleCacheSize, SwissMapMultithreadedEviction) {
+    const uint32_t num_iters{10 * 3 * 1000};
+    multithreaded_eviction_test< LRUEvictor, SwissHashMap< uint32_t, std::shared_ptr< Entry > > >(
+        std::make_shared< LRUEvictor >(g_val_size * 10 * 3, 10), 10000, num_iters, num_iters);
+}
+
+TEST(SimpleCacheSize, RCUMapMultithreadedEviction) {
+    // Few initial buckets, so that the map grows while in use
+    multithreaded_eviction_test< ClockEvictor, RCUSimpleHashMap< uint32_t, std::shared_ptr< Entry > > >(
+        std::make_shared< ClockEvictor >(g_val_size * 10 * 20, 10), 16, 10 * 20 * 100, 1000);
+}
+
+// Upserts into a full cache, where nothing can be evicted
+template < typename MapT >
+static void full_cache_upsert_test(const std::shared_ptr< Evictor >& evictor, const uint32_t max_nodes) {
+    SimpleCache< uint32_t, std::shared_ptr< Entry >, MapT > cache{
+        evictor, 64, g_val_size, [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; },
+        [](const CacheRecord&) { return false; }};
+    for (uint32_t key{0}; key < max_nodes; ++key) {
+        ASSERT_TRUE(cache.insert(std::make_shared< Entry >(key, fmt::format("test{}", key))));
+    }
+
+    // Updates of the cached keys keep their records, new keys don't fit and are not left in the cache
+    for (uint32_t round{0}; round < 3; ++round) {
+        for (uint32_t key{0}; key < 2 * max_nodes; ++key) {
+            ASSERT_FALSE(cache.upsert(std::make_shared< Entry >(key, fmt::format("test{}-{}", key, round))));
+        }
+        for (uint32_t key{0}; key < 2 * max_nodes; ++key) {
+            std::shared_ptr< Entry > e;
+            ASSERT_EQ(cache.get(key, e), key < max_nodes) << "key=" << key;
+            if (key < max_nodes) { ASSERT_EQ(e->m_contents, fmt::format("test{}-{}", key, round)); }
+        }
+    }
+
+    // Removing the cached keys makes room for the new ones
+    for (uint32_t key{0}; key < max_nodes; ++key) {
+        std::shared_ptr< Entry > e;
+        ASSERT_TRUE(cache.remove(key, e));
+    }
+    for (uint32_t key{max_nodes}; key < 2 * max_nodes; ++key) {
+        ASSERT_TRUE(cache.upsert(std::make_shared< Entry >(key, fmt::format("test{}", key))));
+    }
+    ASSERT_FALSE(cache.upsert(std::make_shared< Entry >(0, "test0")));
+}
+
+// Evictor which doesn't override record_replaced(), so that the replaced records are removed and added afresh
+struct ReaddOnReplaceEvictor : public ClockEvictor {
+    using ClockEvictor::ClockEvictor;
+    bool record_replaced(uint64_t hash_code, CacheRecord& record, CacheRecord& new_record) override {
+        return Evictor::record_replaced(hash_code, record, new_record);
+    }
+};
+
+TEST(SimpleCacheSize, FullCacheUpsert) {
+    const uint32_t max_nodes{8};
+    const auto evictors{[max_nodes]() -> std::vector< std::shared_ptr< Evictor > > {
+        return {std::make_shared< LRUEvictor >(g_val_size * max_nodes, 1),
+                std::make_shared< LRUEvictor >(g_val_size * max_nodes, 1, true /* buffered_access */),
+                std::make_shared< ClockEvictor >(g_val_size * max_nodes, 1),
+                std::make_shared< S3FIFOEvictor >(g_val_size * max_nodes, 1),
+                std::make_shared< ReaddOnReplaceEvictor >(g_val_size * max_nodes, 1)};
+    }};
+    for (const auto& evictor : evictors()) {
+        full_cache_upsert_test< SimpleHashMap< uint32_t, std::shared_ptr< Entry > > >(evictor, max_nodes);
+    }
+
+    sisl::urcu_ctl::register_rcu();
+    for (const auto& evictor : evictors()) {
+        // Only the evictors which count accesses see the RCU reads
+        if (!evictor->counts_accesses()) { continue; }
+        full_cache_upsert_test< RCUSimpleHashMap< uint32_t, std::shared_ptr< Entry > > >(evictor, max_nodes);
+    }
+    rcu_barrier(); // Runs the pending frees of the replaced nodes
+    sisl::urcu_ctl::unregister_rcu();
+}
+
+TEST(SimpleCacheSize, RCUMapNeedsCountingEvictor) {
+    using map_t = RCUSimpleHashMap< uint32_t, std::shared_ptr< Entry > >;
+    using cache_t = SimpleCache< uint32_t, std::shared_ptr< Entry >, map_t >;
+    const auto extract_cb{[](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }};
+    ASSERT_DEATH(cache_t(std::make_shared< LRUEvictor >(g_val_size * 8, 1), 64, g_val_size, extract_cb), "");
+    cache_t cache{std::make_shared< ClockEvictor >(g_val_size * 8, 1), 64, g_val_size, extract_cb};
+}
+
+template < typename MapT >
+static void multi_ops_test() {
+    uint32_t num_partitions = 4;
+    uint32_t cache_size = g_val_size * 100000;
+    std::shared_ptr< Evictor > evictor = std::make_unique< ClockEvictor >(cache_size, num_partitions);
+    SimpleCache< uint32_t, std::shared_ptr< Entry >, MapT > cache{
+        evictor, 64, g_val_size, [](const std::shared_ptr< Entry >& e) -> uint32_t { return e->m_id; }};
+
+    // Even keys are inserted in batches, each batch has one key from the previous one, which is not inserted again
+    std::vector< std::shared_ptr< Entry > > values;
+    uint32_t ninserted{0};
+    for (uint32_t batch{0}; batch < 100; ++batch) {
+        values.clear();
+        if (batch > 0) { values.push_back(std::make_shared< Entry >((batch * 50 - 1) * 2)); }
+        for (uint32_t i{0}; i < 50; ++i) {
+            const uint32_t key{(batch * 50 + i) * 2};
+            values.push_back(std::make_shared< Entry >(key, fmt::format("test{}", key)));
+        }
+        ninserted += cache.multi_insert(values);
+    }
+    ASSERT_EQ(ninserted, 5000u);
+
+    std::vector< uint32_t > keys;
+    for (uint32_t key{0}; key < 10000; key += 3) {
+        keys.push_back(key);
+    }
+    std::vector< std::pair< uint32_t, std::shared_ptr< Entry > > > found;
+    const uint32_t nfound{cache.multi_get(keys, found)};
+    ASSERT_EQ(nfound, found.size());
+    ASSERT_EQ(nfound, (keys.size() + 1) / 2) << "Expected only the even keys to be found";
+    for (const auto& [key, e] : found) {
+        ASSERT_EQ(key % 2, 0u);
+        ASSERT_EQ(e->m_contents, fmt::format("test{}", key));
+    }
+}
+
+TEST(SimpleCacheSize, MultiGetInsert) {
+    multi_ops_test< SimpleHashMap< uint32_t, std::shared_ptr< Entry > > >();
+    multi_ops_test< SwissHashMap< uint32_t, std::shared_ptr< Entry > > >();
+
+    sisl::urcu_ctl::register_rcu();
+    multi_ops_test< RCUSimpleHashMap< uint32_t, std::shared_ptr< Entry > > >();
+    sisl::urcu_ctl::unregister_rcu();
+}
+
 SISL_OPTIONS_ENABLE(logging, test_simplecache)
 SISL_OPTION_GROUP(test_simplecache,
                   (cache_size_mb, "", "cache_size_mb", "cache size in mb",
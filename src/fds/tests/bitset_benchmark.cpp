@@ -0,0 +1,502 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <sisl/logging/logging.h>
+
+#include "sisl/fds/bitset.hpp"
+#include "sisl/fds/bitword.hpp"
+#include "sisl/fds/compact_bitset.hpp"
+#include "sisl/fds/sparse_bitset.hpp"
+
+SISL_LOGGING_INIT(bitset_benchmark)
+
+namespace {
+constexpr uint64_t ALLOC_BITS{1024 * 1024};
+constexpr size_t ITERATIONS{200000};
+constexpr uint32_t MAX_BLOCK_BITS{16};
+constexpr size_t BLOCKS_HELD_PER_THREAD{1024};
+
+std::unique_ptr< sisl::AtomicBitset > g_alloc_bset;
+std::mutex g_alloc_mutex;
+
+// Each iteration allocates a block of random size and once the thread holds enough of them frees the oldest one, so
+// the bitset stays in a steady, fragmented state.
+template < typename AllocFn >
+void run_allocator(benchmark::State& state, AllocFn&& alloc_fn) {
+    if (state.thread_index() == 0) { g_alloc_bset = std::make_unique< sisl::AtomicBitset >(ALLOC_BITS); }
+
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint32_t > nbits_rand{1, MAX_BLOCK_BITS};
+    std::uniform_int_distribution< uint64_t > hint_rand{0, ALLOC_BITS - 1};
+    std::vector< sisl::BitBlock > held;
+    held.reserve(BLOCKS_HELD_PER_THREAD);
+    size_t oldest{0};
+
+    for ([[maybe_unused]] auto si : state) { // Loops up to iteration count
+        const sisl::BitBlock b{alloc_fn(hint_rand(re), nbits_rand(re))};
+        if (b.nbits == 0) { continue; }
+        if (held.size() < BLOCKS_HELD_PER_THREAD) {
+            held.push_back(b);
+        } else {
+            g_alloc_bset->reset_bits(held[oldest].start_bit, held[oldest].nbits);
+            held[oldest] = b;
+            oldest = (oldest + 1) % BLOCKS_HELD_PER_THREAD;
+        }
+    }
+
+    for (const auto& b : held) {
+        g_alloc_bset->reset_bits(b.start_bit, b.nbits);
+    }
+}
+
+void test_mutex_alloc(benchmark::State& state) {
+    run_allocator(state, [](const uint64_t hint, const uint32_t nbits) {
+        std::lock_guard< std::mutex > lg{g_alloc_mutex};
+        const sisl::BitBlock b{g_alloc_bset->get_next_contiguous_n_reset_bits(hint, std::nullopt, 1, nbits)};
+        if (b.nbits > 0) { g_alloc_bset->set_bits(b.start_bit, b.nbits); }
+        return b;
+    });
+}
+
+void test_lockfree_claim_alloc(benchmark::State& state) {
+    run_allocator(state, [](const uint64_t hint, const uint32_t nbits) {
+        return g_alloc_bset->claim_next_contiguous_n_reset_bits(hint, 1, nbits);
+    });
+}
+
+constexpr uint64_t DENSITY_BITS{16 * 1024 * 1024};
+
+uint64_t memory_bytes(const sisl::Bitset& bset) { return bset.serialized_size(); }
+uint64_t memory_bytes(const sisl::SparseBitset& bset) { return bset.memory_usage(); }
+
+// Populate with density in parts per 10000 bits set at random positions. Beyond 50% everything is set first and
+// random bits are reset, so that high densities are made of long runs with holes.
+template < typename BitsetType >
+void populate(BitsetType& bset, const uint32_t density, std::default_random_engine& re) {
+    std::uniform_int_distribution< uint64_t > bit_rand{0, bset.size() - 1};
+    const bool mostly_set{density > 5000};
+    if (mostly_set) { bset.set_bits(0, bset.size()); }
+    const uint64_t nflips{bset.size() * (mostly_set ? (10000 - density) : density) / 10000};
+    for (uint64_t i{0}; i < nflips; ++i) {
+        if (mostly_set) {
+            bset.reset_bit(bit_rand(re));
+        } else {
+            bset.set_bit(bit_rand(re));
+        }
+    }
+    if constexpr (std::is_same_v< BitsetType, sisl::SparseBitset >) { bset.run_optimize(); }
+}
+
+// Lookup of a random bit followed by search of the next set bit from there
+template < typename BitsetType >
+void test_density_query(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    BitsetType bset{DENSITY_BITS};
+    populate(bset, static_cast< uint32_t >(state.range(0)), re);
+
+    std::uniform_int_distribution< uint64_t > bit_rand{0, DENSITY_BITS - 1};
+    for ([[maybe_unused]] auto si : state) {
+        const uint64_t bit{bit_rand(re)};
+        benchmark::DoNotOptimize(bset.get_bitval(bit));
+        benchmark::DoNotOptimize(bset.get_next_set_bit(bit));
+    }
+    state.counters["bytes"] = static_cast< double >(memory_bytes(bset));
+}
+
+// Flip a random bit and flip it back, which keeps the density same
+template < typename BitsetType >
+void test_density_update(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    BitsetType bset{DENSITY_BITS};
+    populate(bset, static_cast< uint32_t >(state.range(0)), re);
+
+    std::uniform_int_distribution< uint64_t > bit_rand{0, DENSITY_BITS - 1};
+    for ([[maybe_unused]] auto si : state) {
+        const uint64_t bit{bit_rand(re)};
+        if (bset.get_bitval(bit)) {
+            bset.reset_bit(bit);
+            bset.set_bit(bit);
+        } else {
+            bset.set_bit(bit);
+            bset.reset_bit(bit);
+        }
+    }
+    state.counters["bytes"] = static_cast< double >(memory_bytes(bset));
+}
+
+constexpr uint64_t BITWISE_BITS{4 * 1024 * 1024};
+
+// Range arg is the shrink_head offset of the rhs bitset, non zero offset needs words to be shifted before the op
+void test_bitwise_or(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::Bitset lhs{BITWISE_BITS};
+    sisl::Bitset rhs{BITWISE_BITS + static_cast< uint64_t >(state.range(0))};
+    populate(lhs, 1000, re);
+    populate(rhs, 1000, re);
+    rhs.shrink_head(static_cast< uint64_t >(state.range(0)));
+    for ([[maybe_unused]] auto si : state) {
+        lhs.or_with(rhs);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast< int64_t >(state.iterations() * BITWISE_BITS / 8));
+}
+
+void test_popcount_of_and(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::Bitset lhs{BITWISE_BITS};
+    sisl::Bitset rhs{BITWISE_BITS + static_cast< uint64_t >(state.range(0))};
+    populate(lhs, 5000, re);
+    populate(rhs, 5000, re);
+    rhs.shrink_head(static_cast< uint64_t >(state.range(0)));
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(lhs.popcount_of_and(rhs));
+    }
+    state.SetBytesProcessed(static_cast< int64_t >(state.iterations() * BITWISE_BITS / 8));
+}
+
+constexpr uint64_t PARALLEL_SCAN_BITS{256 * 1024 * 1024};
+
+// Range arg is the number of parts the scan is split into, each run on its own thread, to show scaling with cores
+void test_parallel_set_count(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::Bitset bset{PARALLEL_SCAN_BITS};
+    populate(bset, 1000, re);
+    const auto executor{sisl::bitset_thread_executor()};
+    const auto nparts{static_cast< uint32_t >(state.range(0))};
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(bset.get_set_count(executor, nparts));
+    }
+    state.SetBytesProcessed(static_cast< int64_t >(state.iterations() * PARALLEL_SCAN_BITS / 8));
+}
+
+void test_parallel_to_extents(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::Bitset bset{PARALLEL_SCAN_BITS};
+    populate(bset, 9990, re);
+    const auto executor{sisl::bitset_thread_executor()};
+    const auto nparts{static_cast< uint32_t >(state.range(0))};
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(bset.to_extents(executor, nparts));
+    }
+    state.SetBytesProcessed(static_cast< int64_t >(state.iterations() * PARALLEL_SCAN_BITS / 8));
+}
+
+// Rebuild of an extent list from the set bits, range arg 0 searches the next set and reset bits for every extent and 1
+// iterates over set_runs()
+void test_extent_rebuild(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::ThreadSafeBitset bset{DENSITY_BITS};
+    populate(bset, 2000, re);
+    std::vector< sisl::BitBlock > extents;
+    for ([[maybe_unused]] auto si : state) {
+        extents.clear();
+        if (state.range(0) == 0) {
+            for (uint64_t bit{bset.get_next_set_bit(0)}; bit != sisl::ThreadSafeBitset::npos;) {
+                const uint64_t end{bset.get_next_reset_bit(bit)};
+                const uint64_t stop{(end == sisl::ThreadSafeBitset::npos) ? bset.size() : end};
+                extents.emplace_back(bit, static_cast< uint32_t >(stop - bit));
+                bit = (end == sisl::ThreadSafeBitset::npos) ? end : bset.get_next_set_bit(end);
+            }
+        } else {
+            for (const auto& b : bset.set_runs()) {
+                extents.push_back(b);
+            }
+        }
+        benchmark::DoNotOptimize(extents.data());
+    }
+    state.counters["extents"] = static_cast< double >(extents.size());
+}
+
+// Best fit on a fragmented bitset, range arg turns on the free run index. Every iteration allocates from the best fit
+// run and frees it back, which keeps the index having a few stale segments like a real allocator would.
+void test_best_fit(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::Bitset bset{DENSITY_BITS};
+    populate(bset, 9990, re);
+    if (state.range(0)) { bset.enable_free_run_index(); }
+    std::uniform_int_distribution< uint32_t > nbits_rand{1, 3};
+    for ([[maybe_unused]] auto si : state) {
+        const auto b{bset.get_best_fit_contiguous_reset_bits(nbits_rand(re))};
+        if (b.nbits > 0) {
+            bset.set_bits(b.start_bit, 1);
+            bset.reset_bit(b.start_bit);
+        }
+    }
+}
+
+constexpr uint64_t SEARCH_BITS{4 * 1024 * 1024};
+
+// Fragmentation patterns of the set bits for the search benchmarks
+constexpr int64_t SCATTERED{0}; // Independent random bits
+constexpr int64_t CLUSTERED{1}; // Runs of upto 256 bits at random places
+
+template < typename BitsetType >
+void populate_pattern(BitsetType& bset, const uint32_t density, const int64_t pattern, std::default_random_engine& re) {
+    if (pattern == SCATTERED) { return populate(bset, density, re); }
+    std::uniform_int_distribution< uint64_t > bit_rand{0, bset.size() - 1};
+    std::uniform_int_distribution< uint64_t > len_rand{1, 256};
+    const uint64_t target{bset.size() * density / 10000};
+    uint64_t nset{0};
+    while (nset < target) {
+        const uint64_t start{bit_rand(re)};
+        const uint64_t len{std::min(len_rand(re), bset.size() - start)};
+        bset.set_bits(start, len);
+        nset += len;
+    }
+}
+
+// Search from random bits, args are the density in parts per 10000 and the fragmentation pattern
+template < typename BitsetType, typename SearchFn >
+void run_search(benchmark::State& state, SearchFn&& search_fn) {
+    std::default_random_engine re{1234};
+    BitsetType bset{SEARCH_BITS};
+    populate_pattern(bset, static_cast< uint32_t >(state.range(0)), state.range(1), re);
+
+    std::uniform_int_distribution< uint64_t > bit_rand{0, SEARCH_BITS - 1};
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(search_fn(bset, bit_rand(re)));
+    }
+}
+
+template < typename BitsetType >
+void test_next_set_bit(benchmark::State& state) {
+    run_search< BitsetType >(state,
+                             [](const BitsetType& bset, const uint64_t bit) { return bset.get_next_set_bit(bit); });
+}
+
+template < typename BitsetType >
+void test_next_reset_bit(benchmark::State& state) {
+    run_search< BitsetType >(state,
+                             [](const BitsetType& bset, const uint64_t bit) { return bset.get_next_reset_bit(bit); });
+}
+
+template < typename BitsetType >
+void test_next_contiguous_reset_bits(benchmark::State& state) {
+    run_search< BitsetType >(state, [](const BitsetType& bset, const uint64_t bit) {
+        return bset.get_next_contiguous_n_reset_bits(bit, std::nullopt, 16, 64).start_bit;
+    });
+}
+
+// Args are the max length of the range and whether it is aligned to the words
+template < typename BitsetType >
+void test_set_reset_bits(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    BitsetType bset{SEARCH_BITS};
+    const uint64_t max_len{static_cast< uint64_t >(state.range(0))};
+    const bool aligned{state.range(1) != 0};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, SEARCH_BITS - max_len};
+    std::uniform_int_distribution< uint64_t > len_rand{1, max_len};
+    for ([[maybe_unused]] auto si : state) {
+        const uint64_t start{aligned ? (bit_rand(re) & ~uint64_t{63}) : bit_rand(re)};
+        const uint64_t len{aligned ? max_len : len_rand(re)};
+        bset.set_bits(start, len);
+        bset.reset_bits(start, len);
+    }
+}
+
+// Reset a batch of short blocks, like freeing the blocks of the completed I/Os. Args are the number of blocks in the
+// batch, whether they are reset as one batch (1) or one block at a time (0) and the pattern of the blocks. Clustered
+// pattern has runs of 8 blocks allocated back to back, which get merged by the batch.
+template < typename BitsetType >
+void test_batch_reset_bits(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    BitsetType bset{static_cast< uint32_t >(SEARCH_BITS)};
+    const bool batched{state.range(1) != 0};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, SEARCH_BITS - 8 * MAX_BLOCK_BITS};
+    std::uniform_int_distribution< uint32_t > nbits_rand{1, MAX_BLOCK_BITS};
+    std::vector< sisl::BitBlock > blocks;
+    uint64_t next_bit{0};
+    for (int64_t i{0}; i < state.range(0); ++i) {
+        if ((state.range(2) == SCATTERED) || (i % 8 == 0)) { next_bit = bit_rand(re); }
+        blocks.emplace_back(next_bit, nbits_rand(re));
+        next_bit += blocks.back().nbits;
+    }
+    for ([[maybe_unused]] auto si : state) {
+        if (batched) {
+            bset.reset_bits_batch(blocks);
+        } else {
+            for (const auto& b : blocks) {
+                if constexpr (std::is_same_v< BitsetType, sisl::CompactBitSet >) {
+                    // No range reset on compact bitset
+                    for (uint64_t bit{b.start_bit}; bit < b.start_bit + b.nbits; ++bit) {
+                        bset.reset_bit(static_cast< uint32_t >(bit));
+                    }
+                } else {
+                    bset.reset_bits(b.start_bit, b.nbits);
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast< int64_t >(state.iterations()) * state.range(0));
+}
+
+template < typename BitsetType >
+void test_serialize(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    BitsetType bset{static_cast< uint64_t >(state.range(0))};
+    populate(bset, 1000, re);
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(bset.serialize(std::nullopt, true /* force_copy */));
+    }
+    state.SetBytesProcessed(static_cast< int64_t >(state.iterations() * bset.size() / 8));
+}
+
+template < typename BitsetType >
+void test_deserialize(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    BitsetType bset{static_cast< uint64_t >(state.range(0))};
+    populate(bset, 1000, re);
+    const auto buf{bset.serialize(std::nullopt, true /* force_copy */)};
+    for ([[maybe_unused]] auto si : state) {
+        const BitsetType loaded{buf};
+        benchmark::DoNotOptimize(loaded.size());
+    }
+    state.SetBytesProcessed(static_cast< int64_t >(state.iterations() * bset.size() / 8));
+}
+
+std::unique_ptr< sisl::AtomicBitset > g_update_bset;
+
+// Random set and reset of bits and short ranges from all threads on a shared bitset
+void test_atomic_updates(benchmark::State& state) {
+    if (state.thread_index() == 0) { g_update_bset = std::make_unique< sisl::AtomicBitset >(SEARCH_BITS); }
+
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, SEARCH_BITS - MAX_BLOCK_BITS};
+    std::uniform_int_distribution< uint32_t > nbits_rand{1, MAX_BLOCK_BITS};
+    for ([[maybe_unused]] auto si : state) {
+        const uint64_t bit{bit_rand(re)};
+        const uint32_t nbits{nbits_rand(re)};
+        if (nbits == 1) {
+            g_update_bset->set_bit(bit);
+            g_update_bset->reset_bit(bit);
+        } else {
+            g_update_bset->set_bits(bit, nbits);
+            g_update_bset->reset_bits(bit, nbits);
+        }
+    }
+}
+
+void test_compact_next_set_bit(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    sisl::CompactBitSet bset{static_cast< sisl::CompactBitSet::bit_count_t >(SEARCH_BITS)};
+    std::uniform_int_distribution< uint32_t > bit_rand{0, static_cast< uint32_t >(SEARCH_BITS - 1)};
+    const uint64_t nset{SEARCH_BITS * static_cast< uint64_t >(state.range(0)) / 10000};
+    for (uint64_t i{0}; i < nset; ++i) {
+        bset.set_bit(bit_rand(re));
+    }
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(bset.get_next_set_bit(bit_rand(re)));
+    }
+}
+
+// Filtered run match within a single word, arg is the number of reset bits needed
+void test_bitword_filtered(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    std::uniform_int_distribution< uint64_t > word_rand{};
+    std::vector< sisl::Bitword< sisl::unsafe_bits< uint64_t > > > words;
+    words.reserve(4096);
+    for (size_t i{0}; i < 4096; ++i) {
+        // And of two randoms to have 3/4th reset bits and runs of them
+        words.emplace_back(word_rand(re) & word_rand(re));
+    }
+    const uint32_t n{static_cast< uint32_t >(state.range(0))};
+    const sisl::bit_filter filter{n, n, n};
+    // Second arg picks the generic (0) or BMI2 (1) matching
+    if (!sisl::bitset_simd::set_bmi2_enabled(state.range(1) != 0)) {
+        state.SkipWithError("BMI2 not supported");
+        return;
+    }
+    size_t i{0};
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(words[i++ % words.size()].get_next_reset_bits_filtered(0, filter));
+    }
+    sisl::bitset_simd::set_bmi2_enabled(sisl::bitset_simd::is_bmi2_supported());
+}
+
+// Single reset bit search with the compile time filter
+void test_bitword_filtered_single(benchmark::State& state) {
+    std::default_random_engine re{1234};
+    std::uniform_int_distribution< uint64_t > word_rand{};
+    std::vector< sisl::Bitword< sisl::unsafe_bits< uint64_t > > > words;
+    words.reserve(4096);
+    for (size_t i{0}; i < 4096; ++i) {
+        // Or of two randoms to have 3/4th set bits
+        words.emplace_back(word_rand(re) | word_rand(re));
+    }
+    if (!sisl::bitset_simd::set_bmi2_enabled(state.range(0) != 0)) {
+        state.SkipWithError("BMI2 not supported");
+        return;
+    }
+    size_t i{0};
+    for ([[maybe_unused]] auto si : state) {
+        benchmark::DoNotOptimize(words[i++ % words.size()].get_next_reset_bits_filtered< 1, 1, 1 >(0));
+    }
+    sisl::bitset_simd::set_bmi2_enabled(sisl::bitset_simd::is_bmi2_supported());
+}
+} // namespace
+
+BENCHMARK(test_mutex_alloc)->Iterations(ITERATIONS)->ThreadRange(1, 8);
+BENCHMARK(test_lockfree_claim_alloc)->Iterations(ITERATIONS)->ThreadRange(1, 8);
+
+// Densities of 0.01%, 1%, 10%, 50% and 99.9% bits set
+BENCHMARK_TEMPLATE(test_density_query, sisl::Bitset)->Arg(1)->Arg(100)->Arg(1000)->Arg(5000)->Arg(9990);
+BENCHMARK_TEMPLATE(test_density_query, sisl::SparseBitset)->Arg(1)->Arg(100)->Arg(1000)->Arg(5000)->Arg(9990);
+BENCHMARK_TEMPLATE(test_density_update, sisl::Bitset)->Arg(1)->Arg(100)->Arg(1000)->Arg(5000)->Arg(9990);
+BENCHMARK_TEMPLATE(test_density_update, sisl::SparseBitset)->Arg(1)->Arg(100)->Arg(1000)->Arg(5000)->Arg(9990);
+// Densities of 1%, 50% and 99% bits set, scattered and clustered
+#define SEARCH_ARGS ArgsProduct({{100, 5000, 9900}, {SCATTERED, CLUSTERED}})
+BENCHMARK_TEMPLATE(test_next_set_bit, sisl::Bitset)->SEARCH_ARGS;
+BENCHMARK_TEMPLATE(test_next_set_bit, sisl::AtomicBitset)->SEARCH_ARGS;
+BENCHMARK_TEMPLATE(test_next_reset_bit, sisl::Bitset)->SEARCH_ARGS;
+BENCHMARK_TEMPLATE(test_next_reset_bit, sisl::AtomicBitset)->SEARCH_ARGS;
+BENCHMARK_TEMPLATE(test_next_contiguous_reset_bits, sisl::Bitset)->SEARCH_ARGS;
+BENCHMARK_TEMPLATE(test_next_contiguous_reset_bits, sisl::AtomicBitset)->SEARCH_ARGS;
+
+BENCHMARK_TEMPLATE(test_set_reset_bits, sisl::Bitset)->ArgsProduct({{1, 64, 4096}, {0, 1}});
+BENCHMARK_TEMPLATE(test_set_reset_bits, sisl::AtomicBitset)->ArgsProduct({{1, 64, 4096}, {0, 1}});
+#define BATCH_ARGS ArgsProduct({{16, 64, 256, 1024}, {0, 1}, {SCATTERED, CLUSTERED}})
+BENCHMARK_TEMPLATE(test_batch_reset_bits, sisl::ThreadSafeBitset)->BATCH_ARGS;
+BENCHMARK_TEMPLATE(test_batch_reset_bits, sisl::CompactBitSet)->BATCH_ARGS;
+BENCHMARK_TEMPLATE(test_serialize, sisl::Bitset)->Arg(1024 * 1024)->Arg(64 * 1024 * 1024);
+BENCHMARK_TEMPLATE(test_deserialize, sisl::Bitset)->Arg(1024 * 1024)->Arg(64 * 1024 * 1024);
+BENCHMARK_TEMPLATE(test_deserialize, sisl::AtomicBitset)->Arg(1024 * 1024)->Arg(64 * 1024 * 1024);
+BENCHMARK(test_atomic_updates)->Iterations(ITERATIONS)->ThreadRange(1, 8);
+BENCHMARK(test_compact_next_set_bit)->Arg(100)->Arg(5000);
+BENCHMARK(test_bitword_filtered)->ArgsProduct({{1, 4, 16}, {0, 1}});
+BENCHMARK(test_bitword_filtered_single)->Arg(0)->Arg(1);
+
+BENCHMARK(test_best_fit)->Arg(0)->Arg(1);
+BENCHMARK(test_bitwise_or)->Arg(0)->Arg(13);
+BENCHMARK(test_popcount_of_and)->Arg(0)->Arg(13);
+BENCHMARK(test_parallel_set_count)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(test_parallel_to_extents)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(test_extent_rebuild)->Arg(0)->Arg(1);
+
+int main(int argc, char** argv) {
+    int parsed_argc{argc};
+    ::benchmark::Initialize(&parsed_argc, argv);
+    ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -14,8 +14,12 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <thread>
 #include <vector>
@@ -527,6 +531,870 @@ TEST_F(BitsetTest, GetNextContiguousUptoNResetBits) {
     ASSERT_EQ(result13.nbits, static_cast< uint32_t >(32));
 }
 
+TEST_F(BitsetTest, ContiguousResetBitsAllISA) {
+    // Only sisl::Bitset uses the vectorized uniform word skip, atomic words are always searched one word at a time.
+    // Build a Bitset made of runs of fully set words, fully reset words and mixed words so that both the vectorized
+    // skip and the per word filter paths are exercised, and compare it with an AtomicBitset of the same words.
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint32_t > kind_rand{0, 2};
+    std::uniform_int_distribution< uint32_t > run_rand{1, 20};
+    std::uniform_int_distribution< uint64_t > word_rand{};
+
+    constexpr uint64_t total_words{4096};
+    std::vector< uint64_t > words;
+    words.reserve(total_words);
+    while (words.size() < total_words) {
+        const auto kind{kind_rand(re)};
+        for (uint32_t w{run_rand(re)}; (w > 0) && (words.size() < total_words); --w) {
+            words.push_back((kind == 0) ? uint64_t{0} : ((kind == 1) ? ~uint64_t{0} : word_rand(re)));
+        }
+    }
+
+    const auto collect{[](const auto& bset, const uint32_t min_needed, const uint32_t max_needed) {
+        std::vector< std::pair< uint64_t, uint32_t > > blocks;
+        uint64_t start{0};
+        while (start < bset.size()) {
+            const auto b{bset.get_next_contiguous_n_reset_bits(start, std::nullopt, min_needed, max_needed)};
+            if (b.nbits == 0) { break; }
+            blocks.emplace_back(b.start_bit, b.nbits);
+            start = b.start_bit + b.nbits;
+        }
+        return blocks;
+    }};
+
+    Bitset bset{words.data(), words.data() + words.size()};
+    AtomicBitset abset{words.data(), words.data() + words.size()};
+    const uint64_t shift{static_cast< uint64_t >(Bitset::word_size() / 3)};
+    Bitset shifted_bset{words.data(), words.data() + words.size()};
+    shifted_bset.shrink_head(shift);
+
+    const auto orig_isa{bitset_simd::active_isa()};
+    const std::vector< std::pair< uint32_t, uint32_t > > needs{{1, 1}, {3, 3}, {10, 200}, {64, 64}, {100, 100},
+                                                                {130, 400}, {256, 1024}, {700, 700}};
+    for (const auto& [min_needed, max_needed] : needs) {
+        ASSERT_TRUE(bitset_simd::set_active_isa(bitset_isa::scalar));
+        const auto expected{collect(bset, min_needed, max_needed)};
+        const auto expected_shifted{collect(shifted_bset, min_needed, max_needed)};
+
+        // Atomic words don't use the kernels, so they give the result of the per word search for any isa
+        ASSERT_EQ(collect(abset, min_needed, max_needed), expected)
+            << "Scalar kernel differs from the per word search for min=" << min_needed << " max=" << max_needed;
+
+        for (const auto isa : {bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512}) {
+            if (!bitset_simd::set_active_isa(isa)) {
+                LOGINFO("ISA {} is not supported on this cpu, skipping", enum_name(isa));
+                continue;
+            }
+            ASSERT_EQ(collect(bset, min_needed, max_needed), expected)
+                << "Mismatch for isa=" << enum_name(isa) << " min=" << min_needed << " max=" << max_needed;
+            ASSERT_EQ(collect(shifted_bset, min_needed, max_needed), expected_shifted)
+                << "Shifted mismatch for isa=" << enum_name(isa) << " min=" << min_needed << " max=" << max_needed;
+        }
+    }
+    bitset_simd::set_active_isa(orig_isa);
+}
+
+TEST_F(BitsetTest, SummaryIndexSearch) {
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+
+    // Mostly full bitset with a few holes, validated against a twin bitset without summary
+    const auto validate{[](const auto& expected_bset, const auto& actual_bset) {
+        uint64_t bit{0};
+        do {
+            const auto expected{expected_bset.get_next_reset_bit(bit)};
+            ASSERT_EQ(actual_bset.get_next_reset_bit(bit), expected) << "Next reset bit mismatch from " << bit;
+            if (expected == Bitset::npos) { break; }
+            bit = expected + 1;
+        } while (bit < expected_bset.size());
+
+        for (const uint32_t n : {1u, 5u, 64u, 200u}) {
+            uint64_t start{0};
+            while (start < expected_bset.size()) {
+                const auto expected{expected_bset.get_next_contiguous_n_reset_bits(start, n)};
+                const auto actual{actual_bset.get_next_contiguous_n_reset_bits(start, n)};
+                ASSERT_EQ(actual.start_bit, expected.start_bit) << "Contiguous n=" << n << " mismatch from " << start;
+                ASSERT_EQ(actual.nbits, expected.nbits) << "Contiguous n=" << n << " mismatch from " << start;
+                if (expected.nbits == 0) { break; }
+                start = expected.start_bit + expected.nbits;
+            }
+        }
+    }};
+
+    const auto run_test{[&](auto expected_bset, auto actual_bset) {
+        const uint64_t nbits{expected_bset.size()};
+        std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+        std::uniform_int_distribution< uint32_t > len_rand{1, 300};
+
+        expected_bset.set_bits(0, nbits);
+        actual_bset.set_bits(0, nbits);
+        validate(expected_bset, actual_bset);
+
+        for (uint32_t iter{0}; iter < 200; ++iter) {
+            const uint64_t bit{bit_rand(re)};
+            const uint32_t len{static_cast< uint32_t >(std::min< uint64_t >(len_rand(re), nbits - bit))};
+            if (iter % 3 == 0) {
+                expected_bset.reset_bits(bit, len);
+                actual_bset.reset_bits(bit, len);
+            } else {
+                expected_bset.set_bits(bit, len);
+                actual_bset.set_bits(bit, len);
+            }
+            if (iter % 50 == 0) { validate(expected_bset, actual_bset); }
+        }
+        validate(expected_bset, actual_bset);
+
+        // Serialized image carries no summary and loading can rebuild it
+        const auto levels{actual_bset.summary_levels()};
+        const auto buf{actual_bset.serialize(0, true)};
+        ASSERT_EQ(buf->size(), expected_bset.serialize(0, true)->size());
+        decltype(actual_bset) loaded_bset{buf, std::nullopt, levels};
+        ASSERT_EQ(loaded_bset.summary_levels(), levels);
+        validate(expected_bset, loaded_bset);
+
+        // Shifting the head and growing the tail rebuild the summary
+        expected_bset.shrink_head(Bitset::word_size() * 100 + 7);
+        actual_bset.shrink_head(Bitset::word_size() * 100 + 7);
+        expected_bset.resize(nbits * 2, true);
+        actual_bset.resize(nbits * 2, true);
+        expected_bset.reset_bit(nbits + 3);
+        actual_bset.reset_bit(nbits + 3);
+        validate(expected_bset, actual_bset);
+    }};
+
+    constexpr uint64_t nbits{static_cast< uint64_t >(64 * 64 * 64 * 3 + 100)};
+    for (uint8_t levels{1}; levels <= Bitset::max_summary_levels(); ++levels) {
+        run_test(Bitset{nbits}, Bitset{nbits, 0, 0, levels});
+        run_test(AtomicBitset{nbits}, AtomicBitset{nbits, 0, 0, levels});
+        run_test(ThreadSafeBitset{nbits}, ThreadSafeBitset{nbits, 0, 0, levels});
+    }
+}
+
+TEST_F(BitsetTest, ClaimContiguousResetBitsConcurrently) {
+    const auto run_test{[](auto& bset) {
+        const uint64_t nbits{bset.size()};
+        // Owner of each bit, used to detect two threads being handed the same bit at the same time
+        std::vector< std::atomic< uint32_t > > owners(nbits);
+        std::atomic< uint64_t > total_held{0};
+
+        std::vector< std::vector< BitBlock > > held_blocks(g_num_threads);
+        std::vector< std::thread > threads;
+        for (uint32_t t{0}; t < g_num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::random_device rd{};
+                std::default_random_engine re{rd()};
+                std::uniform_int_distribution< uint32_t > min_rand{1, 16};
+                std::uniform_int_distribution< uint32_t > extra_rand{0, 16};
+                std::uniform_int_distribution< uint64_t > start_rand{0, nbits - 1};
+                std::uniform_int_distribution< uint32_t > pct_rand{0, 99};
+                auto& my_blocks{held_blocks[t]};
+
+                for (uint32_t iter{0}; iter < 2000; ++iter) {
+                    if (!my_blocks.empty() && (pct_rand(re) < 40)) {
+                        // release a random block of our own
+                        const size_t idx{std::uniform_int_distribution< size_t >{0, my_blocks.size() - 1}(re)};
+                        const BitBlock b{my_blocks[idx]};
+                        my_blocks[idx] = my_blocks.back();
+                        my_blocks.pop_back();
+                        for (uint64_t bit{b.start_bit}; bit < b.start_bit + b.nbits; ++bit) {
+                            owners[bit].store(0);
+                        }
+                        bset.reset_bits(b.start_bit, b.nbits);
+                        total_held.fetch_sub(b.nbits);
+                        continue;
+                    }
+
+                    const uint32_t min_needed{min_rand(re)};
+                    const auto b{bset.claim_next_contiguous_n_reset_bits(start_rand(re) / 2, min_needed,
+                                                                         min_needed + extra_rand(re))};
+                    if (b.nbits == 0) { continue; }
+                    ASSERT_GE(b.nbits, min_needed);
+                    for (uint64_t bit{b.start_bit}; bit < b.start_bit + b.nbits; ++bit) {
+                        uint32_t expected_owner{0};
+                        ASSERT_TRUE(owners[bit].compare_exchange_strong(expected_owner, t + 1))
+                            << "Bit " << bit << " claimed by thread " << t << " is already owned by thread "
+                            << expected_owner - 1;
+                    }
+                    my_blocks.push_back(b);
+                    total_held.fetch_add(b.nbits);
+                }
+            });
+        }
+        for (auto& thr : threads) {
+            thr.join();
+        }
+
+        // Every held block is set, none of them overlap and nothing else is set
+        std::vector< BitBlock > all_blocks;
+        for (const auto& blocks : held_blocks) {
+            all_blocks.insert(all_blocks.end(), blocks.begin(), blocks.end());
+        }
+        std::sort(all_blocks.begin(), all_blocks.end(),
+                  [](const BitBlock& a, const BitBlock& b) { return a.start_bit < b.start_bit; });
+        for (size_t i{0}; i < all_blocks.size(); ++i) {
+            ASSERT_TRUE(bset.is_bits_set(all_blocks[i].start_bit, all_blocks[i].nbits));
+            if (i > 0) {
+                ASSERT_LE(all_blocks[i - 1].start_bit + all_blocks[i - 1].nbits, all_blocks[i].start_bit);
+            }
+        }
+        ASSERT_EQ(bset.get_set_count(), total_held.load());
+    }};
+
+    // Small enough that threads run out of space and contend for the same words
+    AtomicBitset abset{4096};
+    run_test(abset);
+    ThreadSafeBitset tbset{4096};
+    run_test(tbset);
+    AtomicBitset summary_bset{64 * 64 * 2, 0, 0, AtomicBitset::max_summary_levels()};
+    run_test(summary_bset);
+}
+
+TEST_F(BitsetTest, SnapshotCopyOnWrite) {
+    const uint64_t nbits{64 * 64 * 10 + 100};
+    ThreadSafeBitset bset{nbits, 7};
+    bset.shrink_head(3);
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, bset.size() - 1};
+    for (uint32_t i{0}; i < 500; ++i) {
+        const uint64_t start{bit_rand(re)};
+        bset.set_bits(start, std::min< uint64_t >(bit_rand(re) % 100 + 1, bset.size() - start));
+    }
+
+    // Expected contents of the snapshot, made with a deep copy
+    ThreadSafeBitset expected{};
+    expected.copy(bset);
+    const auto validate{[&expected](const ThreadSafeBitset::Snapshot& snap) {
+        ASSERT_EQ(snap.size(), expected.size());
+        ASSERT_EQ(snap.get_id(), 7u);
+        ASSERT_EQ(snap.get_set_count(), expected.get_set_count());
+        for (uint64_t bit{0}; bit < expected.size(); ++bit) {
+            ASSERT_EQ(snap.get_bitval(bit), expected.get_bitval(bit)) << "bit=" << bit;
+        }
+    }};
+
+    // Writers keep flipping bits all over while the snapshot is read
+    auto snap{bset.snapshot()};
+    auto snap2{bset.snapshot()};
+    std::vector< std::thread > threads;
+    for (uint32_t t{0}; t < g_num_threads; ++t) {
+        threads.emplace_back([&bset, nbits = bset.size(), t]() {
+            for (uint64_t bit{t}; bit < nbits; bit += 3) {
+                if (bset.get_bitval(bit)) {
+                    bset.reset_bit(bit);
+                } else {
+                    bset.set_bits(bit, 1);
+                }
+            }
+        });
+    }
+    validate(snap);
+    for (auto& thr : threads) {
+        thr.join();
+    }
+    validate(snap);
+    validate(snap2);
+
+    // Serialized snapshot loads as a bitset
+    const ThreadSafeBitset loaded{snap.serialize()};
+    ASSERT_EQ(loaded, expected);
+
+    // Snapshot outlives a resize of the bitset and the bitset itself
+    auto snap3{std::make_unique< ThreadSafeBitset::Snapshot >(bset.snapshot())};
+    ThreadSafeBitset expected3{};
+    expected3.copy(bset);
+    bset.resize(nbits * 2, true);
+    bset.reset_bits(0, 100);
+    ASSERT_EQ(ThreadSafeBitset{snap3->serialize()}, expected3);
+    auto snap4{bset.snapshot()};
+    {
+        ThreadSafeBitset expected4{};
+        expected4.copy(bset);
+        bset.reset_bits(0, bset.size());
+        bset.resize(0);
+        ASSERT_EQ(ThreadSafeBitset{snap4.serialize()}, expected4);
+    }
+    validate(snap2);
+}
+
+TEST_F(BitsetTest, BatchSetReset) {
+    const uint64_t nbits{64 * 64 * 8 + 77};
+    ThreadSafeBitset bset{nbits, 0, 0, ThreadSafeBitset::max_summary_levels()};
+    bset.enable_free_run_index();
+    Bitset shadow{nbits};
+
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+    std::uniform_int_distribution< uint32_t > len_rand{1, 300};
+    for (uint32_t round{0}; round < 30; ++round) {
+        const bool value{(round % 3) != 2};
+        // Unsorted, overlapping, adjacent and empty blocks
+        std::vector< BitBlock > blocks;
+        for (uint32_t i{0}; i < 100; ++i) {
+            const uint64_t start{bit_rand(re)};
+            const uint32_t len{static_cast< uint32_t >(std::min< uint64_t >(len_rand(re), nbits - start))};
+            blocks.emplace_back(start, len);
+            if (i % 7 == 0) { blocks.emplace_back(start, 0); }
+            if ((i % 5 == 0) && (start + len < nbits)) { blocks.emplace_back(start + len, 1); }
+        }
+        for (const auto& b : blocks) {
+            if (b.nbits == 0) { continue; }
+            if (value) {
+                shadow.set_bits(b.start_bit, b.nbits);
+            } else {
+                shadow.reset_bits(b.start_bit, b.nbits);
+            }
+        }
+        if (value) {
+            bset.set_bits_batch(blocks);
+        } else {
+            bset.reset_bits_batch(blocks);
+        }
+
+        ASSERT_EQ(bset.get_set_count(), shadow.get_set_count());
+        for (uint64_t bit{0}; bit < nbits; bit += 61) {
+            ASSERT_EQ(bset.get_next_reset_bit(bit), shadow.get_next_reset_bit(bit)) << "bit=" << bit;
+            ASSERT_EQ(bset.get_next_set_bit(bit), shadow.get_next_set_bit(bit)) << "bit=" << bit;
+        }
+        const auto largest{bset.get_largest_contiguous_reset_bits(0, nbits - 1)};
+        if (largest.nbits > 0) { ASSERT_TRUE(shadow.is_bits_reset(largest.start_bit, largest.nbits)); }
+    }
+
+    // Out of range blocks are rejected as a whole
+    const uint64_t count{bset.get_set_count()};
+    const std::vector< BitBlock > bad_blocks{{0, 64}, {nbits - 10, 11}};
+    ASSERT_THROW(bset.set_bits_batch(bad_blocks), std::out_of_range);
+    ASSERT_EQ(bset.get_set_count(), count);
+}
+
+TEST_F(BitsetTest, PrevSearches) {
+    const uint64_t nbits{64 * 64 * 4 + 99};
+    Bitset bset{nbits + 37, 0, 0, Bitset::max_summary_levels()};
+    bset.shrink_head(37);
+    ASSERT_EQ(bset.get_prev_set_bit(nbits), Bitset::npos);
+    ASSERT_EQ(bset.get_prev_reset_bit(nbits), nbits - 1);
+
+    // Mostly set with a few fully set summary groups, so that backward search skips over them
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+    bset.set_bits(0, nbits);
+    for (uint32_t i{0}; i < 150; ++i) {
+        const uint64_t bit{bit_rand(re)};
+        // Keep the actual words of groups 1 and 2 fully set
+        if (((bit + 37 + 7) >= (64 * 64)) && ((bit + 37) < (3 * 64 * 64))) { continue; }
+        bset.reset_bits(bit, std::min< uint64_t >(1 + bit % 7, nbits - bit));
+    }
+    bset.reset_bit(64 * 64 - 37 - 1); // Last bit of group 0, right below the skipped groups
+
+    // Backward search below takes the top n bits of each run, count how many such pieces are there
+    const uint32_t n{4};
+    uint64_t expected_pieces{0};
+    uint64_t prev_set{Bitset::npos};
+    uint64_t prev_reset{Bitset::npos};
+    uint64_t run_len{0};
+    for (uint64_t bit{0}; bit < nbits; ++bit) {
+        if (bset.get_bitval(bit)) {
+            prev_set = bit;
+            run_len = 0;
+        } else {
+            prev_reset = bit;
+            if ((++run_len % n) == 0) { ++expected_pieces; }
+        }
+        ASSERT_EQ(bset.get_prev_set_bit(bit), prev_set) << "bit=" << bit;
+        ASSERT_EQ(bset.get_prev_reset_bit(bit), prev_reset) << "bit=" << bit;
+        if (run_len >= 3) {
+            const auto b{bset.get_prev_contiguous_n_reset_bits(bit, 3)};
+            ASSERT_EQ(b.start_bit, bit - 2) << "bit=" << bit;
+            ASSERT_EQ(b.nbits, 3u);
+        }
+    }
+
+    // Search down to the lowest run of n bits and check nothing is missed on the way
+    uint64_t npieces{0};
+    for (uint64_t bit{nbits - 1};;) {
+        const auto b{bset.get_prev_contiguous_n_reset_bits(bit, std::nullopt, n, n)};
+        if (b.nbits == 0) {
+            ASSERT_EQ(b.start_bit, Bitset::npos);
+            break;
+        }
+        ASSERT_EQ(b.nbits, n);
+        ASSERT_LE(b.start_bit + b.nbits - 1, bit);
+        ASSERT_TRUE(bset.is_bits_reset(b.start_bit, b.nbits));
+        ++npieces;
+        if (b.start_bit == 0) { break; }
+        bit = b.start_bit - 1;
+    }
+    ASSERT_EQ(npieces, expected_pieces);
+
+    // Bounded below by end bit
+    ASSERT_EQ(bset.get_prev_contiguous_n_reset_bits(nbits - 1, nbits - 1, 2, 2).start_bit, Bitset::npos);
+}
+
+TEST_F(BitsetTest, FileBackedDirtyFlush) {
+    const auto run_test{[](auto* const dummy, auto* const mem_dummy) {
+        using BitsetType = std::remove_pointer_t< decltype(dummy) >;
+        using MemBitsetType = std::remove_pointer_t< decltype(mem_dummy) >;
+        const std::string path{(std::filesystem::temp_directory_path() /
+                                ("test_bitset_mapped_" + std::to_string(::getpid())))
+                                   .string()};
+        std::filesystem::remove(path);
+        const uint64_t nbits{1024 * 1024};
+        {
+            BitsetType bset{path, nbits, 5};
+            ASSERT_TRUE(bset.is_file_backed());
+            ASSERT_EQ(bset.size(), nbits);
+            ASSERT_GT(bset.flush_dirty(), 1u); // Newly created, entire file is written back
+            ASSERT_EQ(bset.dirty_page_count(), 0u);
+
+            // Few updates clustered together should only dirty the pages they fall in
+            bset.set_bits(1000, 100);
+            bset.set_bit(nbits - 1);
+            bset.reset_bit(1010);
+            ASSERT_EQ(bset.dirty_page_count(), 2u);
+            ASSERT_EQ(bset.flush_dirty(), 2u);
+            ASSERT_EQ(bset.flush_dirty(), 0u);
+
+            if constexpr (std::is_same_v< BitsetType, FileBackedBitset >) {
+                bset.set_bits(0, 64);
+            } else {
+                auto b{bset.claim_next_contiguous_n_reset_bits(0, 64, 64)};
+                ASSERT_EQ(b.nbits, 64u);
+            }
+            ASSERT_EQ(bset.dirty_page_count(), 1u);
+            bset.set_id(7);
+            ASSERT_EQ(bset.flush_dirty(), 1u);
+
+            // It cannot be shared, only copied into an independent in memory bitset
+            static_assert(!std::is_copy_constructible_v< BitsetType > && !std::is_copy_assignable_v< BitsetType >);
+            static_assert(!std::is_constructible_v< MemBitsetType, const BitsetType& > &&
+                          !std::is_assignable_v< MemBitsetType&, const BitsetType& >);
+            MemBitsetType copied{1};
+            copied.copy(bset);
+            ASSERT_FALSE(copied.is_file_backed());
+            ASSERT_EQ(copied, bset);
+            copied.set_bit(2000);
+            ASSERT_FALSE(bset.get_bitval(2000));
+            ASSERT_EQ(bset.dirty_page_count(), 0u);
+        }
+        {
+            // Reopen and the bitset is as it was
+            BitsetType bset{path};
+            ASSERT_EQ(bset.get_id(), 7u);
+            ASSERT_EQ(bset.size(), nbits);
+            ASSERT_EQ(bset.get_set_count(), 99u + 1u + 64u);
+            ASSERT_TRUE(bset.is_bits_set(1000, 10));
+            ASSERT_FALSE(bset.get_bitval(1010));
+            ASSERT_TRUE(bset.is_bits_set(1011, 89));
+            ASSERT_TRUE(bset.get_bitval(nbits - 1));
+
+            // Resize rewrites the entire file into a new mapping
+            bset.resize(nbits * 2, true);
+            ASSERT_TRUE(bset.is_file_backed());
+            ASSERT_GT(bset.dirty_page_count(), 2u);
+            bset.flush_dirty();
+            bset.reset_bits(nbits, 10);
+            bset.shrink_head(64);
+            bset.flush_dirty();
+        }
+        {
+            // The size and id asked for must match the ones in the file
+            ASSERT_THROW(BitsetType(path, nbits), std::invalid_argument);
+            ASSERT_THROW(BitsetType(path, std::nullopt, 5), std::invalid_argument);
+            BitsetType bset{path, nbits * 2 - 64, 7, BitsetType::max_summary_levels()};
+            ASSERT_EQ(bset.size(), nbits * 2 - 64);
+            ASSERT_EQ(bset.get_set_count(), 99u + 1u + nbits - 10u);
+            ASSERT_TRUE(bset.is_bits_reset(nbits - 64, 10));
+            ASSERT_TRUE(bset.get_bitval(nbits - 65));
+            ASSERT_EQ(bset.get_next_reset_bit(nbits - 65), nbits - 64);
+        }
+        std::filesystem::remove(path);
+
+        // Larger than the 32 bit buffer size, which is refused instead of being truncated
+        ASSERT_THROW(BitsetType(path, uint64_t{1} << 35), std::length_error);
+        std::filesystem::remove(path);
+    }};
+
+    run_test(static_cast< FileBackedBitset* >(nullptr), static_cast< Bitset* >(nullptr));
+    run_test(static_cast< FileBackedAtomicBitset* >(nullptr), static_cast< AtomicBitset* >(nullptr));
+    run_test(static_cast< FileBackedThreadSafeBitset* >(nullptr), static_cast< ThreadSafeBitset* >(nullptr));
+}
+
+TEST_F(BitsetTest, BitwiseOpsAllISA) {
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint32_t > pct_rand{0, 99};
+
+    // lhs and rhs of different sizes and different shrink_head offsets, validated bit by bit
+    const auto run_test{[&pct_rand](auto* const dummy, const uint64_t lhs_shift, const uint64_t rhs_shift) {
+        using BitsetType = std::remove_pointer_t< decltype(dummy) >;
+        const uint64_t lhs_bits{BitsetType::word_size() * 700 + 13};
+        const uint64_t rhs_bits{BitsetType::word_size() * 650 + 41};
+        const auto make{[&pct_rand](const uint64_t nbits, const uint64_t shift) {
+            BitsetType bset{nbits + shift, 0, 0, BitsetType::max_summary_levels()};
+            for (uint64_t bit{0}; bit < bset.size(); ++bit) {
+                if (pct_rand(re) < 50) { bset.set_bit(bit); }
+            }
+            // A run of fully set words so that the summary gets involved
+            bset.set_bits(shift + BitsetType::word_size() * 64, BitsetType::word_size() * 200);
+            bset.shrink_head(shift);
+            return bset;
+        }};
+        const BitsetType rhs{make(rhs_bits, rhs_shift)};
+        const BitsetType orig{make(lhs_bits, lhs_shift)};
+        const uint64_t nbits{std::min(lhs_bits, rhs_bits)};
+
+        uint64_t and_count{0};
+        uint64_t andnot_count{0};
+        for (uint64_t bit{0}; bit < nbits; ++bit) {
+            if (orig.get_bitval(bit) && rhs.get_bitval(bit)) { ++and_count; }
+            if (orig.get_bitval(bit) && !rhs.get_bitval(bit)) { ++andnot_count; }
+        }
+        ASSERT_EQ(orig.popcount_of_and(rhs), and_count);
+        ASSERT_EQ(orig.popcount_of_andnot(rhs), andnot_count);
+
+        for (const auto op : {bitwise_op::and_with, bitwise_op::or_with, bitwise_op::xor_with,
+                              bitwise_op::andnot_with}) {
+            BitsetType lhs{lhs_bits + lhs_shift, 0, 0, BitsetType::max_summary_levels()};
+            lhs.shrink_head(lhs_shift);
+            lhs.copy(orig);
+            switch (op) {
+            case bitwise_op::and_with:
+                lhs.and_with(rhs);
+                break;
+            case bitwise_op::or_with:
+                lhs.or_with(rhs);
+                break;
+            case bitwise_op::xor_with:
+                lhs.xor_with(rhs);
+                break;
+            case bitwise_op::andnot_with:
+                lhs.andnot_with(rhs);
+                break;
+            }
+
+            for (uint64_t bit{0}; bit < lhs_bits; ++bit) {
+                bool expected{orig.get_bitval(bit)};
+                if (bit < nbits) {
+                    const bool r{rhs.get_bitval(bit)};
+                    expected = (op == bitwise_op::and_with)  ? (expected && r)
+                        : (op == bitwise_op::or_with)        ? (expected || r)
+                        : (op == bitwise_op::xor_with)       ? (expected != r)
+                                                             : (expected && !r);
+                }
+                ASSERT_EQ(lhs.get_bitval(bit), expected)
+                    << "op=" << enum_name(op) << " bit=" << bit << " lhs_shift=" << lhs_shift
+                    << " rhs_shift=" << rhs_shift;
+            }
+
+            // Summary is kept coherent with the new words
+            uint64_t expected_reset{orig.npos};
+            for (uint64_t bit{0}; bit < lhs_bits; ++bit) {
+                if (!lhs.get_bitval(bit)) {
+                    expected_reset = bit;
+                    break;
+                }
+            }
+            ASSERT_EQ(lhs.get_next_reset_bit(0), expected_reset) << "op=" << enum_name(op);
+        }
+
+        BitsetType self{orig};
+        self.xor_with(self);
+        ASSERT_EQ(self.get_set_count(), 0u);
+    }};
+
+    const auto orig_isa{bitset_simd::active_isa()};
+    for (const auto isa : {bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512}) {
+        if (!bitset_simd::set_active_isa(isa)) {
+            LOGINFO("ISA {} is not supported on this cpu, skipping", enum_name(isa));
+            continue;
+        }
+        for (const auto& [lhs_shift, rhs_shift] : std::vector< std::pair< uint64_t, uint64_t > >{
+                 {0, 0}, {64, 128}, {0, 7}, {13, 0}, {13, 13}, {5, 70}}) {
+            run_test(static_cast< Bitset* >(nullptr), lhs_shift, rhs_shift);
+            run_test(static_cast< AtomicBitset* >(nullptr), lhs_shift, rhs_shift);
+        }
+    }
+    bitset_simd::set_active_isa(orig_isa);
+}
+
+TEST_F(BitsetTest, DeltaSerializeAllISA) {
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+
+    // Base and current of different sizes and shrink_head offsets, current has a few clustered changes over base
+    const auto run_test{[](auto* const dummy, const uint64_t base_bits, const uint64_t cur_bits, const uint64_t shift) {
+        using BitsetType = std::remove_pointer_t< decltype(dummy) >;
+        std::uniform_int_distribution< uint64_t > bit_rand{0, cur_bits - 1};
+        BitsetType base{base_bits + shift};
+        for (uint64_t bit{0}; bit < base.size(); bit += 3) {
+            base.set_bit(bit);
+        }
+        base.shrink_head(shift);
+
+        BitsetType cur{base.serialize(std::nullopt, true)};
+        cur.resize(cur_bits);
+        for (uint32_t i{0}; i < 20; ++i) {
+            const uint64_t bit{bit_rand(re)};
+            const uint64_t nbits{std::min< uint64_t >(cur_bits - bit, 1 + (bit % 150))};
+            if (i % 2 == 0) {
+                cur.set_bits(bit, nbits);
+            } else {
+                cur.reset_bits(bit, nbits);
+            }
+        }
+        cur.set_id(99);
+
+        const auto delta{cur.serialize_delta(base)};
+        ASSERT_LT(delta->size(), cur.serialize()->size() / 4);
+
+        BitsetType replica{base.serialize(std::nullopt, true), std::nullopt, BitsetType::max_summary_levels()};
+        replica.apply_delta(delta);
+        ASSERT_EQ(replica.size(), cur_bits);
+        ASSERT_EQ(replica.get_id(), 99u);
+        for (uint64_t bit{0}; bit < cur_bits; ++bit) {
+            ASSERT_EQ(replica.get_bitval(bit), cur.get_bitval(bit))
+                << "bit=" << bit << " base_bits=" << base_bits << " cur_bits=" << cur_bits << " shift=" << shift;
+        }
+
+        // Summary is kept coherent with the new words
+        uint64_t expected_reset{cur.get_next_reset_bit(0)};
+        ASSERT_EQ(replica.get_next_reset_bit(0), expected_reset);
+
+        // No change gives an empty delta and a delta cannot be applied to a bitset of some other size
+        const auto empty_delta{cur.serialize_delta(replica)};
+        replica.apply_delta(empty_delta);
+        ASSERT_EQ(replica, cur);
+        if (base_bits != cur_bits) { ASSERT_THROW(replica.apply_delta(delta), std::runtime_error); }
+    }};
+
+    const auto orig_isa{bitset_simd::active_isa()};
+    for (const auto isa : {bitset_isa::scalar, bitset_isa::avx2, bitset_isa::avx512}) {
+        if (!bitset_simd::set_active_isa(isa)) {
+            LOGINFO("ISA {} is not supported on this cpu, skipping", enum_name(isa));
+            continue;
+        }
+        for (const uint64_t shift : {0, 64, 13}) {
+            for (const auto& [base_bits, cur_bits] : std::vector< std::pair< uint64_t, uint64_t > >{
+                     {64 * 1000, 64 * 1000}, {64 * 1000 + 13, 64 * 1200 + 7}, {64 * 1200 + 7, 64 * 1000 + 13}}) {
+                run_test(static_cast< Bitset* >(nullptr), base_bits, cur_bits, shift);
+                run_test(static_cast< ThreadSafeBitset* >(nullptr), base_bits, cur_bits, shift);
+            }
+        }
+    }
+    bitset_simd::set_active_isa(orig_isa);
+}
+
+TEST_F(BitsetTest, ParallelScans) {
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+
+    // Large enough to be split into multiple parts, with runs of set bits crossing the part boundaries
+    const auto run_test{[](auto* const dummy, const uint64_t shift) {
+        using BitsetType = std::remove_pointer_t< decltype(dummy) >;
+        const uint64_t nbits{BitsetType::word_size() * 16 * 1024 * 5 + 37};
+        std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+        std::uniform_int_distribution< uint32_t > len_rand{1, 300};
+        BitsetType bset{nbits + shift};
+        bset.shrink_head(shift);
+        for (uint32_t i{0}; i < 20000; ++i) {
+            const uint64_t bit{bit_rand(re)};
+            bset.set_bits(bit, std::min< uint64_t >(len_rand(re), nbits - bit));
+        }
+        bset.set_bits(BitsetType::word_size() * 16 * 1024 - 100, BitsetType::word_size() * 16 * 1024 * 2);
+        bset.set_bits(nbits - 10, 10);
+
+        // Expected runs by searching the next set and reset bits
+        std::vector< std::pair< uint64_t, uint64_t > > expected;
+        for (uint64_t bit{bset.get_next_set_bit(0)}; bit != BitsetType::npos;) {
+            const uint64_t end{bset.get_next_reset_bit(bit)};
+            expected.emplace_back(bit, ((end == BitsetType::npos) ? nbits : end) - bit);
+            bit = (end == BitsetType::npos) ? BitsetType::npos : bset.get_next_set_bit(end);
+        }
+
+        std::vector< std::pair< uint64_t, uint64_t > > serial;
+        bset.foreach_set_range([&serial](const uint64_t start, const uint64_t n) { serial.emplace_back(start, n); });
+        ASSERT_EQ(serial, expected);
+
+        const auto executor{bitset_thread_executor()};
+        for (const uint32_t nparts : {1u, 2u, 3u, 8u}) {
+            ASSERT_EQ(bset.get_set_count(executor, nparts), bset.get_set_count()) << "nparts=" << nparts;
+            ASSERT_EQ(bset.get_set_count(executor, nparts, 1000, nbits - 1000), bset.get_set_count(1000, nbits - 1000))
+                << "nparts=" << nparts;
+
+            std::mutex mtx;
+            std::vector< std::pair< uint64_t, uint64_t > > runs;
+            bset.foreach_set_range(executor, nparts, [&mtx, &runs](const uint64_t start, const uint64_t n) {
+                std::unique_lock lg{mtx};
+                runs.emplace_back(start, n);
+            });
+            std::sort(std::begin(runs), std::end(runs));
+            ASSERT_EQ(runs, expected) << "nparts=" << nparts << " shift=" << shift;
+
+            const auto extents{bset.to_extents(executor, nparts)};
+            ASSERT_EQ(extents.size(), expected.size());
+            for (size_t i{0}; i < extents.size(); ++i) {
+                ASSERT_EQ(extents[i].start_bit, expected[i].first);
+                ASSERT_EQ(extents[i].nbits, expected[i].second);
+            }
+        }
+        ASSERT_EQ(bset.to_extents().size(), expected.size());
+    }};
+
+    for (const uint64_t shift : {0, 13}) {
+        run_test(static_cast< Bitset* >(nullptr), shift);
+        run_test(static_cast< ThreadSafeBitset* >(nullptr), shift);
+    }
+}
+
+TEST_F(BitsetTest, RunRanges) {
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+
+    const auto run_test{[](auto* const dummy, const uint64_t nbits, const uint64_t shift) {
+        using BitsetType = std::remove_pointer_t< decltype(dummy) >;
+        std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+        std::uniform_int_distribution< uint32_t > len_rand{1, 200};
+        BitsetType bset{nbits + shift};
+        bset.shrink_head(shift);
+        for (uint32_t i{0}; i < nbits / 300; ++i) {
+            const uint64_t bit{bit_rand(re)};
+            bset.set_bits(bit, std::min< uint64_t >(len_rand(re), nbits - bit));
+        }
+
+        // Expected runs of either value from the bit values
+        std::vector< std::pair< uint64_t, uint64_t > > expected[2];
+        for (uint64_t bit{0}; bit < nbits; ++bit) {
+            const bool val{bset.get_bitval(bit)};
+            auto& runs{expected[val ? 1 : 0]};
+            if (!runs.empty() && ((runs.back().first + runs.back().second) == bit)) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(bit, 1);
+            }
+        }
+
+        const auto collect{[](const auto& range) {
+            std::vector< std::pair< uint64_t, uint64_t > > runs;
+            for (const auto& b : range) {
+                runs.emplace_back(b.start_bit, b.nbits);
+            }
+            return runs;
+        }};
+        ASSERT_EQ(collect(bset.set_runs()), expected[1]) << "nbits=" << nbits << " shift=" << shift;
+        ASSERT_EQ(collect(bset.reset_runs()), expected[0]) << "nbits=" << nbits << " shift=" << shift;
+        ASSERT_EQ(collect(bset.set_runs_unlocked()), expected[1]);
+        ASSERT_EQ(collect(bset.reset_runs_unlocked()), expected[0]);
+
+        const auto range{bset.set_runs()};
+        ASSERT_EQ(static_cast< size_t >(std::distance(range.begin(), range.end())), expected[1].size());
+    }};
+
+    for (const uint64_t nbits : {1, 63, 64, 1000, 10000}) {
+        for (const uint64_t shift : {0, 13}) {
+            run_test(static_cast< Bitset* >(nullptr), nbits, shift);
+            run_test(static_cast< ThreadSafeBitset* >(nullptr), nbits, shift);
+        }
+    }
+
+    // Entirely set and entirely reset bitsets are a single run
+    ThreadSafeBitset bset{1000};
+    {
+        const auto set_range{bset.set_runs()};
+        ASSERT_EQ(set_range.begin(), set_range.end());
+        ASSERT_EQ(bset.reset_runs_unlocked().begin()->nbits, 1000u);
+    }
+    bset.set_bits(0, 1000);
+    {
+        const auto reset_range{bset.reset_runs()};
+        ASSERT_EQ(reset_range.begin(), reset_range.end());
+        const auto set_range{bset.set_runs_unlocked()};
+        ASSERT_EQ(set_range.begin()->start_bit, 0u);
+        ASSERT_EQ(set_range.begin()->nbits, 1000u);
+    }
+}
+
+TEST_F(BitsetTest, BestFitAndLargestReset) {
+    static thread_local std::random_device rd{};
+    static thread_local std::default_random_engine re{rd()};
+
+    // Expected answers by walking every bit
+    const auto reset_runs{[](const auto& bset, const uint64_t start, const uint64_t end) {
+        std::vector< std::pair< uint64_t, uint64_t > > runs;
+        for (uint64_t bit{start}; bit <= end; ++bit) {
+            if (bset.get_bitval(bit)) { continue; }
+            if (!runs.empty() && (runs.back().first + runs.back().second == bit)) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(bit, 1);
+            }
+        }
+        return runs;
+    }};
+
+    const auto validate{[&reset_runs](const auto& bset, const uint64_t start, const uint64_t end) {
+        const auto runs{reset_runs(bset, start, end)};
+        std::pair< uint64_t, uint64_t > largest{Bitset::npos, 0};
+        std::array< uint64_t, 64 > histogram{};
+        for (const auto& r : runs) {
+            if (r.second > largest.second) { largest = r; }
+            ++histogram[logBase2(r.second)];
+        }
+        const auto b{bset.get_largest_contiguous_reset_bits(start, end)};
+        ASSERT_EQ(b.start_bit, largest.first) << "start=" << start << " end=" << end;
+        ASSERT_EQ(b.nbits, largest.second);
+        ASSERT_EQ(bset.get_free_run_histogram(start, end), histogram);
+
+        for (const uint32_t n : {1u, 2u, 7u, 64u, 100u, 1000u, 5000u}) {
+            std::pair< uint64_t, uint64_t > best{Bitset::npos, 0};
+            for (const auto& r : runs) {
+                if ((r.second >= n) && ((best.second == 0) || (r.second < best.second))) { best = r; }
+            }
+            const auto fit{bset.get_best_fit_contiguous_reset_bits(n, start, end)};
+            ASSERT_EQ(fit.nbits, best.second) << "n=" << n << " start=" << start << " end=" << end;
+            // Exact fit can return any of the runs of size n, others have to be the lowest one
+            if (best.second == n) {
+                ASSERT_TRUE(bset.is_bits_reset(fit.start_bit, n) &&
+                            ((fit.start_bit == start) || bset.get_bitval(fit.start_bit - 1)));
+            } else {
+                ASSERT_EQ(fit.start_bit, best.first) << "n=" << n;
+            }
+        }
+    }};
+
+    const uint64_t nbits{Bitset::word_size() * 64 * 9 + 37};
+    std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+    std::uniform_int_distribution< uint64_t > len_rand{1, 3000};
+    for (const bool indexed : {false, true}) {
+        ThreadSafeBitset bset{nbits};
+        if (indexed) { bset.enable_free_run_index(); }
+        ASSERT_EQ(bset.is_free_run_index_enabled(), indexed);
+        validate(bset, 0, bset.size() - 1);
+
+        for (uint32_t round{0}; round < 5; ++round) {
+            bset.set_bits(0, bset.size());
+            for (uint32_t i{0}; i < 40; ++i) {
+                const uint64_t start{bit_rand(re) % bset.size()};
+                bset.reset_bits(start, std::min(len_rand(re), bset.size() - start));
+            }
+            for (uint32_t i{0}; i < 200; ++i) {
+                bset.set_bit(bit_rand(re) % bset.size());
+            }
+            validate(bset, 0, bset.size() - 1);
+            const uint64_t start{bit_rand(re) % bset.size()};
+            validate(bset, start, std::min(start + len_rand(re) * 5, bset.size() - 1));
+            bset.shrink_head(77);
+        }
+        // Segments fully reset stitch into one run across them
+        bset.reset_bits(0, bset.size());
+        validate(bset, 0, bset.size() - 1);
+        bset.resize(bset.size() + 1000, false);
+        validate(bset, 0, bset.size() - 1);
+    }
+}
+
 TEST_F(BitsetTest, EqualityLogicCheck) {
     // flip random bits
     const auto flip_random_bits{[this](auto& tmp_bitset, const size_t num_bits, const size_t num_flips) {
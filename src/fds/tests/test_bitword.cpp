@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <iostream>
 #include <limits>
+#include <random>
 #include <type_traits>
 
 #include <sisl/logging/logging.h>
@@ -325,6 +326,50 @@ TEST_F(BitwordTest, GetNextResetBitsFiltered) {
     ASSERT_TRUE(validate(0x00ff0f0f0f0ff0f4, 0, {3, 9, 9}, 0, bit_match_type::no_match, 0));
 }
 
+TEST_F(BitwordTest, GetNextResetBitsFilteredBMI2) {
+    if (!bitset_simd::set_bmi2_enabled(true)) {
+        LOGINFO("BMI2 not supported on this cpu, skipping");
+        return;
+    }
+
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > word_rand{};
+    std::uniform_int_distribution< uint32_t > offset_rand{0, 63};
+    std::uniform_int_distribution< uint32_t > reqd_rand{0, 70};
+
+    const auto same{[](const bit_match_result& r1, const bit_match_result& r2) {
+        return (r1.match_type == r2.match_type) && (r1.start_bit == r2.start_bit) && (r1.count == r2.count);
+    }};
+    for (uint32_t i{0}; i < 100000; ++i) {
+        // Mix of random, sparse and dense words, so that all the run lengths show up
+        uint64_t val{word_rand(re)};
+        if (i % 3 == 1) {
+            val &= word_rand(re) & word_rand(re);
+        } else if (i % 3 == 2) {
+            val |= word_rand(re) | word_rand(re);
+        }
+        const Bitword< safe_bits< uint64_t > > bword{val};
+        const uint8_t offset{static_cast< uint8_t >((i % 2) ? 0 : offset_rand(re))};
+        const bit_filter filter{reqd_rand(re), reqd_rand(re), reqd_rand(re)};
+
+        const auto exp{bword.get_next_reset_bits_filtered_generic(offset, filter.n_lsb_reqd, filter.n_mid_reqd,
+                                                                  filter.n_msb_reqd)};
+        const auto result{bword.get_next_reset_bits_filtered(offset, filter)};
+        ASSERT_TRUE(same(result, exp)) << "val=" << val << " offset=" << static_cast< uint32_t >(offset)
+                                       << " filter=" << filter.to_string() << " expected=" << exp.to_string()
+                                       << " got=" << result.to_string();
+
+        const auto single{bword.get_next_reset_bits_filtered< 1, 1, 1 >(offset)};
+        ASSERT_TRUE(same(single, bword.get_next_reset_bits_filtered_generic(offset, 1, 1, 1))) << "val=" << val;
+        const auto full{bword.get_next_reset_bits_filtered< 64, 64, 1 >(offset)};
+        ASSERT_TRUE(same(full, bword.get_next_reset_bits_filtered_generic(offset, 64, 64, 1))) << "val=" << val;
+    }
+    ASSERT_TRUE(bitset_simd::set_bmi2_enabled(false));
+    ASSERT_TRUE(validate(0x7ff000ffff00ff0f, 5, {8, 8, 1}, 16, bit_match_type::mid_match, 8));
+    ASSERT_TRUE(bitset_simd::set_bmi2_enabled(true));
+}
+
 TEST_F(BitwordTest, GetMaxContiguousResetBits) {
     uint8_t pmax_count;
     const Bitword< unsafe_bits< uint64_t > > word1{0xFFFFFFFFFFFFFFFF};
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <boost/dynamic_bitset.hpp>
 #include <random>
+#include <vector>
 
 #include <sisl/logging/logging.h>
 #include <sisl/options/options.h>
@@ -94,6 +95,132 @@ TEST_F(CompactBitsetTest, AllBits) {
     }
 }
 
+TEST_F(CompactBitsetTest, BatchSetReset) {
+    auto const num_bits = m_bset->size();
+    boost::dynamic_bitset<> shadow_bset{num_bits};
+
+    std::random_device rd;
+    std::mt19937 re(rd());
+    std::uniform_int_distribution< CompactBitSet::bit_count_t > bit_gen(0, num_bits - 1);
+    std::uniform_int_distribution< uint32_t > len_gen(1, 200);
+    for (uint32_t round{0}; round < 20; ++round) {
+        bool const value = (round % 3) != 2;
+        // Unsorted, overlapping and adjacent blocks
+        std::vector< BitBlock > blocks;
+        for (uint32_t i{0}; i < 64; ++i) {
+            auto const start = bit_gen(re);
+            auto const nbits = std::min(len_gen(re), num_bits - start);
+            blocks.emplace_back(start, nbits);
+            if (i % 8 == 0) { blocks.emplace_back(start + nbits, 0); }
+            if ((i % 5 == 0) && (start + nbits < num_bits)) { blocks.emplace_back(start + nbits, 1); }
+        }
+        for (auto const& b : blocks) {
+            for (uint64_t bit{b.start_bit}; bit < b.start_bit + b.nbits; ++bit) {
+                shadow_bset[bit] = value;
+            }
+        }
+        if (value) {
+            m_bset->set_bits_batch(blocks);
+        } else {
+            m_bset->reset_bits_batch(blocks);
+        }
+        for (CompactBitSet::bit_count_t i{0}; i < num_bits; ++i) {
+            ASSERT_EQ(m_bset->is_bit_set(i), shadow_bset[i]) << "bit=" << i;
+        }
+    }
+}
+
+TEST_F(CompactBitsetTest, RangeOps) {
+    auto const num_bits = m_bset->size();
+    boost::dynamic_bitset<> shadow_bset{num_bits};
+
+    std::random_device rd;
+    std::mt19937 re(rd());
+    std::uniform_int_distribution< CompactBitSet::bit_count_t > bit_gen(0, num_bits - 1);
+    std::uniform_int_distribution< uint32_t > len_gen(1, 200);
+    for (uint32_t i{0}; i < 200; ++i) {
+        bool const value = (i % 2) == 0;
+        auto const start = bit_gen(re);
+        auto const nbits = std::min(len_gen(re), num_bits - start);
+        for (uint64_t bit{start}; bit < start + nbits; ++bit) {
+            shadow_bset[bit] = value;
+        }
+        if (value) {
+            m_bset->set_bits(start, nbits);
+        } else {
+            m_bset->reset_bits(start, nbits);
+        }
+    }
+    for (CompactBitSet::bit_count_t i{0}; i < num_bits; ++i) {
+        ASSERT_EQ(m_bset->is_bit_set(i), shadow_bset[i]) << "bit=" << i;
+    }
+
+    // Range counts against a running count of the shadow
+    std::vector< CompactBitSet::bit_count_t > counts(num_bits + 1, 0);
+    for (CompactBitSet::bit_count_t i{0}; i < num_bits; ++i) {
+        counts[i + 1] = counts[i] + (shadow_bset[i] ? 1 : 0);
+    }
+    ASSERT_EQ(m_bset->count_set_bits(0), shadow_bset.count());
+    for (uint32_t i{0}; i < 1000; ++i) {
+        auto const start = bit_gen(re);
+        auto const end = std::min(start + len_gen(re) * 3, num_bits - 1);
+        ASSERT_EQ(m_bset->count_set_bits(start, end), counts[end + 1] - counts[start])
+            << "start=" << start << " end=" << end;
+    }
+
+    // Contiguous search against the first run of n reset bits in the shadow
+    for (uint32_t const n : {1u, 3u, 17u, 64u, 100u, 250u}) {
+        for (CompactBitSet::bit_count_t start{0}; start < num_bits; start += 7) {
+            CompactBitSet::bit_count_t expected{CompactBitSet::inval_bit};
+            uint32_t run_len{0};
+            for (CompactBitSet::bit_count_t bit{start}; bit < num_bits; ++bit) {
+                run_len = shadow_bset[bit] ? 0 : run_len + 1;
+                if (run_len == n) {
+                    expected = bit - n + 1;
+                    break;
+                }
+            }
+            auto const b = m_bset->get_next_contiguous_n_reset_bits(start, n);
+            ASSERT_EQ(b.start_bit, expected) << "start=" << start << " n=" << n;
+            ASSERT_EQ(b.nbits, (expected == CompactBitSet::inval_bit) ? 0 : n);
+        }
+    }
+}
+
+TEST_F(CompactBitsetTest, PrevSearches) {
+    auto const num_bits = m_bset->size();
+    std::random_device rd;
+    std::mt19937 re(rd());
+    std::uniform_int_distribution< CompactBitSet::bit_count_t > bit_gen(0, num_bits - 1);
+    for (uint64_t i{0}; i < num_bits / 3; ++i) {
+        m_bset->set_bit(bit_gen(re));
+    }
+
+    CompactBitSet::bit_count_t prev_set_bit{CompactBitSet::inval_bit};
+    CompactBitSet::bit_count_t prev_reset_bit{CompactBitSet::inval_bit};
+    uint32_t run_len{0};
+    for (CompactBitSet::bit_count_t i{0}; i < num_bits; ++i) {
+        if (m_bset->is_bit_set(i)) {
+            prev_set_bit = i;
+            run_len = 0;
+        } else {
+            prev_reset_bit = i;
+            ++run_len;
+        }
+        ASSERT_EQ(m_bset->get_prev_set_bit(i), prev_set_bit) << "bit=" << i;
+        ASSERT_EQ(m_bset->get_prev_reset_bit(i), prev_reset_bit) << "bit=" << i;
+        auto const b = m_bset->get_prev_contiguous_n_reset_bits(i, 3);
+        if (run_len >= 3) {
+            ASSERT_EQ(b.start_bit, i - 2) << "bit=" << i;
+        } else if (b.nbits > 0) {
+            ASSERT_LT(b.start_bit + 2, i - run_len) << "bit=" << i;
+            for (uint32_t n{0}; n < 3; ++n) {
+                ASSERT_FALSE(m_bset->is_bit_set(s_cast< CompactBitSet::bit_count_t >(b.start_bit + n)));
+            }
+        }
+    }
+}
+
 TEST_F(CompactBitsetTest, RandomBitsWithReload) {
     auto const num_bits = m_bset->size();
     boost::dynamic_bitset<> shadow_bset{num_bits};
@@ -14,7 +14,10 @@
  * specific language governing permissions and limitations under the License.
  *
  *********************************************************************************/
+#include <algorithm>
 #include <cstdint>
+#include <functional>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -27,68 +30,139 @@
 
 using namespace sisl;
 
-SISL_LOGGING_INIT(test_bitset);
+SISL_LOGGING_INIT(test_id_reserver)
 
 SISL_OPTIONS_ENABLE(logging, test_id_reserver)
 
 SISL_OPTION_GROUP(test_id_reserver,
-                 (num_threads, "", "num_threads", "number of threads",
-                  ::cxxopts::value< uint32_t >()->default_value("8"), "number"),
-                 (max_ids, "", "max_ids", "maximum number of ids",
-                  ::cxxopts::value< uint32_t >()->default_value("1000"), "number"),
+                  (num_threads, "", "num_threads", "number of threads",
+                   ::cxxopts::value< uint32_t >()->default_value("8"), "number"),
+                  (max_ids, "", "max_ids", "maximum number of ids",
+                   ::cxxopts::value< uint32_t >()->default_value("10000"), "number"))
 
 namespace {
-    uint32_t g_max_ids;
-    uint32_t g_num_threads;
+uint32_t g_max_ids;
+uint32_t g_num_threads;
+
+// Runs thr_fn(thread_num, n_ids_this_thread) on all the threads, splitting the max ids among them
+void run_parallel(const std::function< void(uint32_t, uint32_t) >& thr_fn) {
+    std::vector< std::thread > threads;
+    const uint32_t n_per_thread{(g_max_ids + g_num_threads - 1) / g_num_threads};
+    for (uint32_t t{0}; t < g_num_threads; ++t) {
+        threads.emplace_back(thr_fn, t, std::min(n_per_thread, g_max_ids - std::min(g_max_ids, t * n_per_thread)));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
 
-    void run_parallel(uint32_t nthreads, const std::function< void(uint32_t) >& thr_fn) {
-        std::vector< std::thread > threads;
-        auto n_per_thread = std::ceil((double)g_max_ids / nthreads);
-        int32_t remain_ids = (int32_t)g_max_ids;
+std::set< uint32_t > reserved_ids(IDReserver& reserver) {
+    std::set< uint32_t > ids;
+    uint32_t id;
+    if (reserver.first_reserved_id(id)) {
+        do {
+            ids.insert(id);
+        } while (reserver.next_reserved_id(id));
+    }
+    return ids;
+}
 
-        while (remain_ids > 0) {
-            threads.emplace_back(thr_fn, std::min(remain_ids, (int32_t)n_per_thread));
-            remain_ids -= n_per_thread;
+struct IDReserverTest : public testing::Test {
+public:
+    IDReserverTest() : testing::Test() {}
+    IDReserverTest(const IDReserverTest&) = delete;
+    IDReserverTest(IDReserverTest&&) noexcept = delete;
+    IDReserverTest& operator=(const IDReserverTest&) = delete;
+    IDReserverTest& operator=(IDReserverTest&&) noexcept = delete;
+    virtual ~IDReserverTest() override = default;
+
+protected:
+    IDReserver m_reserver{64};
+};
+} // namespace
+
+TEST_F(IDReserverTest, ConcurrentReserve) {
+    std::vector< std::vector< uint32_t > > thread_ids(g_num_threads);
+    run_parallel([this, &thread_ids](const uint32_t t, const uint32_t n_ids_this_thread) {
+        auto& ids{thread_ids[t]};
+        for (uint32_t i{0}; i < n_ids_this_thread; ++i) {
+            ids.push_back(m_reserver.reserve());
+            // Unreserve every 4th id right away, so that the freed ids get reused
+            if (i % 4 == 3) {
+                m_reserver.unreserve(ids.back());
+                ids.pop_back();
+            }
         }
-        for (auto t : threads) {
-            if (t.joinable()) t.join();
+    });
+
+    std::set< uint32_t > expected;
+    for (const auto& ids : thread_ids) {
+        for (const auto id : ids) {
+            ASSERT_TRUE(expected.insert(id).second) << "id=" << id << " reserved twice";
+            ASSERT_TRUE(m_reserver.is_reserved(id));
         }
     }
+    ASSERT_EQ(reserved_ids(m_reserver), expected);
 
-    struct IDReserverTest : public testing::Test {
-    public:
-        IDReserverTest(const IDReserverTest&) = delete;
-        IDReserverTest(IDReserverTest&&) noexcept = delete;
-        IDReserverTest& operator=(const IDReserverTest&) = delete;
-        IDReserverTest& operator=(IDReserverTest&&) noexcept = delete;
-        virtual ~IDReserverTest() override = default;
+    // Ids still cached by the threads are neither reserved nor persisted
+    IDReserver loaded{m_reserver.serialize()};
+    ASSERT_EQ(reserved_ids(loaded), expected);
+    for (const auto id : expected) {
+        ASSERT_TRUE(loaded.is_reserved(id));
+    }
+}
 
-    protected:
-        IDReserver m_reserver;
+TEST_F(IDReserverTest, ReserveSpecificID) {
+    // Large enough to have a few ids cached per thread
+    IDReserver reserver{4096};
+    const uint32_t first{reserver.reserve()};
+    ASSERT_TRUE(reserver.is_reserved(first));
+
+    // Ids after the first are pre-reserved in this thread's cache, reserving one of them takes it out of the cache
+    const uint32_t specific{first + 2};
+    ASSERT_FALSE(reserver.is_reserved(specific));
+    reserver.reserve(specific);
+    ASSERT_TRUE(reserver.is_reserved(specific));
+
+    std::set< uint32_t > ids{first, specific};
+    for (uint32_t i{0}; i < 200; ++i) {
+        ASSERT_TRUE(ids.insert(reserver.reserve()).second);
+    }
+    ASSERT_EQ(reserved_ids(reserver), ids);
 
-        void SetUp() override {}
-        void TearDown() override {}
-    };
+    reserver.unreserve(specific);
+    ids.erase(specific);
+    ASSERT_FALSE(reserver.is_reserved(specific));
+    IDReserver loaded{reserver.serialize()};
+    ASSERT_EQ(reserved_ids(loaded), ids);
 }
 
-TEST_F(IDReserverTest, RandomIDSet) {
-    run_parallel(g_num_threads, [&](int32_t n_ids_this_thread) {
-        LOGINFO("INFO: Setting alternate bits (set even and reset odd) in range[{} - {}]", start, start + count - 1);
-        for (auto i = 0; i < n_ids_this_thread; ++i) {
-            if (i % 2 == 0) { reserve(); }
-        }
-    });
+TEST_F(IDReserverTest, ReserveAfterSerialize) {
+    IDReserver reserver{4096};
+    std::set< uint32_t > ids{reserver.reserve()};
+
+    // Serializing leaves out the ids cached by this thread, but they stay pre-reserved and are handed out next
+    IDReserver loaded{reserver.serialize()};
+    ASSERT_EQ(reserved_ids(loaded), ids);
+    for (uint32_t i{0}; i < 8192; ++i) {
+        const uint32_t id{reserver.reserve()};
+        ASSERT_TRUE(ids.insert(id).second) << "id=" << id << " reserved twice";
+        ASSERT_TRUE(reserver.is_reserved(id));
+        if (i % 512 == 0) { reserver.serialize(); }
+    }
+    ASSERT_EQ(reserved_ids(reserver), ids);
 }
 
 int main(int argc, char* argv[]) {
-    SISL_OPTIONS_LOAD(argc, argv, logging, test_id_reserver);
-    ::testing::InitGoogleTest(&argc, argv);
+    int parsed_argc{argc};
+    ::testing::InitGoogleTest(&parsed_argc, argv);
+    SISL_OPTIONS_LOAD(parsed_argc, argv, logging, test_id_reserver);
     sisl::logging::SetLogger("test_id_reserver");
     spdlog::set_pattern("[%D %T%z] [%^%l%$] [%n] [%t] %v");
 
     g_max_ids = SISL_OPTIONS["max_ids"].as< uint32_t >();
     g_num_threads = SISL_OPTIONS["num_threads"].as< uint32_t >();
 
-    auto ret = RUN_ALL_TESTS();
+    const auto ret{RUN_ALL_TESTS()};
     return ret;
 }
@@ -0,0 +1,177 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include <gtest/gtest.h>
+
+#include "sisl/fds/bitset.hpp"
+#include "sisl/fds/segmented_bitset.hpp"
+
+using namespace sisl;
+
+SISL_LOGGING_INIT(test_segmented_bitset)
+RCU_REGISTER_INIT
+
+namespace {
+uint32_t g_num_threads;
+
+// Small segments, so that every operation crosses segment boundaries. It gets rounded up to 1024 bits.
+constexpr uint64_t SEGMENT_BITS{1000};
+
+void validate(const SegmentedBitset& sbset, const Bitset& bset) {
+    ASSERT_EQ(sbset.size(), bset.size());
+    ASSERT_EQ(sbset.get_set_count(), bset.get_set_count());
+    for (uint64_t bit{0}; bit < bset.size(); ++bit) {
+        ASSERT_EQ(sbset.get_bitval(bit), bset.get_bitval(bit)) << "bit=" << bit;
+    }
+    for (uint64_t bit{0}; bit < bset.size(); bit += 97) {
+        ASSERT_EQ(sbset.get_next_set_bit(bit), bset.get_next_set_bit(bit)) << "bit=" << bit;
+        ASSERT_EQ(sbset.get_next_reset_bit(bit), bset.get_next_reset_bit(bit)) << "bit=" << bit;
+        ASSERT_EQ(sbset.get_set_count(bit, bit + 3000), bset.get_set_count(bit, std::min(bit + 3000, bset.size() - 1)));
+    }
+}
+} // namespace
+
+TEST(SegmentedBitset, MatchesBitset) {
+    std::random_device rd{};
+    std::default_random_engine re{rd()};
+    std::uniform_int_distribution< uint64_t > len_rand{1, 2500};
+
+    // Sizes are kept word aligned, since Bitset retains the bits beyond size in the last partial word and they would
+    // show up on growing
+    SegmentedBitset sbset{5120, SEGMENT_BITS};
+    Bitset bset{5120};
+    ASSERT_EQ(sbset.segment_bits(), 1024u);
+    ASSERT_EQ(sbset.segment_count(), 5u);
+
+    const auto random_updates{[&]() {
+        std::uniform_int_distribution< uint64_t > bit_rand{0, bset.size() - 1};
+        for (uint32_t i{0}; i < 200; ++i) {
+            const uint64_t start{bit_rand(re)};
+            const uint64_t nbits{std::min(len_rand(re), bset.size() - start)};
+            if (i % 2) {
+                sbset.set_bits(start, nbits);
+                bset.set_bits(start, nbits);
+            } else {
+                sbset.reset_bits(start, nbits);
+                bset.reset_bits(start, nbits);
+            }
+        }
+    }};
+
+    random_updates();
+    validate(sbset, bset);
+
+    // Shrink head across a few segments, which drops them
+    sbset.shrink_head(2368);
+    bset.shrink_head(2368);
+    ASSERT_EQ(sbset.segment_count(), 3u);
+    validate(sbset, bset);
+
+    // Grow with set bits, shrink and grow back with reset bits
+    sbset.resize(9000, true);
+    bset.resize(9000, true);
+    validate(sbset, bset);
+    random_updates();
+    sbset.resize(3968);
+    bset.resize(3968);
+    validate(sbset, bset);
+    sbset.resize(6400, false);
+    bset.resize(6400, false);
+    validate(sbset, bset);
+
+    const auto b{sbset.get_next_contiguous_n_reset_bits(0, 50)};
+    if (b.nbits > 0) {
+        ASSERT_TRUE(bset.is_bits_reset(b.start_bit, 50));
+    } else {
+        ASSERT_EQ(b.start_bit, SegmentedBitset::npos);
+    }
+    ASSERT_TRUE(sbset.is_bits_reset(3968, 2432));
+    ASSERT_THROW(sbset.set_bits(6000, 401), std::out_of_range);
+    ASSERT_THROW(sbset.shrink_head(6401), std::out_of_range);
+}
+
+TEST(SegmentedBitset, BitOpsDuringResize) {
+    rcu_register_thread();
+    SegmentedBitset sbset{SEGMENT_BITS * 4, SEGMENT_BITS};
+    std::atomic< uint32_t > running{g_num_threads};
+
+    // Every thread owns every g_num_threads'th bit of the initial size and keeps flipping them while the bitset grows
+    std::vector< std::thread > threads;
+    for (uint32_t t{0}; t < g_num_threads; ++t) {
+        threads.emplace_back([&sbset, &running, t]() {
+            rcu_register_thread();
+            for (uint32_t round{0}; round < 20; ++round) {
+                const bool value{(round % 2) == 0};
+                for (uint64_t bit{t}; bit < SEGMENT_BITS * 4; bit += g_num_threads) {
+                    if (value) {
+                        sbset.set_bit(bit);
+                    } else {
+                        sbset.reset_bit(bit);
+                    }
+                    ASSERT_EQ(sbset.get_bitval(bit), value);
+                }
+            }
+            // Leave all the bits owned set
+            for (uint64_t bit{t}; bit < SEGMENT_BITS * 4; bit += g_num_threads) {
+                sbset.set_bit(bit);
+            }
+            --running;
+            rcu_unregister_thread();
+        });
+    }
+
+    uint64_t nsegments{4};
+    while (running.load() > 0) {
+        sbset.resize(SEGMENT_BITS * (++nsegments));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT_EQ(sbset.size(), SEGMENT_BITS * nsegments);
+    ASSERT_EQ(sbset.get_set_count(), SEGMENT_BITS * 4);
+    ASSERT_TRUE(sbset.is_bits_set(0, SEGMENT_BITS * 4));
+    ASSERT_EQ(sbset.get_next_set_bit(SEGMENT_BITS * 4), SegmentedBitset::npos);
+    rcu_unregister_thread();
+}
+
+SISL_OPTIONS_ENABLE(logging, test_segmented_bitset)
+
+SISL_OPTION_GROUP(test_segmented_bitset,
+                  (num_threads, "", "num_threads", "number of threads updating bits during resize",
+                   ::cxxopts::value< uint32_t >()->default_value("4"), "number"))
+
+int main(int argc, char* argv[]) {
+    int parsed_argc{argc};
+    ::testing::InitGoogleTest(&parsed_argc, argv);
+    SISL_OPTIONS_LOAD(parsed_argc, argv, logging, test_segmented_bitset);
+    sisl::logging::SetLogger("test_segmented_bitset");
+    spdlog::set_pattern("[%D %T%z] [%^%l%$] [%n] [%t] %v");
+
+    g_num_threads = SISL_OPTIONS["num_threads"].as< uint32_t >();
+
+    const auto ret{RUN_ALL_TESTS()};
+    return ret;
+}
@@ -0,0 +1,211 @@
+/*********************************************************************************
+ * Modifications Copyright 2017-2019 eBay Inc.
+ *
+ * Author/Developer(s): Harihara Kadayam
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *    https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software distributed
+ * under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations under the License.
+ *
+ *********************************************************************************/
+#include <cstdint>
+#include <random>
+
+#include <sisl/logging/logging.h>
+#include <sisl/options/options.h>
+
+#include <gtest/gtest.h>
+
+#include "sisl/fds/bitset.hpp"
+#include "sisl/fds/sparse_bitset.hpp"
+
+using namespace sisl;
+
+SISL_LOGGING_INIT(test_sparse_bitset)
+
+namespace {
+uint32_t g_num_iters;
+
+// Runs the same operations on a SparseBitset and a dense Bitset and compares the query results
+class SparseBitsetTest : public testing::Test {
+protected:
+    std::unique_ptr< SparseBitset > m_sparse;
+    std::unique_ptr< Bitset > m_dense;
+    std::random_device m_rd{};
+    std::default_random_engine m_re{m_rd()};
+
+public:
+    SparseBitsetTest() : testing::Test() {}
+    SparseBitsetTest(const SparseBitsetTest&) = delete;
+    SparseBitsetTest(SparseBitsetTest&&) noexcept = delete;
+    SparseBitsetTest& operator=(const SparseBitsetTest&) = delete;
+    SparseBitsetTest& operator=(SparseBitsetTest&&) noexcept = delete;
+    virtual ~SparseBitsetTest() override = default;
+
+protected:
+    void init(const uint64_t nbits) {
+        m_sparse = std::make_unique< SparseBitset >(nbits);
+        m_dense = std::make_unique< Bitset >(nbits);
+    }
+
+    void set_reset(const bool value, const uint64_t start, const uint64_t nbits) {
+        if (value) {
+            m_sparse->set_bits(start, nbits);
+            m_dense->set_bits(start, nbits);
+        } else {
+            m_sparse->reset_bits(start, nbits);
+            m_dense->reset_bits(start, nbits);
+        }
+    }
+
+    // Random updates of sizes ranging from single bits to multiple chunks, biased towards value
+    void random_updates(const uint32_t count, const uint32_t set_pct) {
+        const uint64_t nbits{m_dense->size()};
+        std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+        std::uniform_int_distribution< uint32_t > pct_rand{0, 99};
+        std::uniform_int_distribution< uint32_t > shift_rand{0, 18};
+        for (uint32_t i{0}; i < count; ++i) {
+            const uint64_t start{bit_rand(m_re)};
+            const uint64_t len{std::min(std::uniform_int_distribution< uint64_t >{
+                                            1, uint64_t{1} << shift_rand(m_re)}(m_re),
+                                        nbits - start)};
+            set_reset(pct_rand(m_re) < set_pct, start, len);
+        }
+    }
+
+    void validate() {
+        const uint64_t nbits{m_dense->size()};
+        ASSERT_EQ(m_sparse->size(), nbits);
+        ASSERT_EQ(m_sparse->get_set_count(), m_dense->get_set_count());
+
+        std::uniform_int_distribution< uint64_t > bit_rand{0, nbits - 1};
+        std::uniform_int_distribution< uint32_t > n_rand{1, 300};
+        for (uint32_t i{0}; i < 1000; ++i) {
+            const uint64_t bit{bit_rand(m_re)};
+            ASSERT_EQ(m_sparse->get_bitval(bit), m_dense->get_bitval(bit)) << "bit=" << bit;
+            ASSERT_EQ(m_sparse->get_next_set_bit(bit), m_dense->get_next_set_bit(bit)) << "bit=" << bit;
+            ASSERT_EQ(m_sparse->get_next_reset_bit(bit), m_dense->get_next_reset_bit(bit)) << "bit=" << bit;
+
+            const uint64_t end_bit{std::min(bit + bit_rand(m_re) / 8, nbits - 1)};
+            ASSERT_EQ(m_sparse->get_set_count(bit, end_bit), m_dense->get_set_count(bit, end_bit));
+
+            // Dense bitset does not guarantee the first fit, so check the run returned is reset and nothing before it
+            // qualifies
+            const uint32_t n{n_rand(m_re)};
+            const auto b{m_sparse->get_next_contiguous_n_reset_bits(bit, n)};
+            const auto db{m_dense->get_next_contiguous_n_reset_bits(bit, n)};
+            ASSERT_EQ(b.nbits == 0, db.nbits == 0) << "bit=" << bit << " n=" << n;
+            if (b.nbits > 0) {
+                ASSERT_EQ(b.nbits, n);
+                ASSERT_TRUE(m_dense->is_bits_reset(b.start_bit, b.nbits));
+                ASSERT_LE(b.start_bit, db.start_bit);
+            }
+        }
+    }
+};
+} // namespace
+
+TEST_F(SparseBitsetTest, RandomSparse) {
+    init(SparseBitset::chunk_bits() * 16 + 1234);
+    random_updates(g_num_iters, 55);
+    validate();
+    random_updates(g_num_iters, 30);
+    validate();
+}
+
+TEST_F(SparseBitsetTest, RandomDense) {
+    init(SparseBitset::chunk_bits() * 8 + 77);
+    m_sparse->set_bits(0, m_sparse->size());
+    m_dense->set_bits(0, m_dense->size());
+    random_updates(g_num_iters, 45);
+    validate();
+    m_sparse->run_optimize();
+    validate();
+}
+
+TEST_F(SparseBitsetTest, ContainerTransitions) {
+    init(SparseBitset::chunk_bits() * 4);
+    const uint64_t empty_mem{m_sparse->memory_usage()};
+
+    // Scattered bits across the array -> bitmap threshold and back
+    for (uint64_t bit{0}; bit < SparseBitset::chunk_bits(); bit += 7) {
+        set_reset(true, bit, 1);
+    }
+    validate();
+    for (uint64_t bit{0}; bit < SparseBitset::chunk_bits(); bit += 14) {
+        set_reset(false, bit, 1);
+    }
+    validate();
+
+    // Mostly set chunk with few holes is kept as runs
+    set_reset(true, SparseBitset::chunk_bits(), SparseBitset::chunk_bits() * 2);
+    for (uint64_t bit{SparseBitset::chunk_bits() + 5}; bit < SparseBitset::chunk_bits() * 3; bit += 10000) {
+        set_reset(false, bit, 1);
+    }
+    m_sparse->run_optimize();
+    validate();
+    ASSERT_LT(m_sparse->memory_usage(), empty_mem + SparseBitset::chunk_bits() / 8 + 1024);
+
+    // Everything reset drops all the chunks
+    set_reset(false, 0, m_sparse->size());
+    ASSERT_EQ(m_sparse->get_set_count(), 0u);
+    ASSERT_EQ(m_sparse->get_next_set_bit(0), SparseBitset::npos);
+    ASSERT_EQ(m_sparse->serialized_size(), SparseBitset{}.serialized_size());
+}
+
+TEST_F(SparseBitsetTest, SerializeResize) {
+    init(SparseBitset::chunk_bits() * 10 + 3);
+    random_updates(g_num_iters, 50);
+    m_sparse->set_id(12);
+
+    const SparseBitset loaded{m_sparse->serialize(512)};
+    ASSERT_EQ(loaded.get_id(), 12u);
+    ASSERT_EQ(loaded.size(), m_sparse->size());
+    for (uint64_t bit{0}; bit < m_sparse->size();) {
+        const uint64_t next{m_sparse->get_next_set_bit(bit)};
+        ASSERT_EQ(loaded.get_next_set_bit(bit), next);
+        if (next == SparseBitset::npos) { break; }
+        const uint64_t next_reset{m_sparse->get_next_reset_bit(next)};
+        ASSERT_EQ(loaded.get_next_reset_bit(next), next_reset);
+        if (next_reset == SparseBitset::npos) { break; }
+        bit = next_reset;
+    }
+
+    // Shrink and grow back with bits set. Shrink to a word boundary, since dense bitset retains the bits beyond size in
+    // the last partial word and they would show up on growing back
+    const uint64_t nbits{m_sparse->size()};
+    const uint64_t shrunk_nbits{(nbits / 3) & ~uint64_t{63}};
+    m_sparse->resize(shrunk_nbits);
+    m_dense->resize(shrunk_nbits);
+    validate();
+    m_sparse->resize(nbits, true);
+    m_dense->resize(nbits, true);
+    validate();
+
+    ASSERT_THROW(m_sparse->set_bits(nbits - 1, 2), std::out_of_range);
+}
+
+SISL_OPTIONS_ENABLE(logging, test_sparse_bitset)
+
+SISL_OPTION_GROUP(test_sparse_bitset,
+                  (num_iters, "", "num_iters", "number of random updates per round",
+                   ::cxxopts::value< uint32_t >()->default_value("2000"), "number"))
+
+int main(int argc, char* argv[]) {
+    int parsed_argc{argc};
+    ::testing::InitGoogleTest(&parsed_argc, argv);
+    SISL_OPTIONS_LOAD(parsed_argc, argv, logging, test_sparse_bitset);
+    sisl::logging::SetLogger("test_sparse_bitset");
+    spdlog::set_pattern("[%D %T%z] [%^%l%$] [%n] [%t] %v");
+
+    g_num_iters = SISL_OPTIONS["num_iters"].as< uint32_t >();
+
+    const auto ret{RUN_ALL_TESTS()};
+    return ret;
+}